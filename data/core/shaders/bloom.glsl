@@ -0,0 +1,17 @@
+// Renderer post-processing function, see
+// Renderer::PostProcessingFootprint::PIXEL_BARRIER
+
+// half resolution, see AbstractMainWin::getPostProcessingUniformTextures
+layout (binding = 2) uniform sampler2D highlumtex;
+
+vec4 postprocess(vec4 result, ivec2 pixel)
+{
+	vec2 uv = (vec2(pixel) + 0.5) / vec2(imageSize(dataIn));
+	result.rgb += texture(highlumtex, uv).rgb;
+	float m = max(max(result.r, result.g), result.b);
+	if(m > 1.0)
+	{
+		result.rgb /= m;
+	}
+	return result;
+}
@@ -0,0 +1,16 @@
+// Transforms uploaded by GLHandler::setUpTransforms, from each
+// GLHandler::GeometricSpace to clip space. Shared by all programs, they don't
+// need any per draw uniform.
+layout(std140) uniform CameraTransforms
+{
+	mat4 fullTransform;
+	mat4 fullEyeSpaceTransform;
+	mat4 fullCameraSpaceTransform;
+	mat4 fullSeatedTrackedSpaceTransform;
+	mat4 fullStandingTrackedSpaceTransform;
+	mat4 fullHmdSpaceTransform;
+	mat4 fullSkyboxSpaceTransform;
+	// MainRenderTarget::Projection points are projected to (0 if none),
+	// target width and height, see projection.glsl
+	vec4 directProjection;
+};
@@ -1,11 +1,5 @@
-#version 420 core
-#extension GL_ARB_compute_shader : enable
-
-layout (local_size_x = LOCAL_SIZE_2D_X, local_size_y = LOCAL_SIZE_2D_Y) in;
-
-// An image to store data into.
-layout (rgba32f, binding = 0) readonly uniform image2D dataIn;
-layout (rgba32f, binding = 1) writeonly uniform image2D dataOut;
+// Renderer post-processing function, see
+// Renderer::PostProcessingFootprint::PIXEL
 
 uniform float gamma;
 uniform float contrast = 1.0;
@@ -20,28 +14,21 @@ const int bayer_pattern[64]
             51, 19, 59, 27, 49, 17, 57, 25, 15, 47, 7, 39, 13, 45, 5, 37, 63,
             31, 55, 23, 61, 29, 53, 21);
 
-vec4 dither()
+vec4 dither(ivec2 pixel)
 {
-	int x = int(mod(round(float(gl_GlobalInvocationID.x) / 1.5), 8.0));
-	int y = int(mod(round(float(gl_GlobalInvocationID.y) / 1.5), 8.0));
+	int x = int(mod(round(float(pixel.x) / 1.5), 8.0));
+	int y = int(mod(round(float(pixel.y) / 1.5), 8.0));
 	return vec4(bayer_pattern[x + 8 * y] / (32.0 * 256.0) - (1.0 / 128.0));
 }
 #endif
 
-float max3(vec3 v)
-{
-	return max(max(v.x, v.y), v.z);
-}
-
-void main()
+vec4 postprocess(vec4 result, ivec2 pixel)
 {
-	ivec2 pixel_coords = ivec2(gl_GlobalInvocationID.xy);
-	vec4 result = imageLoad(dataIn, pixel_coords);
 	/*
 	// reinhard tone mapping
 	result.rgb = result.rgb / (result.rgb + vec3(1.0));
 	*/
-	float m = max3(result.rgb);
+	float m = max(max(result.r, result.g), result.b);
 	if(m > 1.0)
 	{
 		result.rgb /= m;
@@ -50,14 +37,14 @@ void main()
 
 #ifdef DITHERING
 	// dithering to remove banding
-	result += dither();
+	result += dither(pixel);
 #endif
 
 	// contrast
 	result.rgb
 	    = clamp(contrast * (result.rgb - 0.5) + 0.5, vec3(0.0), vec3(1.0));
 
-	result.a   = 1.0;
+	result.a = 1.0;
 
-	imageStore(dataOut, pixel_coords, result);
+	return result;
 }
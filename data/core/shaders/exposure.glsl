@@ -1,11 +1,5 @@
-#version 420 core
-#extension GL_ARB_compute_shader : enable
-
-layout (local_size_x = LOCAL_SIZE_2D_X, local_size_y = LOCAL_SIZE_2D_Y) in;
-
-// An image to store data into.
-layout (rgba32f, binding = 0) readonly uniform image2D dataIn;
-layout (rgba32f, binding = 1) writeonly uniform image2D dataOut;
+// Renderer post-processing function, see
+// Renderer::PostProcessingFootprint::PIXEL
 
 uniform float exposure;
 uniform float dynamicrange       = 10000.0;
@@ -13,10 +7,8 @@ uniform float screendynamicrange = 255.0;
 uniform float purkinje           = 1.0;
 
 // technically tone mapping
-void main()
+vec4 postprocess(vec4 result, ivec2 pixel)
 {
-	ivec2 pixel_coords = ivec2(gl_GlobalInvocationID.xy);
-	vec4 result             = imageLoad(dataIn, pixel_coords);
 	if(dynamicrange > 1.0)
 	{
 		// vec3 grayscale = vec3(0.299, 0.587, 0.114); // photopic
@@ -43,16 +35,9 @@ void main()
 		result.rgb = pow(result.rgb, vec3(b));
 	}
 
-	if(result.r < 0.5 / 255.0 && result.g < 0.5 / 255.0
-	   && result.b < 0.5 / 255.0)
-	{
-		imageStore(dataOut, pixel_coords, result);
-		return;
-	}
-
 	/*float screenminvalue=0.0/255.0;
 	result.rgb *= 1.0 - screenminvalue;
 	result.rgb +=screenminvalue;*/
 
-	imageStore(dataOut, pixel_coords, result);
+	return result;
 }
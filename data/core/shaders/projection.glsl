@@ -0,0 +1,77 @@
+// Projects points straight to panorama and dome master targets, without
+// rendering a cube map first (see Renderer::RenderPath::directProjection).
+// In this case the camera matrices transform to eye space instead of clip
+// space. Needs camera.glsl.
+
+const float projectionPi = 3.14159265359;
+
+// MainRenderTarget::Projection values
+const int projectionPanorama360   = 1;
+const int projectionDomeMaster180 = 3;
+
+// pos transformed by the camera matrix to clip space, same mappings as
+// panorama360.frag and domemaster180.frag
+vec4 projectDirect(vec4 pos)
+{
+	int projection = int(directProjection.x);
+	if(projection != projectionPanorama360
+	   && projection != projectionDomeMaster180)
+	{
+		return pos;
+	}
+
+	vec3 dir   = pos.xyz / pos.w;
+	float dist = length(dir);
+	dir /= dist;
+
+	vec2 xy;
+	if(projection == projectionPanorama360)
+	{
+		// equirectangular
+		xy = vec2(atan(dir.x, -dir.z), asin(dir.y) * 2.0) / projectionPi;
+	}
+	else
+	{
+		// equidistant fisheye, zenith along -z
+		float r = acos(clamp(-dir.z, -1.0, 1.0)) * 2.0 / projectionPi;
+		if(r > 1.0)
+		{
+			// behind the dome, outside of the clip volume
+			return vec4(2.0, 2.0, 0.0, 1.0);
+		}
+		float l = length(dir.xy);
+		xy      = l > 0.0 ? r * dir.xy / l : vec2(0.0);
+	}
+
+	// same depth as the cube map faces 0.1 to 10000 perspective
+	const float near = 0.1;
+	const float far  = 10000.0;
+	float depth = (far + near) / (far - near)
+	              - 2.0 * far * near / ((far - near) * dist);
+	return vec4(xy, depth, 1.0);
+}
+
+// solid angle of the pixel pos (transformed by the camera matrix) is drawn
+// on, pixelSolidAngle if it isn't projected directly
+float projectedPixelSolidAngle(vec4 pos, float pixelSolidAngle)
+{
+	int projection = int(directProjection.x);
+	if(projection != projectionPanorama360
+	   && projection != projectionDomeMaster180)
+	{
+		return pixelSolidAngle;
+	}
+
+	vec3 dir  = normalize(pos.xyz / pos.w);
+	vec2 size = directProjection.yz;
+	if(projection == projectionPanorama360)
+	{
+		// 2pi x pi over the target, pixels shrink towards the poles
+		float coslat = max(sqrt(max(0.0, 1.0 - dir.y * dir.y)), 1.0 / size.y);
+		return 2.0 * projectionPi * projectionPi * coslat / (size.x * size.y);
+	}
+	// pi over the dome diameter, pixels shrink away from the zenith
+	float theta = acos(clamp(-dir.z, -1.0, 1.0));
+	float ratio = theta > 1.0e-4 ? sin(theta) / theta : 1.0;
+	return projectionPi * projectionPi * ratio / (size.x * size.y);
+}
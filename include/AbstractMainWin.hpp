@@ -25,7 +25,9 @@
 #include "ShaderProgram.hpp"
 #include "ToneMappingModel.hpp"
 #include "gl/GLHandler.hpp"
+#include "gl/GLProfiler.hpp"
 #include "gl/GLShaderProgram.hpp"
+#include "profiling.hpp"
 #include "vr/OpenVRHandler.hpp"
 #include "vr/StereoBeamerHandler.hpp"
 
@@ -69,6 +71,20 @@
  * accessed.
  * * #~AbstractMainWin : <code>cleanUpScene()</code>
  *
+ * These functions are looked up once and called directly (see
+ * @ref PythonQtHandler::callHook), scripts aren't parsed each frame. They
+ * are looked up again after any script evaluation, so functions defined
+ * later (from the console for example) are also called.
+ *
+ * Work that doesn't need to be done every frame (scene logic, show
+ * scripting) can be done in the Python function
+ * <code>tickScene(float elapsed)</code> instead of @e updateScene, which gets
+ * called scripting/tickrate times per second with the time elapsed since its
+ * last call. The time spent in each Python function is shown in the GPU
+ * profiler overlay and a warning is logged when they take longer than the
+ * scripting/framebudget setting during a frame (see
+ * @ref PythonQtHandler::endFrame).
+ *
  * TODO (florian) rewrite
  * @par Post-processing
  *
@@ -140,6 +156,19 @@ class AbstractMainWin : public QWindow
 	 * @brief Gamma value to use for gamma correction.
 	 */
 	Q_PROPERTY(float gamma MEMBER gamma)
+	/**
+	 * @brief Wether each rendered frame is pushed to the video sink or not.
+	 */
+	Q_PROPERTY(bool videomode MEMBER videomode)
+	/**
+	 * @brief Wether frames are rendered in offline mode or not.
+	 *
+	 * In offline mode, frameTiming is fixed to 1/window/videofps instead of
+	 * the real frame time and each frame waits for the scene to be fully
+	 * loaded (see isSceneSettled()), so that recordings are reproducible.
+	 * Frames are rendered as fast as possible.
+	 */
+	Q_PROPERTY(bool offlinemode MEMBER offlinemode)
 
   public:
 	/**
@@ -272,6 +301,83 @@ class AbstractMainWin : public QWindow
 	 *
 	 */
 	void takeScreenshot(QString path = "") const;
+	/**
+	 * @brief Returns the value of the setting @p key ("group/name").
+	 */
+	QVariant getSetting(QString const& key) const
+	{
+		return SettingsSnapshot::current().value(key);
+	};
+	/**
+	 * @brief Sets the setting @p key ("group/name") to @p value.
+	 *
+	 * Settings only read at initialization apply on next launch.
+	 */
+	void setSetting(QString const& key, QVariant const& value);
+	/**
+	 * @brief Shows or hides the GPU time of each render path and pass,
+	 * averaged over the last frames (see GLProfiler).
+	 */
+	void toggleGPUProfiler() { renderer.toggleGPUProfilerOverlay(); };
+	/**
+	 * @brief Writes the GPU times shown by toggleGPUProfiler to the CSV file
+	 * @p path.
+	 *
+	 * Returns false if the file couldn't be written.
+	 */
+	bool exportGPUProfile(QString const& path) const
+	{
+		return GLProfiler::exportToFile(path);
+	};
+	/**
+	 * @brief Starts recording the CPU time of the main zones of code on every
+	 * thread (see CPUProfiler).
+	 */
+	void startCPUTrace() { CPUProfiler::setEnabled(true); };
+	/**
+	 * @brief Stops recording, the recorded events can still be dumped.
+	 */
+	void stopCPUTrace() { CPUProfiler::setEnabled(false); };
+	/**
+	 * @brief Writes the recorded CPU zones to @p path as Chrome trace JSON.
+	 *
+	 * Returns false if the file couldn't be written.
+	 */
+	bool dumpCPUTrace(QString const& path) const
+	{
+		return CPUProfiler::dumpChromeTrace(path);
+	};
+	/**
+	 * @brief Starts recording a CPU trace, or stops it and dumps it in the
+	 * documents directory.
+	 */
+	void toggleCPUTrace();
+	/**
+	 * @brief Returns the frames written by the current (or last) video mode
+	 * recording.
+	 */
+	unsigned int getVideoWrittenFrames() const { return videoStats.written; };
+	/**
+	 * @brief Returns the frames the current (or last) video mode recording
+	 * dropped, because its queue was full or they couldn't be written.
+	 */
+	unsigned int getVideoDroppedFrames() const { return videoStats.dropped; };
+	/**
+	 * @brief Returns the average frames per second written by the current (or
+	 * last) video mode recording.
+	 */
+	float getVideoFramesPerSecond() const
+	{
+		return videoStats.framesPerSecond;
+	};
+	/**
+	 * @brief Returns the average megabytes per second written by the current
+	 * (or last) video mode recording.
+	 */
+	float getVideoMegabytesPerSecond() const
+	{
+		return videoStats.megabytesPerSecond;
+	};
 
   protected:
 	/**
@@ -438,9 +544,21 @@ class AbstractMainWin : public QWindow
 	 */
 	float gamma = 2.2f;
 
+	/**
+	 * @brief Returns false while the scene still streams data it will render
+	 * at the current instant.
+	 *
+	 * In offline mode, a frame is rendered again for the same instant until
+	 * this returns true. Default implementation returns true.
+	 */
+	virtual bool isSceneSettled() { return true; };
+
 	// OFFSCREEN RENDERING
 	bool videomode                 = false;
+	bool offlinemode               = false;
 	unsigned int currentVideoFrame = 0;
+	// see FrameSink::fromSettings
+	FrameSink* videoSink = nullptr;
 
 	// Postprocessing
 	ToneMappingModel* toneMappingModel = nullptr;
@@ -454,15 +572,27 @@ class AbstractMainWin : public QWindow
 
 	float frameTiming_ = 0.f;
 	QElapsedTimer frameTimer;
+	// towards the next tickScene Python call, and since the last one
+	float scriptTickTime    = 0.f;
+	float scriptTickElapsed = 0.f;
 
 	QOpenGLContext m_context;
 	bool initialized = false;
 	bool reloadPy    = false;
 
+	// last stats of videoSink, kept after it is closed
+	FrameSink::Stats videoStats;
+	void closeVideoSink();
+
 	// BLOOM
 	bool bloom = QSettings().value("graphics/bloom").toBool();
-	std::array<GLFramebufferObject*, 2> bloomTargets = {{nullptr, nullptr}};
+	// half, quarter and eighth resolution
+	std::vector<GLFramebufferObject*> bloomTargets;
+	GLComputeShader* bloomHighLumShader = nullptr;
+	GLComputeShader* bloomDownShader    = nullptr;
+	GLComputeShader* bloomUpShader      = nullptr;
 	void reloadBloomTargets();
+	void cleanBloom();
 };
 
 template <class T>
@@ -475,18 +605,4 @@ void AbstractMainWin::initLibrary()
 	lib.setupPythonAPI();
 }
 
-class ImageWriter : public QRunnable
-{
-	QString filename;
-	QImage img;
-
-  public:
-	ImageWriter(QString filename, QImage img)
-	    : filename(filename)
-	    , img(img)
-	{
-	}
-	void run() override { img.save(filename); }
-};
-
 #endif // ABSTRACTMAINWIN_H
@@ -24,6 +24,7 @@
 #include <cstring>
 
 #include "gl/GLHandler.hpp"
+#include "profiling.hpp"
 
 // TODO(florian) when Qt 5.10 is available, use QThread::create
 namespace at
@@ -56,6 +57,7 @@ class WorkerThread : public QThread
 	unsigned int height = 0;
 	void run() override
 	{
+		CPUProfiler::Zone zone("texture decoding");
 		QImageReader imReader(path);
 		if(resize)
 		{
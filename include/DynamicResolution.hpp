@@ -0,0 +1,98 @@
+/*
+    Copyright (C) 2020 Florian Cabot <florian.cabot@hotmail.fr>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef DYNAMICRESOLUTION_HPP
+#define DYNAMICRESOLUTION_HPP
+
+#include <QSize>
+#include <array>
+
+#include "gl/GLHandler.hpp"
+
+/**
+ * @brief Adapts the scene rendering resolution to hold a GPU frame time
+ * budget.
+ *
+ * The GPU time of each frame is measured with GL_TIME_ELAPSED queries, read
+ * back a few frames later without stalling the pipeline (like
+ * LuminanceMeter). As rendering cost is roughly proportional to the pixels
+ * count, the render scale (of each dimension) is then multiplied by
+ * sqrt(budget / time), damped, clamped between graphics/minrenderscale and 1
+ * and quantized so that it only changes by noticeable steps : resources
+ * sized after the rendering viewport don't get reallocated every frame.
+ *
+ * The scene target is still allocated at full size, only its viewport
+ * shrinks (see Renderer).
+ */
+class DynamicResolution
+{
+  public:
+	DynamicResolution();
+	DynamicResolution(DynamicResolution const& other) = delete;
+	DynamicResolution& operator=(DynamicResolution const& other) = delete;
+	/**
+	 * @brief Whether the scale adapts or stays at 1, from
+	 * graphics/dynamicresolution by default.
+	 */
+	bool isEnabled() const { return enabled; };
+	void setEnabled(bool enabled);
+	/**
+	 * @brief Starts measuring the GPU time of the current frame, after
+	 * reading the oldest measure if it is ready.
+	 */
+	void beginFrame();
+	/**
+	 * @brief Stops measuring the GPU time of the current frame.
+	 */
+	void endFrame();
+	/**
+	 * @brief Returns the current render scale of each dimension.
+	 */
+	float getScale() const { return scale; };
+	/**
+	 * @brief Returns @p size scaled by getScale(), at least 1x1.
+	 */
+	QSize scaledSize(QSize const& size) const;
+	/**
+	 * @brief Returns the last GPU frame time read back in milliseconds, 0 if
+	 * none is available yet.
+	 */
+	float getLastFrameTime() const { return lastFrameTime; };
+	~DynamicResolution();
+
+  private:
+	// number of frames a measure can stay in flight
+	static const unsigned int latency = 3;
+
+	std::array<GLuint, latency> queries = {};
+	std::array<bool, latency> pending   = {};
+	unsigned int frame                  = 0;
+	// the current frame is measured
+	bool measuring = false;
+
+	bool enabled;
+	// in milliseconds
+	float budget;
+	float minScale;
+	float scale         = 1.f;
+	float lastFrameTime = 0.f;
+
+	void update(float frameTime);
+};
+
+#endif // DYNAMICRESOLUTION_HPP
@@ -0,0 +1,115 @@
+/*
+    Copyright (C) 2020 Florian Cabot <florian.cabot@hotmail.fr>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef FRAMECAPTURE_HPP
+#define FRAMECAPTURE_HPP
+
+#include <QImage>
+#include <QRunnable>
+#include <QSemaphore>
+#include <memory>
+#include <vector>
+
+#include "FrameSink.hpp"
+#include "gl/GLBuffer.hpp"
+#include "gl/GLFramebufferObject.hpp"
+
+/**
+ * @brief Hands frames to a FrameSink without stalling the rendering.
+ *
+ * Each captured frame is read back into one of a ring of pixel pack buffers,
+ * followed by a fence. Once the GPU signaled the fence (usually one or two
+ * frames later), the buffer is mapped and a worker thread of the global
+ * QThreadPool copies it flipped into a QImage. The buffer is then unmapped
+ * and the image pushed to its sink, in capture order.
+ *
+ * The rendering thread only waits if all the buffers are still in flight
+ * when a new frame is captured, or if the sink applies backpressure.
+ */
+class FrameCapture
+{
+  public:
+	/**
+	 * @brief Constructs a capture of at most @p depth frames in flight.
+	 */
+	explicit FrameCapture(unsigned int depth = 3);
+	FrameCapture(FrameCapture const& other) = delete;
+	FrameCapture& operator=(FrameCapture const& other) = delete;
+	/**
+	 * @brief Queues the readback of @p target color buffer, which will be
+	 * pushed to @p sink named @p name.
+	 */
+	void capture(GLFramebufferObject const& target, FrameSink& sink,
+	             QString const& name);
+	/**
+	 * @brief Hands the frames read back by the GPU to the worker threads and
+	 * pushes the copied ones to their sink. Only waits for the sinks.
+	 *
+	 * Should be called once per frame.
+	 */
+	void update();
+	/**
+	 * @brief Waits until all the captured frames are pushed to their sink.
+	 */
+	void flush();
+	~FrameCapture();
+
+  private:
+	enum class State
+	{
+		FREE,
+		READING, // waiting for the GPU
+		COPYING, // mapped, waiting for a worker thread
+	};
+
+	struct Slot
+	{
+		Slot()
+		    : buffer(GL_PIXEL_PACK_BUFFER){};
+		GLBuffer buffer;
+		GLsync fence = nullptr;
+		State state  = State::FREE;
+		QSize size;
+		FrameSink* sink = nullptr;
+		QString name;
+		QImage image;
+		// released by the worker thread once done with the mapped buffer
+		QSemaphore copied;
+	};
+
+	class Copier : public QRunnable
+	{
+	  public:
+		Copier(Slot& slot, uchar const* data)
+		    : slot(slot)
+		    , data(data){};
+		void run() override;
+
+	  private:
+		Slot& slot;
+		uchar const* data;
+	};
+
+	std::vector<std::unique_ptr<Slot>> slots;
+	unsigned int next = 0;
+
+	// returns false if the slot isn't free yet and wait is false
+	static bool advance(Slot& slot, bool wait);
+};
+
+#endif // FRAMECAPTURE_HPP
@@ -0,0 +1,206 @@
+/*
+    Copyright (C) 2020 Florian Cabot <florian.cabot@hotmail.fr>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef FRAMESINK_HPP
+#define FRAMESINK_HPP
+
+#include <QElapsedTimer>
+#include <QImage>
+#include <QMutex>
+#include <QProcess>
+#include <QThread>
+#include <QWaitCondition>
+#include <deque>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Writes captured frames from its own threads (see FrameCapture).
+ *
+ * Frames are pushed into a bounded queue. When it is full, push() either
+ * waits for a consumer thread, so that the capture and ultimately the
+ * rendering slow down to the sink speed, or drops the frame.
+ *
+ * Subclasses implement write(), call start() at the end of their constructor
+ * and close() at the beginning of their destructor.
+ */
+class FrameSink
+{
+  public:
+	struct Stats
+	{
+		unsigned int written = 0;
+		// queue was full or frame couldn't be written
+		unsigned int dropped = 0;
+		// since the first frame was pushed
+		float framesPerSecond    = 0.f;
+		float megabytesPerSecond = 0.f;
+	};
+
+	FrameSink(FrameSink const& other) = delete;
+	FrameSink& operator=(FrameSink const& other) = delete;
+	/**
+	 * @brief Queues @p frame, named @p name (without extension).
+	 *
+	 * Thread-safe. Returns false if the frame was dropped.
+	 */
+	bool push(QImage const& frame, QString const& name);
+	Stats getStats() const;
+	/**
+	 * @brief Writes the remaining queued frames and stops the consumer
+	 * threads. Further pushed frames are dropped.
+	 */
+	void close();
+	virtual ~FrameSink() = default;
+
+	/**
+	 * @brief Creates the sink chosen in the window/video* settings, writing
+	 * into @p dir frames of size @p size.
+	 */
+	static FrameSink* fromSettings(QString const& dir, QSize const& size);
+
+  protected:
+	FrameSink(unsigned int queueSize, bool dropWhenFull);
+	void start(unsigned int threadsCount);
+	/**
+	 * @brief Writes @p frame, returns the written bytes count or -1 on error.
+	 *
+	 * Called concurrently if there is more than one consumer thread.
+	 */
+	virtual qint64 write(QImage const& frame, QString const& name) = 0;
+	/**
+	 * @brief Called by each consumer thread before it exits.
+	 */
+	virtual void finish(){};
+
+  private:
+	class Consumer : public QThread
+	{
+	  public:
+		explicit Consumer(FrameSink& sink)
+		    : sink(sink){};
+
+	  private:
+		FrameSink& sink;
+		void run() override;
+	};
+
+	struct Frame
+	{
+		QImage image;
+		QString name;
+	};
+
+	unsigned int queueSize;
+	bool dropWhenFull;
+
+	mutable QMutex mutex;
+	QWaitCondition notFull;
+	QWaitCondition notEmpty;
+	std::deque<Frame> queue;
+	bool closing = false;
+	std::vector<std::unique_ptr<Consumer>> consumers;
+
+	Stats stats;
+	qint64 bytes = 0;
+	QElapsedTimer timer;
+
+	void consume();
+};
+
+/**
+ * @brief Writes each frame as an image file, encoded by several threads.
+ *
+ * PNG files use the fastest zlib compression level. QOI files (see
+ * https://qoiformat.org) are about as small and many times faster to encode.
+ */
+class ImageSequenceSink : public FrameSink
+{
+  public:
+	enum class Format
+	{
+		PNG,
+		QOI,
+	};
+
+	ImageSequenceSink(QString const& dir, Format format,
+	                  unsigned int queueSize, bool dropWhenFull);
+	static QByteArray encodeQOI(QImage const& image);
+	~ImageSequenceSink();
+
+  protected:
+	qint64 write(QImage const& frame, QString const& name) override;
+
+  private:
+	QString dir;
+	Format format;
+};
+
+/**
+ * @brief Streams uncompressed frames to the standard input of an external
+ * encoder process, such as ffmpeg.
+ *
+ * In @p command, %w, %h and %r are replaced by the frames width, height and
+ * rate. Y4M streams describe themselves (e.g. "ffmpeg -y -i - video.mp4"),
+ * raw RGBA ones don't (e.g. "ffmpeg -y -f rawvideo -pix_fmt rgba -s %wx%h -r
+ * %r -i - video.mp4").
+ */
+class PipeSink : public FrameSink
+{
+  public:
+	enum class Format
+	{
+		// YUV 4:4:4 with BT.709 coefficients, limited range. Y4M headers can
+		// signal the range (XCOLORRANGE) but not the matrix : tell the
+		// encoder, e.g. with ffmpeg's "-colorspace bt709".
+		Y4M,
+		RAW, // RGBA8
+	};
+
+	PipeSink(QString const& command, QString const& workingDir, Format format,
+	         QSize const& size, unsigned int fps, unsigned int queueSize,
+	         bool dropWhenFull);
+	/**
+	 * @brief Encodes @p frame as a Y4M frame (marker and planar Y, Cb, Cr)
+	 * into @p out.
+	 *
+	 * @p out is resized, not reallocated when its capacity suffices.
+	 */
+	static void encodeY4MFrame(QImage const& frame, QByteArray& out);
+	~PipeSink();
+
+  protected:
+	qint64 write(QImage const& frame, QString const& name) override;
+	void finish() override;
+
+  private:
+	QString command;
+	QString workingDir;
+	Format format;
+	QSize size;
+	unsigned int fps;
+
+	// lives in the consumer thread
+	QProcess* process = nullptr;
+	bool failed       = false;
+	QByteArray buffer;
+
+	bool startProcess();
+};
+
+#endif // FRAMESINK_HPP
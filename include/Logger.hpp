@@ -16,19 +16,112 @@
     51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 */
 
+#ifndef LOGGER_HPP
+#define LOGGER_HPP
+
+#include <QByteArray>
 #include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <array>
+#include <atomic>
 #include <fstream>
 #include <iostream>
+#include <thread>
 
+/**
+ * @brief Qt message handler writing to log.txt and to the standard error.
+ *
+ * Messages are formatted on the logging thread, then pushed in a lock-free
+ * bounded queue (multiple producers, single consumer) and written by a
+ * background thread, so that logging never waits for the disk or the
+ * terminal. If the queue is full, messages are dropped and the number of
+ * dropped messages is logged later.
+ *
+ * Messages under the log/level setting severity are discarded right away.
+ * Each source (file and line, or message text if Qt doesn't provide the
+ * context) can only log log/ratelimit messages per second, the number of
+ * suppressed ones is logged once its second is over.
+ *
+ * Fatal messages are written synchronously once the queue is drained, as Qt
+ * aborts right after handling them.
+ */
 class Logger
 {
   public:
 	Logger() = delete;
 	static void init();
+	/**
+	 * @brief Reads the log group settings, called once QSettings are set up
+	 * and by each SettingsSnapshot::refresh.
+	 */
+	static void readSettings();
 	static void log(QtMsgType type, const QMessageLogContext& context,
 	                const QString& msg);
+	/**
+	 * @brief Writes all the queued messages and stops the background thread.
+	 */
 	static void close();
 
   private:
+	// queued messages, must be a power of two
+	static const unsigned int capacity = 4096;
+
+	struct Message
+	{
+		QtMsgType type = QtDebugMsg;
+		// steady clock, in milliseconds
+		qint64 time = 0;
+		// rate limiting key
+		QByteArray source;
+		QByteArray header;
+		QByteArray text;
+	};
+	struct Slot
+	{
+		std::atomic<unsigned int> sequence;
+		Message message;
+	};
+	struct RateWindow
+	{
+		qint64 start            = 0;
+		unsigned int count      = 0;
+		unsigned int suppressed = 0;
+		QByteArray header;
+	};
+	struct State
+	{
+		std::array<Slot, capacity> slots;
+		std::atomic<unsigned int> enqueuePos{0};
+		std::atomic<unsigned int> dequeuePos{0};
+		std::atomic<unsigned int> dropped{0};
+		std::atomic<int> minSeverity{0};
+		// 0 for no limit
+		std::atomic<unsigned int> rateLimit{0};
+		std::atomic<bool> running{false};
+		std::thread writer;
+		// held while writing, so that fatal messages don't interleave
+		QMutex writeMutex;
+		// only used by the writer thread
+		QHash<QByteArray, RateWindow> rateWindows;
+		qint64 lastSweep = 0;
+	};
+
 	static std::ofstream& logFile();
+	static State& state();
+	static int severity(QtMsgType type);
+	static qint64 now();
+	static bool push(Message&& message);
+	static bool pop(Message& message);
+	static void run();
+	// writes all the queued messages, returns false if there was none
+	static bool drain();
+	static bool rateLimited(Message const& message);
+	// logs the suppressed messages count of the sources whose second is over
+	static void sweepRateWindows(qint64 time);
+	static void write(Message const& message);
+	static void write(QtMsgType type, QByteArray const& header,
+	                  QByteArray const& text);
 };
+
+#endif // LOGGER_HPP
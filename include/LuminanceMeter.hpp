@@ -0,0 +1,121 @@
+/*
+    Copyright (C) 2020 Florian Cabot <florian.cabot@hotmail.fr>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef LUMINANCEMETER_HPP
+#define LUMINANCEMETER_HPP
+
+#include <array>
+#include <vector>
+
+#include "gl/GLBuffer.hpp"
+#include "gl/GLComputeShader.hpp"
+#include "gl/GLHandler.hpp"
+
+/**
+ * @brief Measures the average luminance of HDR frames on the GPU without
+ * stalling the pipeline.
+ *
+ * Computes the same center-weighted average as
+ * GLTexture::getAverageLuminance, but as a two-stage parallel reduction in a
+ * compute shader (luminance.comp). Its result is copied to a ring of
+ * readback buffers and read by the CPU once the GPU signaled it is done,
+ * which usually takes one or two frames.
+ *
+ * The same passes build a center weighted histogram of the frame's log
+ * luminance, from which the average luminance between two percentiles is
+ * computed (see setPercentiles()). This average ignores the few very bright
+ * pixels (stars) that make the plain average jump.
+ */
+class LuminanceMeter
+{
+  public:
+	LuminanceMeter();
+	LuminanceMeter(LuminanceMeter const& other) = delete;
+	LuminanceMeter& operator=(LuminanceMeter const& other) = delete;
+	/**
+	 * @brief Queues the measure of @p texture, an RGBA32F 2D texture, and
+	 * reads the oldest pending measure if it is ready.
+	 *
+	 * Never waits for the GPU unless @p wait is true : if all the readback
+	 * buffers are still in use, @p texture isn't measured. With @p wait, the
+	 * measure read is always the one queued latency frames before, which
+	 * makes the result independent of the GPU speed.
+	 */
+	void measure(GLTexture const& texture, bool wait = false);
+	/**
+	 * @brief Returns the last measure read back, 0 if none is available yet.
+	 */
+	float getAverageLuminance() const { return averageLuminance; };
+	/**
+	 * @brief Sets the fractions of the histogram weight, from the darkest
+	 * pixels, between which getHistogramAverageLuminance() is computed.
+	 */
+	void setPercentiles(float low, float high);
+	/**
+	 * @brief Returns the average luminance of the last measure read back,
+	 * without the pixels below and above the percentiles.
+	 */
+	float getHistogramAverageLuminance() const
+	{
+		return histogramAverageLuminance;
+	};
+	/**
+	 * @brief Returns the last histogram read back, each bin as a fraction of
+	 * the total weight.
+	 *
+	 * Bin 0 holds the luminances below 10^minLogLuminance (including black),
+	 * the others evenly divide [minLogLuminance, maxLogLuminance] in log10
+	 * scale, the last one also holding the luminances above.
+	 */
+	std::vector<float> const& getHistogram() const { return histogram; };
+
+	static const unsigned int histogramBins = 128;
+	static constexpr float minLogLuminance  = -10.f;
+	static constexpr float maxLogLuminance  = 10.f;
+
+	~LuminanceMeter();
+
+  private:
+	// number of frames a measure can stay in flight
+	static const unsigned int latency = 2;
+	// first stage work groups, see luminance.comp
+	static const unsigned int groups = 256;
+
+	GLComputeShader shader;
+	// groups partial sums then the total, as (weight * luminance, weight)
+	GLBuffer sums;
+	// bins, result and normalized bins, see luminance.comp
+	GLBuffer bins;
+	// total sums, histogram result and normalized bins
+	std::vector<GLBuffer> readbackBuffers;
+	std::array<GLsync, latency> fences = {};
+	unsigned int frame = 0;
+
+	float lowPercentile  = 0.f;
+	float highPercentile = 0.98f;
+
+	float averageLuminance          = 0.f;
+	float histogramAverageLuminance = 0.f;
+	std::vector<float> histogram;
+
+	// returns false if the measure of the current slot isn't ready yet,
+	// blocks until it is if wait is true
+	bool read(bool wait);
+};
+
+#endif // LUMINANCEMETER_HPP
@@ -19,6 +19,8 @@
 #ifndef MAINRENDERTARGET_HPP
 #define MAINRENDERTARGET_HPP
 
+#include <algorithm>
+
 #include "gl/GLHandler.hpp"
 
 class MainRenderTarget
@@ -55,8 +57,36 @@ class MainRenderTarget
 			return GLFramebufferObject(
 			    GLTexture::Tex2DProperties(width, height, GL_RGBA32F));
 		}
-		return GLFramebufferObject(
-		    GLTexture::TexCubemapProperties(width / 3, GL_RGBA32F));
+		return GLFramebufferObject(GLTexture::TexCubemapProperties(
+		    cubemapSide(width, height, projection), GL_RGBA32F));
+	}
+
+	// about one cube map texel per output pixel where both are the largest
+	// (faces centers, equator or dome zenith)
+	static unsigned int cubemapSide(unsigned int width, unsigned int height,
+	                                Projection projection)
+	{
+		unsigned int side(width / 3);
+		switch(projection)
+		{
+			case Projection::PANORAMA360:
+				// 2pi x pi over width x height
+				side = std::max(width / 4, height / 2);
+				break;
+			case Projection::VR360:
+				// one panorama per eye, stacked vertically
+				side = std::max(width / 4, height / 4);
+				break;
+			case Projection::DOMEMASTER180:
+				// keeps width / 3 : only three faces are rendered, so a dome
+				// costs half the texels of the six faces it used to. A side
+				// sharp at the zenith (min(width, height) / 2) would cost
+				// more than the six faces did.
+				break;
+			default:
+				break;
+		}
+		return std::max(1u, side);
 	}
 
   public:
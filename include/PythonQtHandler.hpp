@@ -27,11 +27,14 @@
 #include <gui/PythonQtScriptingConsole.h>
 #endif
 
+#include <QElapsedTimer>
+#include <QHash>
 #include <QObject>
 #include <QProcess>
 #include <QString>
 #include <QVariant>
 #include <type_traits>
+#include <vector>
 
 class PythonQtHandler
 {
@@ -49,15 +52,92 @@ class PythonQtHandler
 	static void addObject(QString const& name, QObject* object);
 	static QVariant evalScript(QString const& script);
 	static void evalFile(QString const& filename);
+	/**
+	 * @brief Returns true if the __main__ module defines a callable named
+	 * @p name.
+	 *
+	 * Hooks are looked up once and cached as Python object handles. The cache
+	 * is invalidated when a script or file is evaluated through this class,
+	 * and while the console is visible.
+	 */
+	static bool hasHook(QString const& name);
+	/**
+	 * @brief Calls the __main__ callable @p name with @p args, without
+	 * parsing any Python source. Does nothing if it isn't defined.
+	 *
+	 * @p args can contain Python objects returned by @ref createObject.
+	 */
+	static QVariant callHook(QString const& name,
+	                         QVariantList const& args = {});
+	/**
+	 * @brief Calls the __main__ callable @p type (a class) with @p args and
+	 * returns the resulting Python object, to be passed to @ref callHook.
+	 *
+	 * Returns an invalid QVariant if @p type isn't defined.
+	 */
+	static QVariant createObject(QString const& type,
+	                             QVariantList const& args = {});
+	/**
+	 * @brief Time spent in a hook, in milliseconds.
+	 */
+	struct HookTiming
+	{
+		QString name;
+		// during the last frame
+		unsigned int calls;
+		float last;
+		// exponential moving average over frames
+		float average;
+	};
+	/**
+	 * @brief Updates the hook timings with the hooks called since the last
+	 * call, to be called once per frame.
+	 *
+	 * Warns (at most once per second) if they took longer than the
+	 * scripting/framebudget setting in total.
+	 */
+	static void endFrame();
+	/**
+	 * @brief Returns the timings of the hooks called recently, sorted by
+	 * decreasing average.
+	 */
+	static std::vector<HookTiming> const& getHookTimings()
+	{
+		return hookProfile().timings;
+	};
+	/**
+	 * @brief Returns getHookTimings() and their total as lines of text, or an
+	 * empty string if no hook was called recently.
+	 */
+	static QString hookTimingsToString();
 	static void openConsole();
 	static void toggleConsole();
 	static void closeConsole();
 	static void clean();
 
   private:
+	struct HookProfile
+	{
+		// hooks called by hooks aren't counted twice in the total
+		unsigned int depth = 0;
+		// time and calls of each hook during the current frame
+		QHash<QString, std::pair<float, unsigned int>> frame;
+		float frameTotal   = 0.f;
+		float averageTotal = 0.f;
+		std::vector<HookTiming> timings;
+		// since the last budget warning
+		unsigned int framesOverBudget = 0;
+		QElapsedTimer warningTimer;
+	};
+
+	static HookProfile& hookProfile();
+
 #ifdef PYTHONQT
 	static PythonQtObjectPtr* mainModule;
 	static PythonQtScriptingConsole* console;
+	// null handles for names looked up but not defined
+	static QHash<QString, PythonQtObjectPtr>& hooks();
+	static PythonQtObjectPtr const& hook(QString const& name);
 #endif
 };
 
@@ -19,13 +19,19 @@
 #ifndef RENDERER_H
 #define RENDERER_H
 
+#include <QElapsedTimer>
 #include <list>
 #include <utility>
 
 #include "BasicCamera.hpp"
 #include "CalibrationCompass.hpp"
 #include "DebugCamera.hpp"
+#include "DynamicResolution.hpp"
+#include "FrameCapture.hpp"
+#include "LuminanceMeter.hpp"
 #include "MainRenderTarget.hpp"
+#include "SettingsSnapshot.hpp"
+#include "Text3D.hpp"
 #include "vr/VRHandler.hpp"
 
 class AbstractMainWin;
@@ -43,6 +49,67 @@ class Renderer
 
 		GLbitfield clearMask = 0x0; // don't clear anything by default
 		BasicCamera* camera;
+		/**
+		 * @brief If true, the path only draws points whose vertex shaders
+		 * project their positions with projection.glsl.
+		 *
+		 * With PANORAMA360 and DOMEMASTER180 projections, such paths are
+		 * drawn straight into the output target in one pass, before the
+		 * other paths are rendered in a cube map and blended over them by
+		 * their alpha (the clear color alpha must stay 0).
+		 */
+		bool directProjection = false;
+	};
+
+	/**
+	 * @brief How a post-processing pass reads its input, which decides how
+	 * passes are fused together.
+	 *
+	 * Except for SHADER passes, a pass named "name" is a shaders/name.glsl
+	 * file defining <code>vec4 postprocess(vec4 color, ivec2 pixel)</code>,
+	 * which returns the output pixel from the input one (@p color). Its
+	 * uniforms are set as usual through
+	 * AbstractMainWin::applyPostProcShaderParams. Consecutive passes are
+	 * fused into one generated compute shader (see exposure.glsl for an
+	 * example), so they share its global names : helper functions and
+	 * uniforms must be named uniquely.
+	 */
+	enum class PostProcessingFootprint
+	{
+		/**
+		 * @brief A complete compute shader, run alone (see
+		 * GLHandler::postProcess).
+		 */
+		SHADER,
+		/**
+		 * @brief Reads any pixel of the <code>dataIn</code> image, so it starts
+		 * a new fused shader, which needs a separate output.
+		 *
+		 * Additional textures from
+		 * AbstractMainWin::getPostProcessingUniformTextures are bound starting
+		 * from unit 2.
+		 */
+		NEIGHBORHOOD,
+		/**
+		 * @brief Only reads its input pixel, but its input is also read
+		 * elsewhere (by AbstractMainWin::getPostProcessingUniformTextures for
+		 * example), so it starts a new fused shader.
+		 *
+		 * Additional textures are bound as for NEIGHBORHOOD.
+		 */
+		PIXEL_BARRIER,
+		/**
+		 * @brief Only reads its input pixel, fused with the previous pass. It
+		 * can't use additional textures.
+		 */
+		PIXEL
+	};
+	struct PostProcessingPass
+	{
+		QString id;
+		QString name;
+		QMap<QString, QString> defines;
+		PostProcessingFootprint footprint;
 	};
 
 	Renderer(AbstractMainWin& window, VRHandler& vrHandler);
@@ -90,9 +157,28 @@ class Renderer
 	 */
 	DebugCamera& getDebugCamera() { return *dbgCamera; };
 	QImage getLastFrame() const;
-	// /!\ ownership of path.camera
+	/**
+	 * @brief Pushes the last rendered frame to @p sink, named @p name, in the
+	 * background (see FrameCapture).
+	 *
+	 * Unlike getLastFrame(), doesn't wait for the GPU to finish the frame.
+	 */
+	void captureLastFrame(FrameSink& sink, QString const& name);
+	/**
+	 * @brief Waits until all the captured frames are pushed to their sink.
+	 */
+	void flushCapturedFrames() { frameCapture->flush(); };
+	/**
+	 * @brief Returns the resolution scaling of the scene, see
+	 * DynamicResolution.
+	 *
+	 * Only 2D rendering with the DEFAULT projection is scaled, the scene
+	 * being upscaled when copied to the post-processing targets.
+	 */
+	DynamicResolution& getDynamicResolution() { return *dynamicResolution; };
+	// /!\ ownership of path.camera, which several paths can share
 	void appendSceneRenderPath(QString const& id, RenderPath path);
-	// /!\ ownership of path.camera
+	// /!\ ownership of path.camera, which several paths can share
 	void insertSceneRenderPath(QString const& id, RenderPath path,
 	                           unsigned int pos);
 	void removeSceneRenderPath(QString const& id);
@@ -102,6 +188,15 @@ class Renderer
 	{
 		return lastFrameAverageLuminance;
 	};
+	// in frame units, without the pixels outside of the percentiles set by
+	// setLuminancePercentiles
+	float getLastFrameHistogramAverageLuminance() const
+	{
+		return lastFrameHistogramAverageLuminance;
+	};
+	// see LuminanceMeter::getHistogram, first eye's one in VR
+	std::vector<float> getLastFrameLuminanceHistogram() const;
+	void setLuminancePercentiles(float low, float high);
 	/**
 	 * @brief Appends a post-processing shader to the post-processing pipeline.
 	 *
@@ -110,11 +205,14 @@ class Renderer
 	 *
 	 * @param id Identifier to refer to the fragment shader later.
 	 * @param computeName Path to the compute shader to use. See README for
-	 * informations about data paths.
+	 * informations about data paths. For passes other than SHADER ones, name
+	 * of their .glsl file (see @ref PostProcessingFootprint).
 	 */
 	void appendPostProcessingShader(QString const& id,
 	                                QString const& computeName,
-	                                QMap<QString, QString> const& defines = {});
+	                                QMap<QString, QString> const& defines = {},
+	                                PostProcessingFootprint footprint
+	                                = PostProcessingFootprint::SHADER);
 	/**
 	 * @brief Inserts a post-processing shader into the post-processing
 	 * pipeline.
@@ -129,7 +227,9 @@ class Renderer
 	 */
 	void insertPostProcessingShader(QString const& id,
 	                                QString const& computeName,
-	                                unsigned int pos);
+	                                unsigned int pos,
+	                                PostProcessingFootprint footprint
+	                                = PostProcessingFootprint::SHADER);
 	/**
 	 * @brief Removes a post-processing shader from the post-processing
 	 * pipeline.
@@ -160,6 +260,22 @@ class Renderer
 		}
 	};
 	void toggleCalibrationCompass();
+	/**
+	 * @brief Whether the averaged GPU times of the frame scopes are shown in
+	 * the top left corner of the window (see GLProfiler), followed by the
+	 * CPU times of the Python hooks (see PythonQtHandler::getHookTimings).
+	 *
+	 * Profiling is only enabled while they are shown.
+	 */
+	bool getGPUProfilerOverlay() const
+	{
+		return gpuProfilerOverlay != nullptr;
+	};
+	void setGPUProfilerOverlay(bool on);
+	void toggleGPUProfilerOverlay()
+	{
+		setGPUProfilerOverlay(!getGPUProfilerOverlay());
+	};
 	double getDoubleFarRightPixelSubtendedAngle()
 	{
 		return CalibrationCompass::getDoubleFarRightPixelSubtendedAngle(
@@ -175,6 +291,12 @@ class Renderer
 	QString pathIdRenderingControllers = "default";
 
 	bool wireframe = false;
+	/**
+	 * @brief If true, results read back from the GPU (luminance measures)
+	 * always lag the same number of frames behind, waiting for the GPU if
+	 * needed, so that a frame only depends on the previous ones.
+	 */
+	bool deterministic = false;
 	MainRenderTarget::Projection projection
 	    = QSettings().value("window/domemaster").toBool()
 	          ? MainRenderTarget::Projection::DOMEMASTER180
@@ -193,18 +315,12 @@ class Renderer
 	QList<QPair<QString, RenderPath>> const& sceneRenderPipeline
 	    = sceneRenderPipeline_;
 	/**
-	 * @brief Ordered list of post-processing shaders to apply at the end of
+	 * @brief Ordered list of post-processing passes to apply at the end of
 	 * scene rendering.
 	 *
 	 * This member is read-only.
-	 *
-	 * For each QPair p :
-	 *
-	 * * p.first is the shader identifier set when adding or inserting it in the
-	 * pipeline using the corresponding methods.
-	 * * p.second is the shader itself.
 	 */
-	std::list<std::pair<QString, GLComputeShader>> const& postProcessingPipeline
+	std::list<PostProcessingPass> const& postProcessingPipeline
 	    = postProcessingPipeline_;
 
   private:
@@ -225,12 +341,49 @@ class Renderer
 
 	QList<QPair<QString, RenderPath>> sceneRenderPipeline_;
 
-	std::list<std::pair<QString, GLComputeShader>> postProcessingPipeline_;
-	float lastFrameAverageLuminance = 0.f;
+	std::list<PostProcessingPass> postProcessingPipeline_;
+
+	// consecutive passes run by one compute shader
+	struct PostProcessingGroup
+	{
+		PostProcessingGroup(std::vector<PostProcessingPass> passes,
+		                    GLComputeShader&& shader);
+
+		std::vector<PostProcessingPass> passes;
+		GLComputeShader shader;
+		// reads and writes the same target
+		bool inPlace;
+	};
+	std::list<PostProcessingGroup> postProcessingGroups;
+	// groups need to be rebuilt from postProcessingPipeline_
+	bool postProcessingGraphDirty = true;
+	// index of the post-processing target holding the final image
+	unsigned int postProcessingResult = 0;
+
+	void buildPostProcessingGraph();
+	// path of the generated shader fusing passes
+	static QString
+	    generatePostProcessingShader(std::vector<PostProcessingPass> const&
+	                                     passes);
+	// runs all the post-processing passes on postProcessingTargets[0]
+	void postProcess();
+	float lastFrameAverageLuminance          = 0.f;
+	float lastFrameHistogramAverageLuminance = 0.f;
+	// one per eye, only the first one is used without VR
+	std::array<LuminanceMeter*, 2> luminanceMeters = {};
+	FrameCapture* frameCapture                     = nullptr;
+	DynamicResolution* dynamicResolution           = nullptr;
+	// cube map to panorama360 / domemaster180 projections
+	GLShaderProgram* panoramaShader   = nullptr;
+	GLShaderProgram* domeMasterShader = nullptr;
 
 	bool renderCompass          = false;
 	CalibrationCompass* compass = nullptr;
 
+	Text3D* gpuProfilerOverlay = nullptr;
+	QElapsedTimer gpuProfilerOverlayTimer;
+	void renderGPUProfilerOverlay();
+
 	MainRenderTarget* mainRenderTarget = nullptr;
 };
 
@@ -0,0 +1,104 @@
+/*
+    Copyright (C) 2020 Florian Cabot <florian.cabot@hotmail.fr>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef SETTINGSSNAPSHOT_HPP
+#define SETTINGSSNAPSHOT_HPP
+
+#include <QHash>
+#include <QSettings>
+#include <QString>
+#include <QVariant>
+#include <memory>
+
+/**
+ * @brief Immutable copy of all the QSettings values.
+ *
+ * Constructing a QSettings and looking a key up parses and locks the
+ * settings storage, which is too slow for code running every frame. That
+ * code reads a @ref Setting instead, which converts its value once per
+ * snapshot.
+ *
+ * The snapshot is taken on first use, then only when @ref refresh is
+ * called : code changing settings through QSettings must call it (the
+ * SettingsWidget, the AbstractMainWin setters and its setSetting slot for
+ * Python do).
+ *
+ * @attention Snapshots are not thread-safe, only use them from the main
+ * thread.
+ */
+class SettingsSnapshot
+{
+  public:
+	/**
+	 * @brief Returns the current snapshot, which stays valid until the next
+	 * @ref refresh.
+	 */
+	static SettingsSnapshot const& current();
+	/**
+	 * @brief Takes a new snapshot of QSettings and applies the log settings
+	 * (see Logger::readSettings).
+	 */
+	static void refresh();
+	/**
+	 * @brief Increments each time a snapshot is taken, starting from 1.
+	 */
+	static unsigned int getGeneration() { return generation(); };
+	QVariant value(QString const& key) const { return values.value(key); };
+
+  private:
+	SettingsSnapshot();
+
+	QHash<QString, QVariant> values;
+
+	static std::unique_ptr<SettingsSnapshot const>& instance();
+	static unsigned int& generation();
+};
+
+/**
+ * @brief Typed value of the setting @p key of the current SettingsSnapshot.
+ *
+ * The value is only converted again when a new snapshot was taken, reading
+ * it otherwise costs an integer comparison.
+ */
+template <typename T>
+class Setting
+{
+  public:
+	explicit Setting(QString key)
+	    : key(std::move(key)){};
+	T const& get() const;
+
+  private:
+	QString key;
+	mutable T value = T();
+	// 0 : never read
+	mutable unsigned int generation = 0;
+};
+
+template <typename T>
+T const& Setting<T>::get() const
+{
+	if(generation == 0 || generation != SettingsSnapshot::getGeneration())
+	{
+		value      = SettingsSnapshot::current().value(key).template value<T>();
+		generation = SettingsSnapshot::getGeneration();
+	}
+	return value;
+}
+
+#endif // SETTINGSSNAPSHOT_HPP
@@ -45,6 +45,7 @@
 #include <array>
 
 #include "InputManager.hpp"
+#include "SettingsSnapshot.hpp"
 
 class SettingsWidget : public QTabWidget
 {
@@ -108,6 +109,7 @@ template <typename T>
 void SettingsWidget::updateValue(QString const& fullName, T newValue)
 {
 	settings.setValue(fullName, newValue);
+	SettingsSnapshot::refresh();
 }
 
 class ScreenSelector : public QDialog
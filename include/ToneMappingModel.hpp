@@ -22,6 +22,7 @@
 #include "vr/VRHandler.hpp"
 
 #include "AbstractState.hpp"
+#include "LuminanceMeter.hpp"
 
 /** @ingroup pycall
  *
@@ -74,6 +75,48 @@ class ToneMappingModel : public QObject
 	 * seconds to fully adapt to bright conditions.
 	 */
 	Q_PROPERTY(float autoexposuretimecoeff MEMBER autoexposuretimecoeff)
+	/**
+	 * @brief Use the average luminance between @ref lowpercentile and @ref
+	 * highpercentile of the frame's luminance histogram for automatic
+	 * exposure, instead of the average of all pixels.
+	 *
+	 * Keeps a few very bright stars from making the exposure pump.
+	 */
+	Q_PROPERTY(bool histogramexposure MEMBER histogramexposure)
+	/**
+	 * @brief Fraction of the darkest pixels ignored by @ref
+	 * histogramexposure.
+	 */
+	Q_PROPERTY(float lowpercentile MEMBER lowpercentile)
+	/**
+	 * @brief Fraction of the pixels, from the darkest, considered by @ref
+	 * histogramexposure (the brightest 1 - highpercentile are ignored).
+	 */
+	Q_PROPERTY(float highpercentile MEMBER highpercentile)
+	/**
+	 * @brief Center weighted log luminance histogram of the last measured
+	 * frame, each bin as a fraction of the total weight.
+	 *
+	 * Bin 0 holds the luminances below 10^@ref histogramminlog (including
+	 * black), the others evenly divide [@ref histogramminlog, @ref
+	 * histogrammaxlog], the last one also holding the luminances above.
+	 * Luminances are in frame units (before exposure).
+	 *
+	 * @accessors getHistogram()
+	 */
+	Q_PROPERTY(QVariantList histogram READ getHistogram)
+	/**
+	 * @brief log10 of the lowest luminance of the @ref histogram bin 1.
+	 *
+	 * @accessors getHistogramMinLog()
+	 */
+	Q_PROPERTY(float histogramminlog READ getHistogramMinLog)
+	/**
+	 * @brief log10 of the highest luminance of the @ref histogram last bin.
+	 *
+	 * @accessors getHistogramMaxLog()
+	 */
+	Q_PROPERTY(float histogrammaxlog READ getHistogramMaxLog)
 
   public:
 	class State : public AbstractState
@@ -87,17 +130,26 @@ class ToneMappingModel : public QObject
 			stream >> exposure;
 			stream >> dynamicrange;
 			stream >> purkinje;
+			stream >> histogramexposure;
+			stream >> lowpercentile;
+			stream >> highpercentile;
 		};
 		virtual void writeInDataStream(QDataStream& stream) override
 		{
 			stream << exposure;
 			stream << dynamicrange;
 			stream << purkinje;
+			stream << histogramexposure;
+			stream << lowpercentile;
+			stream << highpercentile;
 		};
 
-		float exposure     = 0.f;
-		float dynamicrange = 0.f;
-		bool purkinje      = false;
+		float exposure         = 0.f;
+		float dynamicrange     = 0.f;
+		bool purkinje          = false;
+		bool histogramexposure = false;
+		float lowpercentile    = 0.f;
+		float highpercentile   = 0.f;
 	};
 
 	ToneMappingModel(VRHandler const& vrHandler);
@@ -111,24 +163,59 @@ class ToneMappingModel : public QObject
 	float autoexposurecoeff     = 1.f;
 	float autoexposuretimecoeff = 1.f;
 
+	bool histogramexposure = false;
+	float lowpercentile    = 0.f;
+	float highpercentile   = 0.98f;
+
+	/**
+	 * @getter{histogram}
+	 */
+	QVariantList getHistogram() const;
+	void setHistogram(std::vector<float> const& histogram)
+	{
+		this->histogram = histogram;
+	};
+	/**
+	 * @getter{histogramminlog}
+	 */
+	float getHistogramMinLog() const
+	{
+		return LuminanceMeter::minLogLuminance;
+	};
+	/**
+	 * @getter{histogrammaxlog}
+	 */
+	float getHistogramMaxLog() const
+	{
+		return LuminanceMeter::maxLogLuminance;
+	};
+
 	void readState(AbstractState const& s)
 	{
 		auto const& state = dynamic_cast<State const&>(s);
 		exposure          = state.exposure;
 		dynamicrange      = state.dynamicrange;
 		purkinje          = state.purkinje;
+		histogramexposure = state.histogramexposure;
+		lowpercentile     = state.lowpercentile;
+		highpercentile    = state.highpercentile;
 	};
 	void writeState(AbstractState& s) const
 	{
-		auto& state        = dynamic_cast<State&>(s);
-		state.exposure     = exposure;
-		state.dynamicrange = dynamicrange;
-		state.purkinje     = purkinje;
+		auto& state             = dynamic_cast<State&>(s);
+		state.exposure          = exposure;
+		state.dynamicrange      = dynamicrange;
+		state.purkinje          = purkinje;
+		state.histogramexposure = histogramexposure;
+		state.lowpercentile     = lowpercentile;
+		state.highpercentile    = highpercentile;
 	};
 
   private:
 	VRHandler const& vrHandler;
 
+	std::vector<float> histogram;
+
 	/*
 	 * BEG AUTOEXPOSURE MODEL
 	 */
@@ -25,6 +25,7 @@
 
 #include "GLTexture.hpp"
 
+class GLBuffer;
 class GLHandler;
 
 /** @ingroup pywrap
@@ -115,6 +116,14 @@ class GLFramebufferObject
 	void showOnScreen(int screenx0, int screeny0, int screenx1,
 	                  int screeny1) const;
 	QImage copyColorBufferToQImage() const;
+	/**
+	 * @brief Queues a copy of this FBO's color attachment to @p buffer as
+	 * RGBA8 rows, from bottom to top, resizing it if needed.
+	 *
+	 * Doesn't wait for the copy : map @p buffer once a fence inserted after
+	 * this call is signaled to avoid stalling.
+	 */
+	void copyColorBufferToBuffer(GLBuffer& buffer) const;
 
 	virtual ~GLFramebufferObject() { cleanUp(); };
 
@@ -77,6 +77,11 @@ class GLHandler : public QObject
 	 * do, including allocating resources through the new*() methods.
 	 */
 	static bool init();
+	/**
+	 * @brief Frees the resources allocated by @ref init. Call it before the
+	 * context is destroyed, while it is current.
+	 */
+	static void clean();
 
 	/**
 	 * @brief Returns a reference to the OpenGL functions retrieved by Qt.
@@ -88,7 +93,89 @@ class GLHandler : public QObject
 
 	static QOpenGLExtension_ARB_compute_shader& glf_ARB_compute_shader();
 
+	static QOpenGLExtension_ARB_multi_draw_indirect&
+	    glf_ARB_multi_draw_indirect();
+
+	/**
+	 * @brief Uniform buffer binding point of the buffer uploaded by @ref
+	 * setUpTransforms, see data/core/shaders/camera.glsl.
+	 */
+	static const GLuint cameraTransformsBinding = 0;
+
+	// STATE
+	/**
+	 * @brief Counts of state changing calls of the current frame that were
+	 * sent to the driver or skipped because the state was already set.
+	 */
+	struct StateCounters
+	{
+		unsigned int issued  = 0;
+		unsigned int avoided = 0;
+	};
+	/**
+	 * @brief Must be called at the beginning of each frame.
+	 *
+	 * Calls @ref invalidateState, as Qt may have changed the state since
+	 * last frame, and moves the current frame @ref StateCounters to the last
+	 * frame ones.
+	 */
+	static void beginFrame();
+	/**
+	 * @brief Forgets the shadowed OpenGL state.
+	 *
+	 * GLHandler keeps a copy of the state it sets through the methods below
+	 * (also used by @ref GLShaderProgram, @ref GLTexture and @ref GLMesh) and
+	 * skips the calls that wouldn't change it. Call this after any code
+	 * outside of the engine issued OpenGL calls (OpenVR compositor for
+	 * example) so that the next calls reach the driver.
+	 *
+	 * @attention Raw glf() calls changing the shadowed state must be avoided,
+	 * or followed by a call to this method.
+	 */
+	static void invalidateState();
+	static StateCounters getLastFrameStateCounters();
+	static void setEnabled(GLenum capability, bool enabled);
+	static void setDepthMask(bool enabled);
+	static void setDepthFunc(GLenum func);
+	static void setBlendFunc(GLenum sfactor, GLenum dfactor);
+	static void setPolygonMode(GLenum mode);
+	static void setCullFace(GLenum face);
+	static void setFrontFace(GLenum mode);
+	static void useProgram(GLuint program);
+	static void bindVertexArray(GLuint vao);
+	/**
+	 * @brief Binds @p texture to @p target of the @p textureUnit unit, which
+	 * becomes the active one.
+	 */
+	static void bindTexture(GLenum target, GLuint texture, GLenum textureUnit);
+	/**
+	 * @brief Binds @p texture to @p target of the active texture unit.
+	 */
+	static void bindTexture(GLenum target, GLuint texture);
+	/**
+	 * @brief Must be called before deleting a vertex array or texture
+	 * respectively, as OpenGL unbinds them and could reuse their names.
+	 */
+	static void forgetVertexArray(GLuint vao);
+	static void forgetTexture(GLuint texture);
+
   public slots:
+	/**
+	 * @brief Returns the number of state changing OpenGL calls of last frame
+	 * which were sent to the driver.
+	 */
+	static unsigned int getLastFrameIssuedStateChanges()
+	{
+		return getLastFrameStateCounters().issued;
+	};
+	/**
+	 * @brief Returns the number of state changing OpenGL calls of last frame
+	 * which were skipped because they wouldn't have changed the state.
+	 */
+	static unsigned int getLastFrameAvoidedStateChanges()
+	{
+		return getLastFrameStateCounters().avoided;
+	};
 	/**
 	 * @brief Sets the point size when rendering of @ref PrimitiveType POINTS.
 	 *
@@ -144,6 +231,16 @@ class GLHandler : public QObject
 	static void setUpRender(GLShaderProgram const& shader,
 	                        QMatrix4x4 const& model = QMatrix4x4(),
 	                        GeometricSpace space    = GeometricSpace::WORLD);
+	/**
+	 * @brief Returns the matrix @ref setUpRender would send as the
+	 * <code>in mat4 camera;</code> input of a shader program.
+	 *
+	 * Useful when the camera matrix isn't sent as a uniform, for example when
+	 * it is stored per draw in a buffer.
+	 */
+	static QMatrix4x4 getCameraMatrix(QMatrix4x4 const& model = QMatrix4x4(),
+	                                  GeometricSpace space
+	                                  = GeometricSpace::WORLD);
 	/**
 	 * @brief Renders @p from's color attachment onto a quad using a
 	 * post-processing @p shader. The final rendering gets stored on the @p to
@@ -168,6 +265,14 @@ class GLHandler : public QObject
 	                        GLFramebufferObject const& to,
 	                        std::vector<GLTexture const*> const& uniformTextures
 	                        = {});
+	/**
+	 * @brief Same as postProcess(shader, from, to), but blends the result over
+	 * the content of @p to (as premultiplied alpha, without depth test)
+	 * instead of replacing it.
+	 */
+	static void postProcessOver(GLShaderProgram const& shader,
+	                            GLFramebufferObject const& from,
+	                            GLFramebufferObject const& to);
 	static void postProcess(
 	    GLComputeShader const& shader, GLFramebufferObject const& inplace,
 	    std::vector<
@@ -184,10 +289,32 @@ class GLHandler : public QObject
 	static void renderFromScratch(GLShaderProgram const& shader,
 	                              GLFramebufferObject const& to);
 
+	/**
+	 * @brief Renders the six faces of the @p renderTarget cube map with
+	 * @p renderFunction, from a camera translated by @p shift.
+	 *
+	 * If @p hemisphere isn't null, only the directions d such that
+	 * dot(d, hemisphere) >= 0 (in cube map space) will be sampled : faces
+	 * that don't see this half space are skipped, and the others only render
+	 * the rectangle of pixels that do, through a viewport and an off-center
+	 * projection (which also lets the scene cull what lies outside of it).
+	 */
 	static void generateEnvironmentMap(
 	    GLFramebufferObject const& renderTarget,
 	    std::function<void(bool, QMatrix4x4, QMatrix4x4)> const& renderFunction,
-	    QVector3D const& shift = QVector3D(0, 0, 0));
+	    QVector3D const& shift      = QVector3D(0, 0, 0),
+	    QVector3D const& hemisphere = QVector3D(0, 0, 0));
+	/**
+	 * @brief Same as generateEnvironmentMap, but only renders the @p face face
+	 * of @p renderTarget, so that generation can be spread over several
+	 * frames.
+	 */
+	static void generateEnvironmentMapFace(
+	    GLFramebufferObject const& renderTarget,
+	    std::function<void(bool, QMatrix4x4, QMatrix4x4)> const& renderFunction,
+	    GLTexture::CubemapFace face,
+	    QVector3D const& shift      = QVector3D(0, 0, 0),
+	    QVector3D const& hemisphere = QVector3D(0, 0, 0));
 	/**
 	 * @brief Begins wireframe rendering.
 	 */
@@ -233,6 +360,9 @@ class GLHandler : public QObject
 	 * Each matrix corresponds to a particular @ref GeometricSpace when calling
 	 * @ref setUpRender.
 	 *
+	 * The matrices are also uploaded once to a uniform buffer, so that shaders
+	 * including camera.glsl can read them without any per draw uniform.
+	 *
 	 * See the TRANSFORMS file for more details about the parameters.
 	 */
 	static void
@@ -243,6 +373,26 @@ class GLHandler : public QObject
 	                    QMatrix4x4 const& fullStandingTrackedSpaceTransform,
 	                    QMatrix4x4 const& fullHmdSpaceTransform,
 	                    QMatrix4x4 const& fullSkyboxSpaceTransform);
+	/**
+	 * @brief Makes the vertex shaders using projection.glsl project their
+	 * positions straight to a @p size target of @p projection (a
+	 * MainRenderTarget::Projection value, 0 to disable).
+	 *
+	 * While enabled, the camera matrices transform to eye space instead of
+	 * clip space (the projection matrix is identity), see
+	 * Renderer::RenderPath::directProjection. Uploaded with the next
+	 * setUpTransforms call.
+	 */
+	static void setDirectProjection(unsigned int projection,
+	                                QSize const& size = QSize());
+	/**
+	 * @brief Returns the projection set by setDirectProjection(), 0 if none.
+	 */
+	static unsigned int getDirectProjection();
+	/**
+	 * @brief Returns the target size set by setDirectProjection().
+	 */
+	static QSize getDirectProjectionSize();
 
 	// TEXTURES
 	static void useTextures(std::vector<GLTexture const*> const& textures);
@@ -268,6 +418,17 @@ class GLHandler : public QObject
 	// transform for any Skybox space object (follows HMD translations + no
 	// stereo)
 	static QMatrix4x4& fullSkyboxSpaceTransform();
+	// projection, target width and height, see setDirectProjection
+	static QVector4D& directProjection();
+	// all of the above, std140 layout of camera.glsl
+	static GLBuffer*& cameraTransformsBuffer();
+
+	// see invalidateState()
+	struct State;
+	static State& state();
+	// returns true and updates shadow if value differs, counts the call
+	template <typename T>
+	static bool changes(T& shadow, T value);
 };
 
 #endif // GLHANDLER_H
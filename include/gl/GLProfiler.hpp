@@ -0,0 +1,163 @@
+/*
+    Copyright (C) 2020 Florian Cabot <florian.cabot@hotmail.fr>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef GLPROFILER_HPP
+#define GLPROFILER_HPP
+
+#include <QHash>
+#include <QOpenGLFunctions>
+#include <QOpenGLFunctions_4_2_Core>
+#include <QString>
+#include <array>
+#include <vector>
+
+/**
+ * @brief Measures how the GPU time of a frame splits between its render
+ * paths and passes.
+ *
+ * Code to measure is wrapped in a @ref Scope, which writes a GL_TIMESTAMP
+ * query when constructed and another one when destroyed. Scopes can be
+ * nested : each one is identified by its path, its name appended to its
+ * parents' names with '/'. Timestamps (unlike GL_TIME_ELAPSED queries) can
+ * nest and don't conflict with other elapsed time queries (see
+ * DynamicResolution).
+ *
+ * Queries are only read back a few frames later, when the frame's last one
+ * is available, so that the pipeline never stalls. If it isn't, the next
+ * frame is simply not profiled. Each scope's time is then averaged over the
+ * last frames.
+ *
+ * Profiling is disabled by default, scopes then cost nothing but a branch.
+ * Only scopes within a frame (between @ref beginFrame and @ref endFrame)
+ * are measured.
+ */
+class GLProfiler
+{
+  public:
+	/**
+	 * @brief Measures the GPU time of the commands issued during its
+	 * lifetime.
+	 */
+	class Scope
+	{
+	  public:
+		explicit Scope(QString const& name)
+		    : active(GLProfiler::begin(name)){};
+		Scope(Scope const& other) = delete;
+		Scope& operator=(Scope const& other) = delete;
+		~Scope()
+		{
+			if(active)
+			{
+				GLProfiler::end();
+			}
+		};
+
+	  private:
+		bool active;
+	};
+
+	/**
+	 * @brief Averaged GPU time of a scope.
+	 */
+	struct Timing
+	{
+		QString path;
+		QString name;
+		// number of parents
+		unsigned int depth;
+		// in milliseconds
+		float average;
+		float last;
+	};
+
+	GLProfiler() = delete;
+	static bool isEnabled() { return state().enabled; };
+	static void setEnabled(bool enabled);
+	/**
+	 * @brief Starts profiling a frame, after reading back the oldest one if
+	 * it is available.
+	 */
+	static void beginFrame();
+	static void endFrame();
+	/**
+	 * @brief Returns the timings of the last frame read back, in the order
+	 * their scopes started (parents before their children).
+	 *
+	 * Scopes that weren't in that frame are dropped.
+	 */
+	static std::vector<Timing> const& getTimings() { return state().timings; };
+	/**
+	 * @brief Returns getTimings() as indented lines of text.
+	 */
+	static QString toString();
+	/**
+	 * @brief Writes getTimings() to the CSV file @p path.
+	 *
+	 * Returns false if the file couldn't be written.
+	 */
+	static bool exportToFile(QString const& path);
+	/**
+	 * @brief Disables profiling and frees the queries.
+	 *
+	 * Must be called while the OpenGL context is current.
+	 */
+	static void clean();
+
+  private:
+	// number of frames that can stay in flight
+	static const unsigned int latency = 4;
+
+	struct Sample
+	{
+		QString path;
+		QString name;
+		unsigned int depth;
+		// indices in Frame::queries
+		unsigned int begin;
+		unsigned int end;
+	};
+	struct Frame
+	{
+		// grows to the number of timestamps of a frame, never shrinks
+		std::vector<GLuint> queries;
+		unsigned int usedQueries = 0;
+		std::vector<Sample> samples;
+		bool pending = false;
+	};
+	struct State
+	{
+		bool enabled = false;
+		std::array<Frame, latency> frames;
+		unsigned int frame = 0;
+		// the current frame is profiled
+		bool profiling = false;
+		// open scopes, indices in the current frame's samples
+		std::vector<unsigned int> stack;
+		std::vector<Timing> timings;
+	};
+
+	static State& state();
+	static bool begin(QString const& name);
+	static void end();
+	// writes a timestamp query, returns its index in the current frame
+	static unsigned int timestamp();
+	static void read(Frame& frame);
+};
+
+#endif // GLPROFILER_HPP
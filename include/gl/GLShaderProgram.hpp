@@ -19,6 +19,8 @@
 #ifndef GLSHADERPROGRAM_HPP
 #define GLSHADERPROGRAM_HPP
 
+#include <QDateTime>
+#include <QHash>
 #include <QOpenGLFunctions>
 #include <QOpenGLFunctions_4_2_Core>
 
@@ -66,6 +68,7 @@ class GLShaderProgram
 	GLShaderProgram(GLShaderProgram&& other)
 	    : glShaderProgram(other.glShaderProgram)
 	    , doClean(other.doClean)
+	    , uniformLocations(std::move(other.uniformLocations))
 	{
 		// prevent other from cleaning shader if it destroys itself
 		other.doClean = false;
@@ -103,9 +106,22 @@ class GLShaderProgram
 	 * share the same name : GLShaderProgram("default") will search for both
 	 * "shaders/default.vert" and "shader/default.frag".
 	 *
-	 * As of this version, the vertex and fragment shaders linked in the shader
-	 * program are freed and will have to be compiled again if a @ref
-	 * GLShaderProgram is constructed another time with the same parameters.
+	 * Linked programs are cached for the whole process, keyed by their stages
+	 * file names and preprocessed sources (including @p defines). A @ref
+	 * GLShaderProgram constructed another time with the same sources gets its
+	 * own OpenGL program loaded from the cached binary, without compiling
+	 * anything. If the driver doesn't support program binaries, shaders are
+	 * compiled every time.
+	 *
+	 * The binaries are also stored in the user's cache directory, keyed by
+	 * the OpenGL driver too, so that next launches don't compile them either.
+	 * Shader source files are read once, then only read again if they changed
+	 * on disk.
+	 *
+	 * Locations of all the active uniforms are resolved once the program is
+	 * linked (see @ref getUniformLocation). If the program declares the
+	 * <code>CameraTransforms</code> uniform block of camera.glsl, it is bound
+	 * to the buffer uploaded by @ref GLHandler::setUpTransforms.
 	 */
 	GLShaderProgram(QString const& vertexName, QString const& fragmentName,
 	                QMap<QString, QString> const& defines = {});
@@ -219,11 +235,77 @@ class GLShaderProgram
 	 */
 	void setUniform(const char* paramName, QColor const& value,
 	                bool sRGB = true) const;
+	/**
+	 * @brief Returns the location of the uniform @p paramName, or -1 if it
+	 * isn't an active uniform of this program.
+	 *
+	 * Locations are resolved once after linking and cached, so this doesn't
+	 * query OpenGL. Arrays can be referred to with or without their "[0]"
+	 * suffix.
+	 */
+	GLint getUniformLocation(const char* paramName) const;
+	/**
+	 * @brief Same as the setUniform methods taking a uniform name, but with a
+	 * @p location returned by @ref getUniformLocation. Nothing is set if @p
+	 * location is -1.
+	 */
+	void setUniform(GLint location, int value) const;
+	void setUniform(GLint location, float value) const;
+	void setUniform(GLint location, QVector2D const& value) const;
+	void setUniform(GLint location, QVector3D const& value) const;
+	void setUniform(GLint location, unsigned int size,
+	                QVector3D const* values) const;
+	void setUniform(GLint location, QVector4D const& value) const;
+	void setUniform(GLint location, unsigned int size,
+	                QVector4D const* values) const;
+	void setUniform(GLint location, QMatrix4x4 const& value) const;
+	void setUniform(GLint location, QColor const& value,
+	                bool sRGB = true) const;
+	/**
+	 * @brief Typed handle to a uniform of a @ref GLShaderProgram.
+	 *
+	 * Its location is looked up once, so that setting the uniform every frame
+	 * doesn't involve any string :
+	 * @code
+	 * GLShaderProgram::Uniform<float> alpha(shader, "alpha");
+	 * // ...
+	 * alpha.set(0.5f);
+	 * @endcode
+	 *
+	 * @attention The handle must not outlive its program.
+	 */
+	template <typename T>
+	class Uniform
+	{
+	  public:
+		Uniform() = default;
+		Uniform(GLShaderProgram const& program, const char* name)
+		    : program(&program)
+		    , location(program.getUniformLocation(name)){};
+		/**
+		 * @brief Returns false if the program doesn't use this uniform.
+		 */
+		bool isActive() const { return location != -1; };
+		void set(T const& value) const
+		{
+			if(program != nullptr)
+			{
+				program->setUniform(location, value);
+			}
+		};
+
+	  private:
+		GLShaderProgram const* program = nullptr;
+		GLint location                 = -1;
+	};
 	/**
 	 * @brief Tells OpenGL to use this @p shader program for rendering.
 	 *
 	 * If you exclusively use @ref GLHandler methods, this method will be called
 	 * automatically when necessary and you shouldn't use it.
+	 *
+	 * Does nothing if this program is already in use (see @ref
+	 * GLHandler::invalidateState).
 	 */
 	void use() const;
 	virtual ~GLShaderProgram() { cleanUp(); };
@@ -249,12 +331,57 @@ class GLShaderProgram
 	bool doClean = true;
 	static unsigned int& instancesCount();
 
+	// name -> location, including queried names which aren't active (-1)
+	mutable QHash<QByteArray, GLint> uniformLocations;
+	// caches active uniforms locations and binds known uniform blocks
+	void resolveUniforms();
+
+	struct ProgramBinary
+	{
+		GLenum format = 0;
+		QByteArray data;
+	};
+
+	// see GLShaderProgram(pipeline, defines)
+	static QHash<QByteArray, ProgramBinary>& programCache();
+	// increase when the cache files format changes
+	static const quint32 diskCacheVersion = 1;
+	static QString getDiskCachePath(QByteArray const& key);
+	// returns false if key isn't cached or its binary can't be loaded
+	bool loadFromCache(QByteArray const& key) const;
+	// caches the linked program's binary
+	void storeInCache(QByteArray const& key) const;
+
 	static std::pair<QString, GLenum> decodeStage(Stage s);
 	static QString
 	    getFullPreprocessedSource(QString const& path,
 	                              QMap<QString, QString> const& defines);
+
+	struct StrippedSource
+	{
+		QString absolutePath;
+		QDateTime lastModified;
+		QString source;
+	};
+
+	// file content without comments, before includes and defines
+	static QString getStrippedSource(QString const& path);
+	// (absolute path, last modification) of the file read by
+	// getStrippedSource
+	static std::pair<QString, QDateTime>
+	    getStrippedSourceFile(QString const& path);
+
+	struct ExpandedSource
+	{
+		QString source;
+		// files it was expanded from, to detect changes
+		std::vector<std::pair<QString, QDateTime>> files;
+	};
+
+	// stripped source with includes expanded, before defines
+	static ExpandedSource const& getExpandedSource(QString const& path);
 	static GLuint loadShader(QString const& path, GLenum shaderType,
-	                         QMap<QString, QString> const& defines);
+	                         QString const& source);
 };
 
 #define SETUNIFORM(type)                                            \
@@ -258,6 +258,8 @@ class GLTexture
 	// allocates buff ; don't forget to delete ; returns allocated size (zero if
 	// error)
 	unsigned int getContentAsData(GLfloat** buff, unsigned int level = 0) const;
+	// blocks until the texture is rendered, see LuminanceMeter for an
+	// asynchronous version
 	float getAverageLuminance() const;
 
 	void setSampler(Sampler const& sampler) const;
@@ -19,7 +19,114 @@
 #ifndef PROFILING_HPP
 #define PROFILING_HPP
 
+#include <QMutex>
+#include <QString>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// callgrind instrumentation, needs the program to run within valgrind
 void startProfiling();
 void stopProfiling(bool close = true);
 
+/**
+ * @brief Records how long scoped zones of code take on each thread, to be
+ * viewed as a Chrome trace (chrome://tracing or ui.perfetto.dev).
+ *
+ * Unlike callgrind, it doesn't need valgrind nor slow the program down :
+ * a @ref Zone reads a monotonic clock when constructed and destroyed, then
+ * writes one event in its thread's ring buffer, which only keeps the last
+ * @ref capacity events. Each buffer has its own mutex, only contended while
+ * a trace is being written. When recording is disabled (the default), a
+ * zone costs one relaxed atomic load.
+ *
+ * The buffer of a thread that ended is kept, so that the thread still shows
+ * up in the trace, until a new thread reuses it : the memory used grows with
+ * the number of threads running at once, not with the number of threads
+ * ever started.
+ */
+class CPUProfiler
+{
+  public:
+	class Zone
+	{
+	  public:
+		/**
+		 * @brief Records the time until destruction as @p name, which must
+		 * outlive the profiler (a string literal).
+		 */
+		explicit Zone(char const* name)
+		    : name(CPUProfiler::isEnabled() ? name : nullptr)
+		    , begin(this->name != nullptr ? CPUProfiler::now() : 0){};
+		Zone(Zone const& other) = delete;
+		Zone& operator=(Zone const& other) = delete;
+		~Zone()
+		{
+			if(name != nullptr)
+			{
+				CPUProfiler::record(name, begin, CPUProfiler::now());
+			}
+		};
+
+	  private:
+		char const* name;
+		qint64 begin;
+	};
+
+	CPUProfiler() = delete;
+	static bool isEnabled()
+	{
+		return enabled().load(std::memory_order_relaxed);
+	};
+	/**
+	 * @brief Starts or stops recording. Starting discards the events
+	 * previously recorded.
+	 */
+	static void setEnabled(bool enabled);
+	/**
+	 * @brief Writes the recorded events to @p path as Chrome trace JSON.
+	 *
+	 * Can be called while recording. Returns false if the file couldn't be
+	 * written.
+	 */
+	static bool dumpChromeTrace(QString const& path);
+
+  private:
+	// events kept per thread
+	static const unsigned int capacity = 1 << 16;
+
+	struct Event
+	{
+		char const* name;
+		// in nanoseconds
+		qint64 begin;
+		qint64 end;
+	};
+	struct ThreadBuffer
+	{
+		unsigned int id;
+		QString name;
+		QMutex mutex;
+		std::vector<Event> events;
+		// total events recorded, the last capacity ones are kept
+		quint64 recorded = 0;
+		// false once its thread ended, guarded by buffersMutex
+		bool owned = true;
+	};
+	// gives its thread's buffer back when the thread ends
+	struct BufferHandle
+	{
+		ThreadBuffer* buffer = nullptr;
+		~BufferHandle();
+	};
+
+	static std::atomic<bool>& enabled();
+	static qint64 now();
+	static void record(char const* name, qint64 begin, qint64 end);
+	static ThreadBuffer& threadBuffer();
+	// all the threads' buffers, guarded by buffersMutex
+	static std::vector<std::unique_ptr<ThreadBuffer>>& buffers();
+	static QMutex& buffersMutex();
+};
+
 #endif // PROFILING_HPP
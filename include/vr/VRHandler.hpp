@@ -4,6 +4,7 @@
 #include <QObject>
 #include <QSize>
 
+#include "../SettingsSnapshot.hpp"
 #include "../gl/GLHandler.hpp"
 
 class Controller;
@@ -74,6 +75,7 @@ class VRHandler : public QObject
 	void setStereoMultiplier(double sm)
 	{
 		QSettings().setValue("vr/stereomultiplier", sm);
+		SettingsSnapshot::refresh();
 		stereoMultiplier = sm;
 	};
 	virtual float getFrameTiming() const                     = 0;
@@ -1,5 +1,45 @@
 #include "AbstractMainWin.hpp"
 
+#include <algorithm>
+
+// bloom mip pyramid depth, from half to eighth resolution
+static const unsigned int bloomLevels = 3;
+
+// offline mode renders of a single instant, in case the scene never settles
+static const unsigned int maxSettleRenders = 64;
+
+// filters from (sampled linearly) into to, which is twice smaller or larger
+static void bloomPass(GLComputeShader const& shader,
+                      GLFramebufferObject const& from,
+                      GLFramebufferObject const& to)
+{
+	QSize size(to.getSize());
+	shader.exec({{&from.getColorAttachmentTexture(),
+	              GLComputeShader::DataAccessMode::SAMPLER},
+	             {&to.getColorAttachmentTexture(),
+	              GLComputeShader::DataAccessMode::W}},
+	            {static_cast<unsigned int>(size.width()),
+	             static_cast<unsigned int>(size.height()), 1},
+	            false);
+	GLHandler::glf().glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT
+	                                 | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+}
+
+// copy of e as a Python QKeyEvent, for the key event hooks
+static QVariant pythonKeyEvent(QKeyEvent const& e)
+{
+	QString text(e.text());
+	if(e.key() == Qt::Key_Return || e.key() == Qt::Key_Enter)
+	{
+		text = "\n";
+	}
+	return PythonQtHandler::createObject(
+	    "QKeyEvent", {static_cast<int>(e.type()), e.key(),
+	                  static_cast<int>(e.modifiers()), e.nativeScanCode(),
+	                  e.nativeVirtualKey(), e.nativeModifiers(), text,
+	                  e.isAutoRepeat(), e.count()});
+}
+
 AbstractMainWin::AbstractMainWin()
     : renderer(*this, *vrHandler)
 {
@@ -29,12 +69,14 @@ double AbstractMainWin::getVerticalFOV() const
 void AbstractMainWin::setHorizontalFOV(double fov)
 {
 	QSettings().setValue("graphics/hfov", fov);
+	SettingsSnapshot::refresh();
 	renderer.updateFOV();
 }
 
 void AbstractMainWin::setVerticalFOV(double fov)
 {
 	QSettings().setValue("graphics/vfov", fov);
+	SettingsSnapshot::refresh();
 	renderer.updateFOV();
 }
 
@@ -51,12 +93,14 @@ double AbstractMainWin::getVerticalAngleShift() const
 void AbstractMainWin::setHorizontalAngleShift(double angleShift)
 {
 	QSettings().setValue("network/angleshift", angleShift);
+	SettingsSnapshot::refresh();
 	renderer.updateAngleShiftMat();
 }
 
 void AbstractMainWin::setVerticalAngleShift(double angleShift)
 {
 	QSettings().setValue("network/vangleshift", angleShift);
+	SettingsSnapshot::refresh();
 	renderer.updateAngleShiftMat();
 }
 
@@ -68,6 +112,7 @@ QVector3D AbstractMainWin::getVirtualCamShift() const
 void AbstractMainWin::setVirtualCamShift(QVector3D const& virtualCamShift)
 {
 	QSettings().setValue("vr/virtualcamshift", virtualCamShift);
+	SettingsSnapshot::refresh();
 }
 
 bool AbstractMainWin::isFullscreen() const
@@ -78,6 +123,7 @@ bool AbstractMainWin::isFullscreen() const
 void AbstractMainWin::setFullscreen(bool fullscreen)
 {
 	QSettings().setValue("window/fullscreen", fullscreen);
+	SettingsSnapshot::refresh();
 	if(fullscreen)
 	{
 		QRect screenGeometry(screen()->geometry());
@@ -143,6 +189,7 @@ void AbstractMainWin::setVR(bool vr)
 		    "if \"VRHandler\" in dir():\n\tdel VRHandler");
 	}
 	QSettings().setValue("vr/enabled", vrIsEnabled());
+	SettingsSnapshot::refresh();
 
 	renderer.updateRenderTargets();
 	reloadBloomTargets();
@@ -166,6 +213,31 @@ void AbstractMainWin::takeScreenshot(QString path) const
 	screenshot.save(path);
 }
 
+void AbstractMainWin::setSetting(QString const& key, QVariant const& value)
+{
+	QSettings().setValue(key, value);
+	SettingsSnapshot::refresh();
+}
+
+void AbstractMainWin::toggleCPUTrace()
+{
+	if(!CPUProfiler::isEnabled())
+	{
+		startCPUTrace();
+		qDebug() << "CPU trace started";
+		return;
+	}
+	stopCPUTrace();
+	QString path(
+	    QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation)
+	    + "/trace-"
+	    + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".json");
+	if(dumpCPUTrace(path))
+	{
+		qDebug() << "CPU trace written to" << path;
+	}
+}
+
 bool AbstractMainWin::event(QEvent* e)
 {
 	if(e->type() == QEvent::UpdateRequest)
@@ -218,31 +290,11 @@ void AbstractMainWin::keyPressEvent(QKeyEvent* e)
 	QKeySequence ks(modifier + key);
 	actionEvent(inputManager[ks], true);
 
-	if(!PythonQtHandler::isSupported())
+	if(!PythonQtHandler::hasHook("keyPressEvent"))
 	{
 		return;
 	}
-
-	QString pyKeyEvent("QKeyEvent(");
-	pyKeyEvent += QString::number(e->type()) + ",";
-	pyKeyEvent += QString::number(e->key()) + ",";
-	pyKeyEvent += QString::number(e->modifiers()) + ",";
-	pyKeyEvent += QString::number(e->nativeScanCode()) + ",";
-	pyKeyEvent += QString::number(e->nativeVirtualKey()) + ",";
-	pyKeyEvent += QString::number(e->nativeModifiers()) + ",";
-	if(e->key() != Qt::Key_Return && e->key() != Qt::Key_Enter)
-	{
-		pyKeyEvent += "\"" + e->text().replace('"', "\\\"") + "\",";
-	}
-	else
-	{
-		pyKeyEvent += R"("\n",)";
-	}
-	pyKeyEvent += e->isAutoRepeat() ? "True," : "False,";
-	pyKeyEvent += QString::number(e->count()) + ")";
-
-	PythonQtHandler::evalScript(
-	    "if \"keyPressEvent\" in dir():\n\tkeyPressEvent(" + pyKeyEvent + ")");
+	PythonQtHandler::callHook("keyPressEvent", {pythonKeyEvent(*e)});
 }
 
 void AbstractMainWin::keyReleaseEvent(QKeyEvent* e)
@@ -272,32 +324,11 @@ void AbstractMainWin::keyReleaseEvent(QKeyEvent* e)
 	QKeySequence ks(modifier + key);
 	actionEvent(inputManager[ks], false);
 
-	if(!PythonQtHandler::isSupported())
+	if(!PythonQtHandler::hasHook("keyReleaseEvent"))
 	{
 		return;
 	}
-
-	QString pyKeyEvent("QKeyEvent(");
-	pyKeyEvent += QString::number(e->type()) + ",";
-	pyKeyEvent += QString::number(e->key()) + ",";
-	pyKeyEvent += QString::number(e->modifiers()) + ",";
-	pyKeyEvent += QString::number(e->nativeScanCode()) + ",";
-	pyKeyEvent += QString::number(e->nativeVirtualKey()) + ",";
-	pyKeyEvent += QString::number(e->nativeModifiers()) + ",";
-	if(e->key() != Qt::Key_Return && e->key() != Qt::Key_Enter)
-	{
-		pyKeyEvent += "\"" + e->text().replace('"', "\\\"") + "\",";
-	}
-	else
-	{
-		pyKeyEvent += R"("\n",)";
-	}
-	pyKeyEvent += e->isAutoRepeat() ? "True," : "False,";
-	pyKeyEvent += QString::number(e->count()) + ")";
-
-	PythonQtHandler::evalScript(
-	    "if \"keyReleaseEvent\" in dir():\n\tkeyReleaseEvent(" + pyKeyEvent
-	    + ")");
+	PythonQtHandler::callHook("keyReleaseEvent", {pythonKeyEvent(*e)});
 }
 
 void AbstractMainWin::actionEvent(BaseInputManager::Action a, bool pressed)
@@ -315,6 +346,14 @@ void AbstractMainWin::actionEvent(BaseInputManager::Action a, bool pressed)
 	{
 		toggleWireframe();
 	}
+	else if(a.id == "togglegpuprofiler")
+	{
+		renderer.toggleGPUProfilerOverlay();
+	}
+	else if(a.id == "togglecputrace")
+	{
+		toggleCPUTrace();
+	}
 	else if(a.id == "togglepyconsole")
 	{
 		PythonQtHandler::toggleConsole();
@@ -400,11 +439,9 @@ void AbstractMainWin::actionEvent(BaseInputManager::Action a, bool pressed)
 
 void AbstractMainWin::vrEvent(VRHandler::Event const& e)
 {
-	PythonQtHandler::evalScript(
-	    "if \"vrEvent\" in dir():\n\tvrEvent("
-	    + QString::number(static_cast<int>(e.type)) + ","
-	    + QString::number(static_cast<int>(e.side)) + ", "
-	    + QString::number(static_cast<int>(e.button)) + ")");
+	PythonQtHandler::callHook("vrEvent", {static_cast<int>(e.type),
+	                                      static_cast<int>(e.side),
+	                                      static_cast<int>(e.button)});
 }
 
 void AbstractMainWin::setupPythonAPI()
@@ -428,10 +465,8 @@ void AbstractMainWin::applyPostProcShaderParams(
 	}
 	else
 	{
-		QString pyCmd("if \"applyPostProcShaderParams\" in "
-		              "dir():\n\tapplyPostProcShaderParams(\""
-		              + id + "\"," + shader.toStr() + ")");
-		PythonQtHandler::evalScript(pyCmd);
+		PythonQtHandler::callHook("applyPostProcShaderParams",
+		                          {id, shader.toStr().toUInt()});
 	}
 }
 
@@ -444,27 +479,30 @@ std::vector<std::pair<GLTexture const*, GLComputeShader::DataAccessMode>>
 	{
 		if(bloom)
 		{
-			// high luminosity pass
-			GLComputeShader hlshader("highlumpass");
-			GLHandler::postProcess(hlshader, currentTarget, *bloomTargets[0]);
-
-			// blurring
-			GLComputeShader blurshader("blur");
-			for(unsigned int i = 0; i < 6;
-			    i++) // always execute even number of times
+			// high luminosity is kept while downsampling to half resolution,
+			// then each level is downsampled further and the smallest one is
+			// upsampled back to half resolution ; only the first pass reads a
+			// full resolution image, which was written through image stores
+			GLHandler::glf().glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+			GLFramebufferObject const* from(&currentTarget);
+			for(unsigned int i(0); i < bloomTargets.size(); ++i)
+			{
+				bloomPass(i == 0 ? *bloomHighLumShader : *bloomDownShader,
+				          *from, *bloomTargets[i]);
+				from = bloomTargets[i];
+			}
+			for(unsigned int i(bloomTargets.size() - 1); i > 0; --i)
 			{
-				blurshader.setUniform("dir", i % 2 == 0 ? QVector2D(1, 0)
-				                                        : QVector2D(0, 1));
-				GLHandler::postProcess(blurshader, *bloomTargets.at(i % 2),
-				                       *bloomTargets.at((i + 1) % 2));
+				bloomPass(*bloomUpShader, *bloomTargets[i],
+				          *bloomTargets[i - 1]);
 			}
 
 			return {{&bloomTargets[0]->getColorAttachmentTexture(),
-			         GLComputeShader::DataAccessMode::R}};
+			         GLComputeShader::DataAccessMode::SAMPLER}};
 		}
 		GLHandler::beginRendering(*bloomTargets[0]);
 		return {{&bloomTargets[0]->getColorAttachmentTexture(),
-		         GLComputeShader::DataAccessMode::R}};
+		         GLComputeShader::DataAccessMode::SAMPLER}};
 	}
 	return {};
 }
@@ -506,18 +544,21 @@ void AbstractMainWin::initializeGL()
 	// Init Python engine
 	setupPythonScripts();
 
-	renderer.appendPostProcessingShader("exposure", "exposure");
-	renderer.appendPostProcessingShader("bloom", "bloom");
+	// fused into as few passes as possible, see Renderer::postProcess
+	renderer.appendPostProcessingShader(
+	    "exposure", "exposure", {}, Renderer::PostProcessingFootprint::PIXEL);
+	// bloom's input is also read by its high luminosity pass
+	renderer.appendPostProcessingShader(
+	    "bloom", "bloom", {}, Renderer::PostProcessingFootprint::PIXEL_BARRIER);
 	// make sure gamma correction is applied last
+	QMap<QString, QString> colorsDefines;
 	if(QSettings().value("graphics/dithering").toBool())
 	{
-		renderer.appendPostProcessingShader("colors", "colors",
-		                                    {{"DITHERING", "0"}});
-	}
-	else
-	{
-		renderer.appendPostProcessingShader("colors", "colors");
+		colorsDefines["DITHERING"] = "0";
 	}
+	renderer.appendPostProcessingShader(
+	    "colors", "colors", colorsDefines,
+	    Renderer::PostProcessingFootprint::PIXEL);
 
 	frameTimer.start();
 	initialized = true;
@@ -558,12 +599,14 @@ void AbstractMainWin::setupPythonScripts()
 		PythonQtHandler::evalFile(mainScriptPath);
 	}
 
-	PythonQtHandler::evalScript("if \"initScene\" in dir():\n\tinitScene()");
+	PythonQtHandler::callHook("initScene");
 }
 
 void AbstractMainWin::paintGL()
 {
+	CPUProfiler::Zone zone("paintGL");
 	m_context.makeCurrent(this);
+	GLHandler::beginFrame();
 	if(!initialized)
 	{
 		initializeGL();
@@ -587,6 +630,13 @@ void AbstractMainWin::paintGL()
 			frameTiming_ = vrFT / 1000.f;
 		}
 	}
+	// fixed virtual time step, whatever the real frame time is
+	if(offlinemode)
+	{
+		static const Setting<unsigned int> videoFPS("window/videofps");
+		frameTiming_ = 1.f / std::max(1u, videoFPS.get());
+	}
+	renderer.deterministic = offlinemode;
 
 	auto* nState(networkManager->getNetworkedState());
 	if(nState != nullptr)
@@ -602,8 +652,14 @@ void AbstractMainWin::paintGL()
 		networkManager->update(frameTiming);
 	}
 
+	renderer.setLuminancePercentiles(toneMappingModel->lowpercentile,
+	                                 toneMappingModel->highpercentile);
+	toneMappingModel->setHistogram(renderer.getLastFrameLuminanceHistogram());
 	toneMappingModel->autoUpdateExposure(
-	    renderer.getLastFrameAverageLuminance(), frameTiming);
+	    toneMappingModel->histogramexposure
+	        ? renderer.getLastFrameHistogramAverageLuminance()
+	        : renderer.getLastFrameAverageLuminance(),
+	    frameTiming);
 
 	// handle VR events if any
 	if(vrHandler->isEnabled())
@@ -618,10 +674,23 @@ void AbstractMainWin::paintGL()
 	// let user update before rendering
 	for(auto const& pair : renderer.sceneRenderPipeline)
 	{
+		CPUProfiler::Zone updateZone("updateScene");
 		updateScene(*pair.second.camera, pair.first);
 	}
-	PythonQtHandler::evalScript(
-	    "if \"updateScene\" in dir():\n\tupdateScene()");
+	PythonQtHandler::callHook("updateScene");
+	// non-rendering script work, at its own rate
+	static const Setting<unsigned int> tickRate("scripting/tickrate");
+	float tickPeriod(1.f / std::max(1u, tickRate.get()));
+	scriptTickTime += frameTiming;
+	scriptTickElapsed += frameTiming;
+	if(scriptTickTime >= tickPeriod)
+	{
+		PythonQtHandler::callHook("tickScene", {scriptTickElapsed});
+		scriptTickElapsed = 0.f;
+		// keep to the tick rate, but as there is one tick per frame at most,
+		// don't build up a backlog when frames are longer than a period
+		scriptTickTime = std::min(scriptTickTime - tickPeriod, tickPeriod);
+	}
 
 	if(renderer.getCalibrationCompass())
 	{
@@ -633,6 +702,15 @@ void AbstractMainWin::paintGL()
 
 	// Render frame
 	renderer.renderFrame();
+	// render the same instant again until everything it shows is loaded
+	for(unsigned int i(0); offlinemode && i < maxSettleRenders; ++i)
+	{
+		if(isSceneSettled())
+		{
+			break;
+		}
+		renderer.renderFrame();
+	}
 
 	// garbage collect some resources
 	AsyncTexture::garbageCollect();
@@ -640,7 +718,6 @@ void AbstractMainWin::paintGL()
 
 	if(videomode)
 	{
-		QImage frame(renderer.getLastFrame());
 		QString number
 		    = QString("%1").arg(currentVideoFrame, 5, 10, QChar('0'));
 
@@ -663,21 +740,23 @@ void AbstractMainWin::paintGL()
 
 		QString res = QString::number(renderer.getSize().width()) + "x"
 		              + QString::number(renderer.getSize().height());
-		if(currentVideoFrame == 0)
+		if(videoSink == nullptr)
 		{
-			QDir viddir(QSettings().value("window/viddir").toString());
-			viddir.mkdir(subdir);
-			QDir projdir(QSettings().value("window/viddir").toString() + "/"
-			             + subdir);
-			projdir.mkdir(res);
+			QString dir(QSettings().value("window/viddir").toString() + "/"
+			            + subdir + "/" + res);
+			QDir().mkpath(dir);
+			videoSink = FrameSink::fromSettings(dir, renderer.getSize());
 		}
-
-		QString framePath(QSettings().value("window/viddir").toString() + "/"
-		                  + subdir + "/" + res + "/frame" + number + ".png");
-		QThreadPool::globalInstance()->start(new ImageWriter(framePath, frame));
+		renderer.captureLastFrame(*videoSink, "frame" + number);
+		videoStats = videoSink->getStats();
 
 		currentVideoFrame++;
 	}
+	else if(videoSink != nullptr)
+	{
+		closeVideoSink();
+	}
+	PythonQtHandler::endFrame();
 
 	// Trigger a repaint immediatly
 	m_context.swapBuffers(this);
@@ -685,21 +764,32 @@ void AbstractMainWin::paintGL()
 
 AbstractMainWin::~AbstractMainWin()
 {
+	if(videoSink != nullptr)
+	{
+		closeVideoSink();
+	}
 	delete networkManager;
 	delete toneMappingModel;
-	delete bloomTargets[0];
-	delete bloomTargets[1];
+	cleanBloom();
 
 	// force garbage collect some resources
 	AsyncTexture::garbageCollect(true);
 	AsyncMesh::garbageCollect(true);
 
-	PythonQtHandler::evalScript(
-	    "if \"cleanUpScene\" in dir():\n\tcleanUpScene()");
+	PythonQtHandler::callHook("cleanUpScene");
 	renderer.clean();
 	vrHandler->close();
 	PythonQtHandler::clean();
 	delete vrHandler;
+	GLHandler::clean();
+}
+
+void AbstractMainWin::closeVideoSink()
+{
+	// let the sink write the last captured frames
+	renderer.flushCapturedFrames();
+	delete videoSink;
+	videoSink = nullptr;
 }
 
 void AbstractMainWin::reloadBloomTargets()
@@ -708,21 +798,40 @@ void AbstractMainWin::reloadBloomTargets()
 	{
 		return;
 	}
-	delete bloomTargets[0];
-	delete bloomTargets[1];
-	if(!vrHandler->isEnabled())
+	cleanBloom();
+
+	QSize size(vrHandler->isEnabled() ? vrHandler->getEyeRenderTargetSize()
+	                                  : QSize(width(), height()));
+	for(unsigned int i(0); i < bloomLevels; ++i)
 	{
-		bloomTargets[0] = new GLFramebufferObject(
-		    GLTexture::Tex2DProperties(width(), height(), GL_RGBA32F));
-		bloomTargets[1] = new GLFramebufferObject(
-		    GLTexture::Tex2DProperties(width(), height(), GL_RGBA32F));
+		size = QSize(std::max(1, size.width() / 2),
+		             std::max(1, size.height() / 2));
+		// sampled linearly by the next pass
+		bloomTargets.push_back(new GLFramebufferObject(
+		    GLTexture::Tex2DProperties(size.width(), size.height(), GL_RGBA32F),
+		    {GL_LINEAR, GL_CLAMP_TO_EDGE}));
 	}
-	else
+
+	QMap<QString, QString> defines;
+	defines["QUALITY"] = QString::number(
+	    QSettings().value("graphics/bloomquality").toUInt());
+	bloomDownShader = new GLComputeShader("bloomdown", defines);
+	bloomUpShader   = new GLComputeShader("bloomup", defines);
+	defines["HIGHLUM"] = "";
+	bloomHighLumShader = new GLComputeShader("bloomdown", defines);
+}
+
+void AbstractMainWin::cleanBloom()
+{
+	for(auto target : bloomTargets)
 	{
-		QSize size(vrHandler->getEyeRenderTargetSize());
-		bloomTargets[0] = new GLFramebufferObject(GLTexture::Tex2DProperties(
-		    size.width(), size.height(), GL_RGBA32F));
-		bloomTargets[1] = new GLFramebufferObject(GLTexture::Tex2DProperties(
-		    size.width(), size.height(), GL_RGBA32F));
+		delete target;
 	}
+	bloomTargets.clear();
+	delete bloomHighLumShader;
+	delete bloomDownShader;
+	delete bloomUpShader;
+	bloomHighLumShader = nullptr;
+	bloomDownShader    = nullptr;
+	bloomUpShader      = nullptr;
 }
@@ -18,6 +18,8 @@
 
 #include "AssetLoader.hpp"
 
+#include "profiling.hpp"
+
 std::vector<AssetLoader::TextureType> const& AssetLoader::textureTypes()
 {
 	static std::vector<TextureType> textureTypes
@@ -39,6 +41,7 @@ std::vector<aiTextureType> const& AssetLoader::assimpTextureTypes()
 float AssetLoader::loadFile(QString modelName,
                             std::vector<MeshDescriptor>& meshDescriptors)
 {
+	CPUProfiler::Zone zone("asset loading");
 	meshDescriptors.resize(0);
 	if(!modelName.contains('/'))
 	{
@@ -78,6 +81,7 @@ void AssetLoader::loadModel(std::vector<MeshDescriptor> const& meshDescriptors,
                             GLShaderProgram const& shader,
                             QColor const& defaultDiffuseColor)
 {
+	CPUProfiler::Zone zone("asset upload");
 	for(auto const& descriptor : meshDescriptors)
 	{
 		TexturedMesh tMesh;
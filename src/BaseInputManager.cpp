@@ -23,6 +23,10 @@ BaseInputManager::BaseInputManager()
 	addAction(Qt::Key_F1, {"toggledbgcam", tr("Toggle Debug Camera")}, true);
 	addAction(Qt::Key_F2, {"togglewireframe", tr("Toggle Wireframe Mode")},
 	          true);
+	addAction(Qt::Key_F3,
+	          {"togglegpuprofiler", tr("Toggle GPU Profiler Overlay")}, true);
+	addAction(Qt::Key_F4, {"togglecputrace", tr("Start/Stop CPU Trace")},
+	          true);
 	addAction(Qt::Key_F8, {"togglepyconsole", tr("Toggle Python Console")},
 	          true);
 	addAction(Qt::Key_F10, {"screenshot", tr("Take Screenshot")}, true);
@@ -66,6 +66,7 @@ void BaseLauncher::resetSettings()
 		return;
 	}
 	QSettings().clear();
+	SettingsSnapshot::refresh();
 	SettingsWidget* oldWidget(settingsWidget);
 	settingsWidget = newSettingsWidget();
 	mainLayout->replaceWidget(oldWidget, settingsWidget);
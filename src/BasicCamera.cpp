@@ -1,5 +1,7 @@
 #include "BasicCamera.hpp"
 
+#include "MainRenderTarget.hpp"
+
 BasicCamera::BasicCamera(VRHandler const& vrHandler)
     : vrHandler(vrHandler)
     , eyeDistanceFactor(1.0f)
@@ -136,6 +138,29 @@ void BasicCamera::uploadMatrices() const
 
 void BasicCamera::updateClippingPlanes()
 {
+	// points projected directly aren't limited by a frustum, fullTransform
+	// is only the view
+	auto direct(static_cast<MainRenderTarget::Projection>(
+	    GLHandler::getDirectProjection()));
+	if(direct == MainRenderTarget::Projection::PANORAMA360)
+	{
+		clippingPlanes.fill(Plane(0.f, 0.f, 0.f, 1.f));
+		return;
+	}
+	if(direct == MainRenderTarget::Projection::DOMEMASTER180)
+	{
+		// the -z half space, as side planes because near and far ones are
+		// ignored with depth clamping
+		clippingPlanes.fill(Plane(0.f, 0.f, 0.f, 1.f));
+		Plane hemisphere(-1.f * fullTransform.row(2));
+		hemisphere /= QVector3D(hemisphere).length();
+		clippingPlanes[LEFT_PLANE]   = hemisphere;
+		clippingPlanes[RIGHT_PLANE]  = hemisphere;
+		clippingPlanes[BOTTOM_PLANE] = hemisphere;
+		clippingPlanes[TOP_PLANE]    = hemisphere;
+		return;
+	}
+
 	// update clipping planes
 	// Gribb, G., & Hartmann, K. (2001). Fast extraction of viewing frustum
 	// planes from the world-view-projection matrix.
@@ -214,6 +239,19 @@ QMatrix4x4 BasicCamera::screenToWorldTransform() const
 
 float BasicCamera::pixelSolidAngle() const
 {
+	// at the equator or zenith, see projection.glsl
+	auto direct(static_cast<MainRenderTarget::Projection>(
+	    GLHandler::getDirectProjection()));
+	QSize directSize(GLHandler::getDirectProjectionSize());
+	if(direct == MainRenderTarget::Projection::PANORAMA360)
+	{
+		return 2.0 * M_PI * M_PI / (directSize.width() * directSize.height());
+	}
+	if(direct == MainRenderTarget::Projection::DOMEMASTER180)
+	{
+		return M_PI * M_PI / (directSize.width() * directSize.height());
+	}
+
 	QMatrix4x4 p(vrHandler.isEnabled()
 	                 ? vrHandler.getProjectionMatrix(
 	                       Side::LEFT, 0.1f * eyeDistanceFactor,
@@ -18,6 +18,8 @@
 
 #include "DebugCamera.hpp"
 
+#include "SettingsSnapshot.hpp"
+
 DebugCamera::DebugCamera(VRHandler const& vrHandler)
     : BasicCamera(vrHandler)
     , camMeshShader("default")
@@ -54,7 +56,7 @@ DebugCamera::DebugCamera(VRHandler const& vrHandler)
 void DebugCamera::update(QMatrix4x4 const& angleShiftMat)
 {
 	// act as a 2D camera if we debug from screen only
-	if(!QSettings().value("debugcamera/debuginheadset").toBool())
+	if(!debugInHeadset())
 	{
 		BasicCamera::update2D(angleShiftMat);
 	}
@@ -87,12 +89,14 @@ void DebugCamera::renderCamera(BasicCamera const* cam)
 
 bool DebugCamera::isEnabled() const
 {
-	return QSettings().value("debugcamera/enabled").toBool();
+	static const Setting<bool> setting("debugcamera/enabled");
+	return setting.get();
 }
 
 void DebugCamera::setEnabled(bool enabled)
 {
 	QSettings().setValue("debugcamera/enabled", enabled);
+	SettingsSnapshot::refresh();
 }
 
 void DebugCamera::toggle()
@@ -102,12 +106,14 @@ void DebugCamera::toggle()
 
 bool DebugCamera::debugInHeadset() const
 {
-	return QSettings().value("debugcamera/debuginheadset").toBool();
+	static const Setting<bool> setting("debugcamera/debuginheadset");
+	return setting.get();
 }
 
 void DebugCamera::setDebugInHeadset(bool debuginheadset)
 {
 	QSettings().setValue("debugcamera/debuginheadset", debuginheadset);
+	SettingsSnapshot::refresh();
 }
 
 void DebugCamera::toggleDebugInHeadset()
@@ -117,12 +123,14 @@ void DebugCamera::toggleDebugInHeadset()
 
 bool DebugCamera::followHMD() const
 {
-	return QSettings().value("debugcamera/followhmd").toBool();
+	static const Setting<bool> setting("debugcamera/followhmd");
+	return setting.get();
 }
 
 void DebugCamera::setFollowHMD(bool followhmd)
 {
 	QSettings().setValue("debugcamera/followhmd", followhmd);
+	SettingsSnapshot::refresh();
 }
 
 void DebugCamera::toggleFollowHMD()
@@ -0,0 +1,110 @@
+/*
+    Copyright (C) 2020 Florian Cabot <florian.cabot@hotmail.fr>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "DynamicResolution.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// the scale changes by multiples of 1 / scaleSteps
+static const float scaleSteps = 20.f;
+// fraction of the wanted scale change applied each measured frame, wanted
+// changes below 1 / (2 * damping * scaleSteps) are ignored
+static const float damping = 0.5f;
+
+DynamicResolution::DynamicResolution()
+    : enabled(QSettings().value("graphics/dynamicresolution").toBool())
+    , budget(QSettings().value("graphics/framebudget").toUInt())
+    , minScale(QSettings().value("graphics/minrenderscale").toUInt() / 100.f)
+{
+	budget   = std::max(1.f, budget);
+	minScale = std::max(0.1f, std::min(minScale, 1.f));
+	GLHandler::glf().glGenQueries(latency, &queries[0]);
+}
+
+void DynamicResolution::setEnabled(bool enabled)
+{
+	this->enabled = enabled;
+	if(!enabled)
+	{
+		scale = 1.f;
+	}
+}
+
+void DynamicResolution::beginFrame()
+{
+	unsigned int slot(frame % latency);
+	measuring = true;
+	if(pending.at(slot))
+	{
+		GLint available(GL_FALSE);
+		GLHandler::glf().glGetQueryObjectiv(
+		    queries.at(slot), GL_QUERY_RESULT_AVAILABLE, &available);
+		if(available == GL_FALSE)
+		{
+			// never stall, this frame won't be measured
+			measuring = false;
+			return;
+		}
+		GLuint64 elapsed(0);
+		GLHandler::glf().glGetQueryObjectui64v(queries.at(slot),
+		                                       GL_QUERY_RESULT, &elapsed);
+		pending.at(slot) = false;
+		update(elapsed * 1.e-6f);
+	}
+	GLHandler::glf().glBeginQuery(GL_TIME_ELAPSED, queries.at(slot));
+}
+
+void DynamicResolution::endFrame()
+{
+	if(!measuring)
+	{
+		return;
+	}
+	GLHandler::glf().glEndQuery(GL_TIME_ELAPSED);
+	pending.at(frame % latency) = true;
+	++frame;
+	measuring = false;
+}
+
+QSize DynamicResolution::scaledSize(QSize const& size) const
+{
+	return {std::max(1, static_cast<int>(std::round(size.width() * scale))),
+	        std::max(1, static_cast<int>(std::round(size.height() * scale)))};
+}
+
+void DynamicResolution::update(float frameTime)
+{
+	lastFrameTime = frameTime;
+	if(!enabled || frameTime <= 0.f)
+	{
+		return;
+	}
+
+	float wanted(scale * std::sqrt(budget / frameTime));
+	wanted = std::max(minScale, std::min(wanted, 1.f));
+	float damped(scale + damping * (wanted - scale));
+	// only move by whole steps
+	float stepped(std::round(damped * scaleSteps) / scaleSteps);
+	scale = std::max(minScale, std::min(stepped, 1.f));
+}
+
+DynamicResolution::~DynamicResolution()
+{
+	GLHandler::glf().glDeleteQueries(latency, &queries[0]);
+}
@@ -0,0 +1,165 @@
+/*
+    Copyright (C) 2020 Florian Cabot <florian.cabot@hotmail.fr>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "FrameCapture.hpp"
+
+#include <QDebug>
+#include <QThreadPool>
+#include <algorithm>
+#include <cstring>
+
+#include "gl/GLHandler.hpp"
+
+FrameCapture::FrameCapture(unsigned int depth)
+{
+	for(unsigned int i(0); i < std::max(1u, depth); ++i)
+	{
+		slots.emplace_back(new Slot);
+	}
+}
+
+void FrameCapture::capture(GLFramebufferObject const& target,
+                           FrameSink& sink, QString const& name)
+{
+	update();
+
+	Slot& slot(*slots.at(next));
+	// all buffers in flight, wait for the oldest one
+	while(!advance(slot, true))
+	{
+	}
+
+	slot.size = target.getSize();
+	slot.sink = &sink;
+	slot.name = name;
+	target.copyColorBufferToBuffer(slot.buffer);
+	slot.fence
+	    = GLHandler::glf().glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	// make sure the fence gets to the GPU even if we don't render anymore
+	GLHandler::glf().glFlush();
+	slot.state = State::READING;
+
+	next = (next + 1) % slots.size();
+}
+
+void FrameCapture::update()
+{
+	// oldest first, so that frames are pushed in order
+	for(unsigned int i(0); i < slots.size(); ++i)
+	{
+		Slot& slot(*slots.at((next + i) % slots.size()));
+		while(slot.state != State::FREE)
+		{
+			if(!advance(slot, false))
+			{
+				return;
+			}
+		}
+	}
+}
+
+void FrameCapture::flush()
+{
+	for(unsigned int i(0); i < slots.size(); ++i)
+	{
+		Slot& slot(*slots.at((next + i) % slots.size()));
+		while(!advance(slot, true))
+		{
+		}
+	}
+}
+
+bool FrameCapture::advance(Slot& slot, bool wait)
+{
+	switch(slot.state)
+	{
+		case State::FREE:
+			return true;
+		case State::READING:
+		{
+			GLenum status(GLHandler::glf().glClientWaitSync(
+			    slot.fence, 0, wait ? 1000000000 : 0));
+			if(status == GL_WAIT_FAILED)
+			{
+				// would never signal, e.g. after a context loss
+				qWarning() << "Could not wait for frame" << slot.name;
+				GLHandler::glf().glDeleteSync(slot.fence);
+				slot.fence = nullptr;
+				slot.state = State::FREE;
+				return true;
+			}
+			if(status != GL_ALREADY_SIGNALED
+			   && status != GL_CONDITION_SATISFIED)
+			{
+				return false;
+			}
+			GLHandler::glf().glDeleteSync(slot.fence);
+			slot.fence = nullptr;
+
+			auto data(static_cast<uchar const*>(slot.buffer.map(GL_READ_ONLY)));
+			slot.buffer.unbind();
+			if(data == nullptr)
+			{
+				qWarning() << "Could not read frame back for" << slot.name;
+				slot.buffer.unmap();
+				slot.buffer.unbind();
+				slot.state = State::FREE;
+				return true;
+			}
+			slot.state = State::COPYING;
+			QThreadPool::globalInstance()->start(new Copier(slot, data));
+			return false;
+		}
+		case State::COPYING:
+			if(wait)
+			{
+				slot.copied.acquire();
+			}
+			else if(!slot.copied.tryAcquire())
+			{
+				return false;
+			}
+			slot.buffer.unmap();
+			slot.buffer.unbind();
+			slot.sink->push(slot.image, slot.name);
+			slot.image = QImage();
+			slot.state = State::FREE;
+			return true;
+	}
+	return true;
+}
+
+FrameCapture::~FrameCapture()
+{
+	flush();
+}
+
+void FrameCapture::Copier::run()
+{
+	// OpenGL rows go from bottom to top
+	QSize size(slot.size);
+	QImage image(size, QImage::Format_RGBA8888);
+	auto rowSize(static_cast<size_t>(size.width()) * 4);
+	for(int y(0); y < size.height(); ++y)
+	{
+		std::memcpy(image.scanLine(size.height() - 1 - y),
+		            data + y * rowSize, rowSize);
+	}
+	slot.image = image;
+	slot.copied.release();
+}
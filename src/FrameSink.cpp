@@ -0,0 +1,464 @@
+/*
+    Copyright (C) 2020 Florian Cabot <florian.cabot@hotmail.fr>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "FrameSink.hpp"
+
+#include "profiling.hpp"
+
+#include <QDebug>
+#include <QFile>
+#include <QSettings>
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+bool FrameSink::push(QImage const& frame, QString const& name)
+{
+	QMutexLocker lock(&mutex);
+	if(!timer.isValid())
+	{
+		timer.start();
+	}
+	while(!closing && queue.size() >= queueSize)
+	{
+		if(dropWhenFull)
+		{
+			++stats.dropped;
+			return false;
+		}
+		notFull.wait(&mutex);
+	}
+	if(closing)
+	{
+		++stats.dropped;
+		return false;
+	}
+	queue.push_back({frame, name});
+	notEmpty.wakeOne();
+	return true;
+}
+
+FrameSink::Stats FrameSink::getStats() const
+{
+	QMutexLocker lock(&mutex);
+	Stats result(stats);
+	float seconds(timer.isValid() ? timer.elapsed() / 1000.f : 0.f);
+	if(seconds > 0.f)
+	{
+		result.framesPerSecond    = stats.written / seconds;
+		result.megabytesPerSecond = bytes / (1024.f * 1024.f * seconds);
+	}
+	return result;
+}
+
+void FrameSink::close()
+{
+	{
+		QMutexLocker lock(&mutex);
+		closing = true;
+		notEmpty.wakeAll();
+		notFull.wakeAll();
+	}
+	for(auto& consumer : consumers)
+	{
+		consumer->wait();
+	}
+	consumers.clear();
+}
+
+FrameSink* FrameSink::fromSettings(QString const& dir, QSize const& size)
+{
+	QSettings settings;
+	QString format(settings.value("window/videoformat").toString().toLower());
+	unsigned int queueSize(settings.value("window/videoqueue").toUInt());
+	bool dropWhenFull(settings.value("window/videodropframes").toBool());
+
+	if(format == "y4m" || format == "raw")
+	{
+		return new PipeSink(
+		    settings.value("window/videocommand").toString(), dir,
+		    format == "y4m" ? PipeSink::Format::Y4M : PipeSink::Format::RAW,
+		    size, settings.value("window/videofps").toUInt(), queueSize,
+		    dropWhenFull);
+	}
+	if(format != "png" && format != "qoi")
+	{
+		qWarning() << "Unknown video format" << format << ", using png";
+	}
+	return new ImageSequenceSink(dir,
+	                             format == "qoi"
+	                                 ? ImageSequenceSink::Format::QOI
+	                                 : ImageSequenceSink::Format::PNG,
+	                             queueSize, dropWhenFull);
+}
+
+FrameSink::FrameSink(unsigned int queueSize, bool dropWhenFull)
+    : queueSize(std::max(1u, queueSize))
+    , dropWhenFull(dropWhenFull)
+{
+}
+
+void FrameSink::start(unsigned int threadsCount)
+{
+	for(unsigned int i(0); i < std::max(1u, threadsCount); ++i)
+	{
+		consumers.emplace_back(new Consumer(*this));
+		consumers.back()->start();
+	}
+}
+
+void FrameSink::Consumer::run()
+{
+	sink.consume();
+}
+
+void FrameSink::consume()
+{
+	QMutexLocker lock(&mutex);
+	for(;;)
+	{
+		while(queue.empty() && !closing)
+		{
+			notEmpty.wait(&mutex);
+		}
+		if(queue.empty())
+		{
+			// closing and everything is written
+			break;
+		}
+		Frame frame(queue.front());
+		queue.pop_front();
+		notFull.wakeOne();
+
+		lock.unlock();
+		qint64 written(0);
+		{
+			CPUProfiler::Zone zone("frame sink write");
+			written = write(frame.image, frame.name);
+		}
+		lock.relock();
+
+		if(written < 0)
+		{
+			++stats.dropped;
+		}
+		else
+		{
+			++stats.written;
+			bytes += written;
+		}
+	}
+	lock.unlock();
+	finish();
+}
+
+ImageSequenceSink::ImageSequenceSink(QString const& dir, Format format,
+                                     unsigned int queueSize,
+                                     bool dropWhenFull)
+    : FrameSink(queueSize, dropWhenFull)
+    , dir(dir)
+    , format(format)
+{
+	// leave a core to the rendering
+	start(QThread::idealThreadCount() - 1);
+}
+
+// see https://qoiformat.org/qoi-specification.pdf
+QByteArray ImageSequenceSink::encodeQOI(QImage const& image)
+{
+	QImage rgba(image.convertToFormat(QImage::Format_RGBA8888));
+	auto width(static_cast<quint32>(rgba.width()));
+	auto height(static_cast<quint32>(rgba.height()));
+
+	// header, worst case of 5 bytes per pixel, end marker
+	QByteArray result(14 + width * height * 5 + 8, Qt::Uninitialized);
+	auto out(reinterpret_cast<uchar*>(result.data()));
+	auto put32 = [&out](quint32 value) {
+		for(int shift(24); shift >= 0; shift -= 8)
+		{
+			*out++ = static_cast<uchar>(value >> shift);
+		}
+	};
+	std::memcpy(out, "qoif", 4);
+	out += 4;
+	put32(width);
+	put32(height);
+	*out++ = 4; // RGBA
+	*out++ = 0; // sRGB with linear alpha
+
+	std::array<std::array<uchar, 4>, 64> index = {};
+	std::array<uchar, 4> previous = {{0, 0, 0, 255}};
+	unsigned int run(0);
+	for(quint32 y(0); y < height; ++y)
+	{
+		uchar const* line(rgba.constScanLine(y));
+		for(quint32 x(0); x < width; ++x)
+		{
+			std::array<uchar, 4> pixel
+			    = {{line[4 * x], line[4 * x + 1], line[4 * x + 2],
+			        line[4 * x + 3]}};
+			bool last(y == height - 1 && x == width - 1);
+			if(pixel == previous)
+			{
+				++run;
+				if(run == 62 || last)
+				{
+					*out++ = 0xc0 | (run - 1); // QOI_OP_RUN
+					run    = 0;
+				}
+				continue;
+			}
+			if(run > 0)
+			{
+				*out++ = 0xc0 | (run - 1); // QOI_OP_RUN
+				run    = 0;
+			}
+
+			unsigned int hash((pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7
+			                   + pixel[3] * 11)
+			                  % 64);
+			if(index.at(hash) == pixel)
+			{
+				*out++ = hash; // QOI_OP_INDEX
+			}
+			else if(pixel[3] != previous[3])
+			{
+				index.at(hash) = pixel;
+				*out++         = 0xff; // QOI_OP_RGBA
+				std::memcpy(out, &pixel[0], 4);
+				out += 4;
+			}
+			else
+			{
+				index.at(hash) = pixel;
+				auto dr(static_cast<signed char>(pixel[0] - previous[0]));
+				auto dg(static_cast<signed char>(pixel[1] - previous[1]));
+				auto db(static_cast<signed char>(pixel[2] - previous[2]));
+				int drg(dr - dg), dbg(db - dg);
+				if(dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2
+				   && db <= 1)
+				{
+					// QOI_OP_DIFF
+					*out++ = 0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2);
+				}
+				else if(dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7
+				        && dbg >= -8 && dbg <= 7)
+				{
+					// QOI_OP_LUMA
+					*out++ = 0x80 | (dg + 32);
+					*out++ = (drg + 8) << 4 | (dbg + 8);
+				}
+				else
+				{
+					*out++ = 0xfe; // QOI_OP_RGB
+					std::memcpy(out, &pixel[0], 3);
+					out += 3;
+				}
+			}
+			previous = pixel;
+		}
+	}
+	std::memcpy(out, "\0\0\0\0\0\0\0\1", 8);
+	out += 8;
+
+	result.resize(out - reinterpret_cast<uchar*>(result.data()));
+	return result;
+}
+
+qint64 ImageSequenceSink::write(QImage const& frame, QString const& name)
+{
+	QFile file(dir + "/" + name
+	           + (format == Format::QOI ? ".qoi" : ".png"));
+	if(!file.open(QFile::WriteOnly))
+	{
+		qWarning() << "Could not write frame" << file.fileName();
+		return -1;
+	}
+	if(format == Format::QOI)
+	{
+		QByteArray data(encodeQOI(frame));
+		if(file.write(data) != data.size())
+		{
+			qWarning() << "Could not write frame" << file.fileName();
+			return -1;
+		}
+		return data.size();
+	}
+	// Qt's PNG handler maps quality 80 to zlib level 1, its fastest
+	if(!frame.save(&file, "png", 80))
+	{
+		qWarning() << "Could not write frame" << file.fileName();
+		return -1;
+	}
+	return file.pos();
+}
+
+ImageSequenceSink::~ImageSequenceSink()
+{
+	close();
+}
+
+PipeSink::PipeSink(QString const& command, QString const& workingDir,
+                   Format format, QSize const& size, unsigned int fps,
+                   unsigned int queueSize, bool dropWhenFull)
+    : FrameSink(queueSize, dropWhenFull)
+    , command(command)
+    , workingDir(workingDir)
+    , format(format)
+    , size(size)
+    , fps(std::max(1u, fps))
+{
+	// frames must stay in order
+	start(1);
+}
+
+qint64 PipeSink::write(QImage const& frame, QString const& /*name*/)
+{
+	if(frame.size() != size)
+	{
+		qWarning() << "Video frame size changed, dropping frame";
+		return -1;
+	}
+	if(process == nullptr && !startProcess())
+	{
+		return -1;
+	}
+
+	if(format == Format::RAW)
+	{
+		QImage rgba(frame.convertToFormat(QImage::Format_RGBA8888));
+		buffer.resize(4 * size.width() * size.height());
+		for(int y(0); y < size.height(); ++y)
+		{
+			std::memcpy(buffer.data() + 4 * y * size.width(),
+			            rgba.constScanLine(y), 4 * size.width());
+		}
+	}
+	else
+	{
+		encodeY4MFrame(frame, buffer);
+	}
+
+	if(process->write(buffer) != buffer.size())
+	{
+		qWarning() << "Could not write frame to" << command;
+		return -1;
+	}
+	while(process->bytesToWrite() > 0)
+	{
+		if(!process->waitForBytesWritten(-1))
+		{
+			qWarning() << "Could not write frame to" << command << ":"
+			           << process->errorString();
+			return -1;
+		}
+	}
+	return buffer.size();
+}
+
+void PipeSink::encodeY4MFrame(QImage const& frame, QByteArray& out)
+{
+	QImage rgba(frame.convertToFormat(QImage::Format_RGBA8888));
+	int width(rgba.width()), height(rgba.height());
+	int pixels(width * height);
+
+	// planar Y, Cb, Cr
+	out.resize(6 + 3 * pixels);
+	std::memcpy(out.data(), "FRAME\n", 6);
+	auto luma(reinterpret_cast<uchar*>(out.data()) + 6);
+	uchar* cb(luma + pixels);
+	uchar* cr(cb + pixels);
+	for(int y(0); y < height; ++y)
+	{
+		uchar const* line(rgba.constScanLine(y));
+		for(int x(0); x < width; ++x)
+		{
+			float r(line[4 * x] / 255.f), g(line[4 * x + 1] / 255.f),
+			    b(line[4 * x + 2] / 255.f);
+			float l(0.2126f * r + 0.7152f * g + 0.0722f * b);
+			int i(y * width + x);
+			luma[i] = static_cast<uchar>(16.f + 219.f * l + 0.5f);
+			cb[i] = static_cast<uchar>(128.f + 224.f * (b - l) / 1.8556f
+			                           + 0.5f);
+			cr[i] = static_cast<uchar>(128.f + 224.f * (r - l) / 1.5748f
+			                           + 0.5f);
+		}
+	}
+}
+
+void PipeSink::finish()
+{
+	if(process == nullptr)
+	{
+		return;
+	}
+	// the encoder finalizes its output at the end of its input
+	process->closeWriteChannel();
+	process->waitForFinished(-1);
+	if(process->exitStatus() != QProcess::NormalExit
+	   || process->exitCode() != 0)
+	{
+		qWarning() << command << "exited with code" << process->exitCode();
+	}
+	delete process;
+	process = nullptr;
+}
+
+bool PipeSink::startProcess()
+{
+	if(failed)
+	{
+		return false;
+	}
+	QString cmd(command);
+	cmd.replace("%w", QString::number(size.width()));
+	cmd.replace("%h", QString::number(size.height()));
+	cmd.replace("%r", QString::number(fps));
+
+	process = new QProcess;
+	process->setWorkingDirectory(workingDir);
+	// let the encoder log in our output
+	process->setProcessChannelMode(QProcess::ForwardedChannels);
+	process->start(cmd, QIODevice::WriteOnly);
+	if(!process->waitForStarted(-1))
+	{
+		qWarning() << "Could not start" << cmd << ":"
+		           << process->errorString();
+		delete process;
+		process = nullptr;
+		failed  = true;
+		return false;
+	}
+
+	if(format == Format::Y4M)
+	{
+		QByteArray header(QString("YUV4MPEG2 W%1 H%2 F%3:1 Ip A1:1 C444 "
+		                          "XCOLORRANGE=LIMITED\n")
+		                      .arg(size.width())
+		                      .arg(size.height())
+		                      .arg(fps)
+		                      .toLatin1());
+		process->write(header);
+	}
+	return true;
+}
+
+PipeSink::~PipeSink()
+{
+	close();
+}
@@ -18,6 +18,12 @@
 
 #include "Logger.hpp"
 
+#include <QSettings>
+#include <chrono>
+
+// sources are forgotten after this long without any message, in ms
+static const qint64 rateWindowLifetime = 10000;
+
 std::ofstream& Logger::logFile()
 {
 	static std::ofstream logFile;
@@ -29,13 +35,26 @@ void Logger::init()
 	logFile().open("log.txt", std::ofstream::out | std::ofstream::trunc);
 	logFile() << QDateTime::currentDateTime().toString().toStdString()
 	          << std::endl;
+	state().running = true;
+	state().writer  = std::thread(run);
 	qInstallMessageHandler(log);
 }
 
+void Logger::readSettings()
+{
+	QSettings settings;
+	state().minSeverity = settings.value("log/level", 0).toInt();
+	state().rateLimit   = settings.value("log/ratelimit", 20).toUInt();
+}
+
 void Logger::log(QtMsgType type, const QMessageLogContext& context,
                  const QString& msg)
 {
-	QByteArray localMsg   = msg.toLocal8Bit();
+	if(type != QtFatalMsg && severity(type) < state().minSeverity)
+	{
+		return;
+	}
+
 	const char* file      = context.file != nullptr ? context.file : "";
 	const char* shortFile = file;
 	if(strlen(shortFile) > strlen(BUILD_SRC_DIR) + 1)
@@ -44,6 +63,256 @@ void Logger::log(QtMsgType type, const QMessageLogContext& context,
 	}
 	const char* function = context.function != nullptr ? context.function : "";
 
+	Message message;
+	message.type   = type;
+	message.time   = now();
+	message.header = QByteArray(" (") + shortFile + ":"
+	                 + QByteArray::number(context.line) + ", " + function
+	                 + "):";
+	message.text   = msg.toLocal8Bit();
+	// without context (release builds), only identical messages are limited
+	message.source = context.line != 0 ? message.header : message.text;
+
+	if(type == QtFatalMsg || !state().running)
+	{
+		// Qt aborts right after fatal messages, keep the order but don't
+		// wait for the writer forever
+		auto deadline(std::chrono::steady_clock::now()
+		              + std::chrono::seconds(1));
+		while(state().running
+		      && state().dequeuePos.load() != state().enqueuePos.load()
+		      && std::chrono::steady_clock::now() < deadline)
+		{
+			std::this_thread::yield();
+		}
+		QMutexLocker lock(&state().writeMutex);
+		write(message);
+		logFile().flush();
+		std::cerr.flush();
+		return;
+	}
+
+	if(!push(std::move(message)))
+	{
+		++state().dropped;
+	}
+}
+
+void Logger::close()
+{
+	if(state().running.exchange(false))
+	{
+		state().writer.join();
+	}
+	// messages pushed while the writer was stopping
+	drain();
+	logFile().close();
+}
+
+Logger::State& Logger::state()
+{
+	// never destroyed, messages can be logged during static destruction
+	static State* state([]() {
+		auto state(new State);
+		for(unsigned int i(0); i < capacity; ++i)
+		{
+			state->slots.at(i).sequence = i;
+		}
+		return state;
+	}());
+	return *state;
+}
+
+int Logger::severity(QtMsgType type)
+{
+	switch(type)
+	{
+		case QtDebugMsg:
+			return 0;
+		case QtInfoMsg:
+			return 1;
+		case QtWarningMsg:
+			return 2;
+		case QtCriticalMsg:
+			return 3;
+		case QtFatalMsg:
+			return 4;
+	}
+	return 0;
+}
+
+qint64 Logger::now()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(
+	           std::chrono::steady_clock::now().time_since_epoch())
+	    .count();
+}
+
+bool Logger::push(Message&& message)
+{
+	// bounded queue of Dmitry Vyukov : each slot's sequence tells whether it
+	// is free for the position being pushed or holds a message to pop
+	State& s(state());
+	unsigned int pos(s.enqueuePos.load(std::memory_order_relaxed));
+	for(;;)
+	{
+		Slot& slot(s.slots.at(pos % capacity));
+		unsigned int sequence(slot.sequence.load(std::memory_order_acquire));
+		auto diff(static_cast<int>(sequence - pos));
+		if(diff == 0)
+		{
+			if(s.enqueuePos.compare_exchange_weak(pos, pos + 1,
+			                                      std::memory_order_relaxed))
+			{
+				slot.message = std::move(message);
+				slot.sequence.store(pos + 1, std::memory_order_release);
+				return true;
+			}
+		}
+		else if(diff < 0)
+		{
+			// full
+			return false;
+		}
+		else
+		{
+			pos = s.enqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+bool Logger::pop(Message& message)
+{
+	State& s(state());
+	unsigned int pos(s.dequeuePos.load(std::memory_order_relaxed));
+	Slot& slot(s.slots.at(pos % capacity));
+	if(slot.sequence.load(std::memory_order_acquire) != pos + 1)
+	{
+		return false;
+	}
+	message = std::move(slot.message);
+	slot.sequence.store(pos + capacity, std::memory_order_release);
+	s.dequeuePos.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+void Logger::run()
+{
+	while(state().running)
+	{
+		if(!drain())
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		}
+	}
+}
+
+bool Logger::drain()
+{
+	State& s(state());
+	QMutexLocker lock(&s.writeMutex);
+	bool any(false);
+	Message message;
+	while(pop(message))
+	{
+		any = true;
+		if(!rateLimited(message))
+		{
+			write(message);
+		}
+	}
+
+	unsigned int dropped(s.dropped.exchange(0));
+	if(dropped > 0)
+	{
+		write(QtWarningMsg, " (Logger):",
+		      QByteArray::number(dropped)
+		          + " messages dropped, the log queue was full");
+		any = true;
+	}
+
+	qint64 time(now());
+	if(time - s.lastSweep >= 1000)
+	{
+		sweepRateWindows(time);
+		s.lastSweep = time;
+	}
+
+	if(any)
+	{
+		logFile().flush();
+		std::cerr.flush();
+	}
+	return any;
+}
+
+bool Logger::rateLimited(Message const& message)
+{
+	unsigned int limit(state().rateLimit);
+	if(limit == 0 || message.type == QtFatalMsg)
+	{
+		return false;
+	}
+
+	RateWindow& window(state().rateWindows[message.source]);
+	if(message.time - window.start >= 1000)
+	{
+		if(window.suppressed > 0)
+		{
+			write(message.type, window.header,
+			      QByteArray::number(window.suppressed)
+			          + " similar messages suppressed");
+		}
+		window.start      = message.time;
+		window.count      = 0;
+		window.suppressed = 0;
+	}
+	window.header = message.header;
+	if(window.count < limit)
+	{
+		++window.count;
+		return false;
+	}
+	++window.suppressed;
+	return true;
+}
+
+void Logger::sweepRateWindows(qint64 time)
+{
+	auto& windows(state().rateWindows);
+	for(auto it(windows.begin()); it != windows.end();)
+	{
+		if(time - it->start < 1000)
+		{
+			++it;
+			continue;
+		}
+		if(it->suppressed > 0)
+		{
+			write(QtInfoMsg, it->header,
+			      QByteArray::number(it->suppressed)
+			          + " similar messages suppressed");
+			it->suppressed = 0;
+		}
+		if(time - it->start >= rateWindowLifetime)
+		{
+			it = windows.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void Logger::write(Message const& message)
+{
+	write(message.type, message.header, message.text);
+}
+
+void Logger::write(QtMsgType type, QByteArray const& header,
+                   QByteArray const& text)
+{
 	std::string messageTypeStr, messageTypeStrColor;
 	switch(type)
 	{
@@ -68,15 +337,9 @@ void Logger::log(QtMsgType type, const QMessageLogContext& context,
 			messageTypeStrColor = "\033[31mFatal\033[0m";
 			break;
 	}
-	logFile() << messageTypeStr << " (" << shortFile << ":" << context.line
-	          << ", " << function << "):" << std::endl
-	          << "\t" << localMsg.constData() << std::endl;
-	std::cerr << messageTypeStrColor << " (" << shortFile << ":" << context.line
-	          << ", " << function << "):" << std::endl
-	          << "\t" << localMsg.constData() << std::endl;
-}
-
-void Logger::close()
-{
-	logFile().close();
+	// no std::endl, flushed once per batch
+	logFile() << messageTypeStr << header.constData() << '\n'
+	          << '\t' << text.constData() << '\n';
+	std::cerr << messageTypeStrColor << header.constData() << '\n'
+	          << '\t' << text.constData() << '\n';
 }
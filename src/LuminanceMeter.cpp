@@ -0,0 +1,137 @@
+/*
+    Copyright (C) 2020 Florian Cabot <florian.cabot@hotmail.fr>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "LuminanceMeter.hpp"
+
+#include <algorithm>
+
+// readback buffers layout, in floats
+#define READBACK_RESULT 2
+#define READBACK_HISTOGRAM 6
+
+LuminanceMeter::LuminanceMeter()
+    : shader("luminance",
+             {{"HISTOGRAM_BINS", QString::number(histogramBins)}})
+    , sums(GL_SHADER_STORAGE_BUFFER, (groups + 1) * 2 * sizeof(float),
+           GL_DYNAMIC_COPY)
+    , bins(GL_SHADER_STORAGE_BUFFER)
+    , histogram(histogramBins, 0.f)
+{
+	// bins are cleared by the shader after each use, start cleared
+	bins.setData(std::vector<GLuint>(2 * histogramBins + 4, 0),
+	             GL_DYNAMIC_COPY);
+	for(unsigned int i(0); i < latency; ++i)
+	{
+		readbackBuffers.emplace_back(
+		    GL_COPY_WRITE_BUFFER,
+		    (READBACK_HISTOGRAM + histogramBins) * sizeof(float),
+		    GL_STREAM_READ);
+	}
+}
+
+void LuminanceMeter::setPercentiles(float low, float high)
+{
+	lowPercentile  = std::max(0.f, std::min(low, 1.f));
+	highPercentile = std::max(lowPercentile, std::min(high, 1.f));
+}
+
+void LuminanceMeter::measure(GLTexture const& texture, bool wait)
+{
+	if(!read(wait))
+	{
+		return;
+	}
+
+	GLHandler::glf().glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0,
+	                                  sums.getGLBuffer());
+	GLHandler::glf().glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1,
+	                                  bins.getGLBuffer());
+	shader.setUniform("minLogLuminance", minLogLuminance);
+	shader.setUniform("maxLogLuminance", maxLogLuminance);
+	shader.setUniform("lowPercentile", lowPercentile);
+	shader.setUniform("highPercentile", highPercentile);
+	// groups x groups invocations, each one summing a strided set of pixels
+	shader.setUniform("stage", 0);
+	shader.exec({{&texture, GLComputeShader::DataAccessMode::R}},
+	            {16 * 16, 16 * 16, 1}, false);
+	GLHandler::glf().glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	// one work group summing the groups sums
+	shader.setUniform("stage", 1);
+	shader.exec({}, {16, 16, 1}, false);
+	GLHandler::glf().glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	unsigned int slot(frame % latency);
+	GLHandler::glf().glBindBuffer(GL_COPY_READ_BUFFER, sums.getGLBuffer());
+	GLHandler::glf().glBindBuffer(GL_COPY_WRITE_BUFFER,
+	                              readbackBuffers.at(slot).getGLBuffer());
+	GLHandler::glf().glCopyBufferSubData(GL_COPY_READ_BUFFER,
+	                                     GL_COPY_WRITE_BUFFER,
+	                                     groups * 2 * sizeof(float), 0,
+	                                     2 * sizeof(float));
+	// result and normalized bins follow the raw bins
+	GLHandler::glf().glBindBuffer(GL_COPY_READ_BUFFER, bins.getGLBuffer());
+	GLHandler::glf().glCopyBufferSubData(
+	    GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+	    histogramBins * sizeof(GLuint), READBACK_RESULT * sizeof(float),
+	    (4 + histogramBins) * sizeof(float));
+	fences.at(slot)
+	    = GLHandler::glf().glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	++frame;
+}
+
+bool LuminanceMeter::read(bool wait)
+{
+	unsigned int slot(frame % latency);
+	GLsync fence(fences.at(slot));
+	if(fence == nullptr)
+	{
+		return true;
+	}
+	GLenum status(GLHandler::glf().glClientWaitSync(
+	    fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? 1000000000 : 0));
+	if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+	{
+		return false;
+	}
+	GLHandler::glf().glDeleteSync(fence);
+	fences.at(slot) = nullptr;
+
+	GLBuffer const& readback(readbackBuffers.at(slot));
+	auto data(static_cast<GLfloat const*>(readback.map(GL_READ_ONLY)));
+	if(data != nullptr && data[1] > 0.f)
+	{
+		averageLuminance = data[0] / data[1];
+		// average between percentiles
+		histogramAverageLuminance = data[READBACK_RESULT + 2];
+		histogram.assign(data + READBACK_HISTOGRAM,
+		                 data + READBACK_HISTOGRAM + histogramBins);
+	}
+	readback.unmap();
+	return true;
+}
+
+LuminanceMeter::~LuminanceMeter()
+{
+	for(GLsync fence : fences)
+	{
+		if(fence != nullptr)
+		{
+			GLHandler::glf().glDeleteSync(fence);
+		}
+	}
+}
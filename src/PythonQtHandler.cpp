@@ -18,6 +18,15 @@
 
 #include "PythonQtHandler.hpp"
 
+#include <algorithm>
+#include <chrono>
+
+#include "SettingsSnapshot.hpp"
+#include "profiling.hpp"
+
+// smoothing of the hooks average timings
+static const float smoothing = 0.05f;
+
 #ifdef PYTHONQT
 PythonQtObjectPtr* PythonQtHandler::mainModule     = nullptr;
 PythonQtScriptingConsole* PythonQtHandler::console = nullptr;
@@ -80,7 +89,10 @@ void PythonQtHandler::addObject(QString const& name, QObject* object)
 
 QVariant PythonQtHandler::evalScript(QString const& script)
 {
+	CPUProfiler::Zone zone("python");
 #ifdef PYTHONQT
+	// the script can (re)define hooks
+	hooks().clear();
 	return mainModule->evalScript(script);
 #else
 	return QVariant();
@@ -89,11 +101,163 @@ QVariant PythonQtHandler::evalScript(QString const& script)
 
 void PythonQtHandler::evalFile(QString const& filename)
 {
+	CPUProfiler::Zone zone("python file");
 #ifdef PYTHONQT
+	hooks().clear();
 	mainModule->evalFile(filename);
 #endif
 }
 
+bool PythonQtHandler::hasHook(QString const& name)
+{
+#ifdef PYTHONQT
+	return !hook(name).isNull();
+#else
+	Q_UNUSED(name);
+	return false;
+#endif
+}
+
+QVariant PythonQtHandler::callHook(QString const& name,
+                                   QVariantList const& args)
+{
+#ifdef PYTHONQT
+	// copy, the call can invalidate the cache
+	PythonQtObjectPtr callable(hook(name));
+	if(callable.isNull())
+	{
+		return QVariant();
+	}
+	CPUProfiler::Zone zone("python hook");
+	HookProfile& profile(hookProfile());
+	++profile.depth;
+	auto start(std::chrono::steady_clock::now());
+	QVariant result(PythonQt::self()->call(callable.object(), args));
+	float time(std::chrono::duration<float, std::milli>(
+	               std::chrono::steady_clock::now() - start)
+	               .count());
+	--profile.depth;
+
+	auto& frame(profile.frame[name]);
+	frame.first += time;
+	++frame.second;
+	if(profile.depth == 0)
+	{
+		profile.frameTotal += time;
+	}
+	return result;
+#else
+	Q_UNUSED(name);
+	Q_UNUSED(args);
+	return QVariant();
+#endif
+}
+
+QVariant PythonQtHandler::createObject(QString const& type,
+                                       QVariantList const& args)
+{
+#ifdef PYTHONQT
+	PythonQtObjectPtr callable(hook(type));
+	if(callable.isNull())
+	{
+		return QVariant();
+	}
+	// keep the Python object alive as is, PythonQt unwraps it when it is
+	// passed back as an argument
+	return QVariant::fromValue(
+	    PythonQt::self()->callAndReturnPyObject(callable.object(), args));
+#else
+	Q_UNUSED(type);
+	Q_UNUSED(args);
+	return QVariant();
+#endif
+}
+
+void PythonQtHandler::endFrame()
+{
+	static const Setting<double> budget("scripting/framebudget");
+
+	HookProfile& profile(hookProfile());
+	for(auto& timing : profile.timings)
+	{
+		auto it(profile.frame.find(timing.name));
+		timing.calls = 0;
+		timing.last  = 0.f;
+		if(it != profile.frame.end())
+		{
+			timing.last  = it->first;
+			timing.calls = it->second;
+			profile.frame.erase(it);
+		}
+		timing.average += smoothing * (timing.last - timing.average);
+	}
+	for(auto it(profile.frame.begin()); it != profile.frame.end(); ++it)
+	{
+		profile.timings.push_back(
+		    {it.key(), it->second, it->first, it->first});
+	}
+	profile.frame.clear();
+
+	// forget hooks that aren't called anymore
+	profile.timings.erase(
+	    std::remove_if(profile.timings.begin(), profile.timings.end(),
+	                   [](HookTiming const& timing) {
+		                   return timing.calls == 0
+		                          && timing.average < 0.001f;
+	                   }),
+	    profile.timings.end());
+	std::sort(profile.timings.begin(), profile.timings.end(),
+	          [](HookTiming const& a, HookTiming const& b) {
+		          return a.average > b.average;
+	          });
+	profile.averageTotal
+	    += smoothing * (profile.frameTotal - profile.averageTotal);
+
+	if(budget.get() > 0.0 && profile.frameTotal > budget.get())
+	{
+		++profile.framesOverBudget;
+		if(!profile.warningTimer.isValid()
+		   || profile.warningTimer.elapsed() >= 1000)
+		{
+			QString hooks;
+			for(auto const& timing : profile.timings)
+			{
+				if(timing.calls > 0)
+				{
+					hooks += " " + timing.name + " "
+					         + QString::number(timing.last, 'f', 2) + " ms";
+				}
+			}
+			qWarning() << "Python hooks took" << profile.frameTotal
+			           << "ms, over the" << budget.get()
+			           << "ms frame budget," << profile.framesOverBudget
+			           << "frame(s) over budget since last warning :"
+			           << hooks.toLatin1().constData();
+			profile.framesOverBudget = 0;
+			profile.warningTimer.start();
+		}
+	}
+	profile.frameTotal = 0.f;
+}
+
+QString PythonQtHandler::hookTimingsToString()
+{
+	HookProfile const& profile(hookProfile());
+	if(profile.timings.empty())
+	{
+		return QString();
+	}
+	QString result("python hooks : "
+	               + QString::number(profile.averageTotal, 'f', 2) + " ms\n");
+	for(auto const& timing : profile.timings)
+	{
+		result += "  " + timing.name + " : "
+		          + QString::number(timing.average, 'f', 2) + " ms ("
+		          + QString::number(timing.calls) + " calls)\n";
+	}
+	return result;
+}
+
 void PythonQtHandler::openConsole()
 {
 #ifdef PYTHONQT
@@ -118,11 +282,42 @@ void PythonQtHandler::closeConsole()
 void PythonQtHandler::clean()
 {
 #ifdef PYTHONQT
+	hooks().clear();
 	delete mainModule;
 	delete console;
 #endif
 }
 
+PythonQtHandler::HookProfile& PythonQtHandler::hookProfile()
+{
+	static HookProfile profile;
+	return profile;
+}
+
+#ifdef PYTHONQT
+QHash<QString, PythonQtObjectPtr>& PythonQtHandler::hooks()
+{
+	static QHash<QString, PythonQtObjectPtr> hooks;
+	return hooks;
+}
+
+PythonQtObjectPtr const& PythonQtHandler::hook(QString const& name)
+{
+	// functions typed in the console can't be tracked
+	if(console->isVisible())
+	{
+		hooks().clear();
+	}
+	auto it(hooks().find(name));
+	if(it == hooks().end())
+	{
+		it = hooks().insert(
+		    name, PythonQt::self()->lookupCallable(*mainModule, name));
+	}
+	return *it;
+}
+#endif
+
 void PythonQtWrapper::overloadStaticBinary(const char* op)
 {
 	PythonQtHandler::evalScript(
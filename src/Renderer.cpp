@@ -20,6 +20,16 @@
 
 #include "AbstractMainWin.hpp"
 
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <set>
+
+#include "gl/GLProfiler.hpp"
+#include "profiling.hpp"
+
 Renderer::Renderer(AbstractMainWin& window, VRHandler& vrHandler)
     : window(window)
     , vrHandler(vrHandler)
@@ -43,6 +53,15 @@ void Renderer::init()
 	defaultCam->lookAt({1, 1, 1}, {0, 0, 0}, {0, 0, 1});
 	appendSceneRenderPath("default", RenderPath(defaultCam));
 
+	for(auto& luminanceMeter : luminanceMeters)
+	{
+		luminanceMeter = new LuminanceMeter;
+	}
+	frameCapture      = new FrameCapture;
+	dynamicResolution = new DynamicResolution;
+	panoramaShader    = new GLShaderProgram("postprocess", "panorama360");
+	domeMasterShader  = new GLShaderProgram("postprocess", "domemaster180");
+
 	reloadPostProcessingTargets();
 	updateFOV();
 	updateAngleShiftMat();
@@ -61,6 +80,7 @@ void Renderer::updateRenderTargets()
 	{
 		QSettings().setValue("window/width", window.size().width());
 		QSettings().setValue("window/height", window.size().height());
+		SettingsSnapshot::refresh();
 	}
 	updateFOV();
 	reloadPostProcessingTargets();
@@ -73,10 +93,18 @@ QSize Renderer::getSize(bool ignoreVR) const
 	{
 		renderSize = vrHandler.getEyeRenderTargetSize();
 	}
-	else if(QSettings().value("window/forcerenderresolution").toBool())
+	else
 	{
-		renderSize.setWidth(QSettings().value("window/forcewidth").toInt());
-		renderSize.setHeight(QSettings().value("window/forceheight").toInt());
+		// read every frame
+		static const Setting<bool> forceRenderResolution(
+		    "window/forcerenderresolution");
+		static const Setting<int> forceWidth("window/forcewidth");
+		static const Setting<int> forceHeight("window/forceheight");
+		if(forceRenderResolution.get())
+		{
+			renderSize.setWidth(forceWidth.get());
+			renderSize.setHeight(forceHeight.get());
+		}
 	}
 	return renderSize;
 }
@@ -122,12 +150,18 @@ BasicCamera& Renderer::getCamera(QString const& pathId)
 
 QImage Renderer::getLastFrame() const
 {
-	return mainRenderTarget->postProcessingTargets
-	    .at(postProcessingPipeline_.size() % 2)
+	return mainRenderTarget->postProcessingTargets.at(postProcessingResult)
 	    .copyColorBufferToQImage()
 	    .mirrored(false, true);
 }
 
+void Renderer::captureLastFrame(FrameSink& sink, QString const& name)
+{
+	frameCapture->capture(
+	    mainRenderTarget->postProcessingTargets.at(postProcessingResult), sink,
+	    name);
+}
+
 void Renderer::appendSceneRenderPath(QString const& id, RenderPath path)
 {
 	sceneRenderPipeline_.append(QPair<QString, RenderPath>(id, path));
@@ -145,28 +179,61 @@ void Renderer::removeSceneRenderPath(QString const& id)
 	{
 		if(sceneRenderPipeline_[i].first == id)
 		{
-			delete sceneRenderPipeline_[i].second.camera;
+			BasicCamera* camera(sceneRenderPipeline_[i].second.camera);
 			sceneRenderPipeline_.removeAt(i);
+			// paths can share their camera
+			bool shared(false);
+			for(auto const& pair : sceneRenderPipeline_)
+			{
+				shared = shared || pair.second.camera == camera;
+			}
+			if(!shared)
+			{
+				delete camera;
+			}
 			break;
 		}
 	}
 }
 
+std::vector<float> Renderer::getLastFrameLuminanceHistogram() const
+{
+	if(luminanceMeters[0] == nullptr)
+	{
+		return {};
+	}
+	return luminanceMeters[0]->getHistogram();
+}
+
+void Renderer::setLuminancePercentiles(float low, float high)
+{
+	for(auto luminanceMeter : luminanceMeters)
+	{
+		if(luminanceMeter != nullptr)
+		{
+			luminanceMeter->setPercentiles(low, high);
+		}
+	}
+}
+
 void Renderer::appendPostProcessingShader(QString const& id,
                                           QString const& computeName,
-                                          QMap<QString, QString> const& defines)
+                                          QMap<QString, QString> const& defines,
+                                          PostProcessingFootprint footprint)
 {
-	postProcessingPipeline_.emplace_back(
-	    std::make_pair(id, GLComputeShader(computeName, defines)));
+	postProcessingPipeline_.push_back({id, computeName, defines, footprint});
+	postProcessingGraphDirty = true;
 }
 
 void Renderer::insertPostProcessingShader(QString const& id,
                                           QString const& computeName,
-                                          unsigned int pos)
+                                          unsigned int pos,
+                                          PostProcessingFootprint footprint)
 {
-	postProcessingPipeline_.emplace(
+	postProcessingPipeline_.insert(
 	    std::next(postProcessingPipeline_.begin(), pos),
-	    std::make_pair(id, GLComputeShader(computeName)));
+	    PostProcessingPass{id, computeName, {}, footprint});
+	postProcessingGraphDirty = true;
 }
 
 void Renderer::removePostProcessingShader(QString const& id)
@@ -174,9 +241,10 @@ void Renderer::removePostProcessingShader(QString const& id)
 	for(auto it(postProcessingPipeline_.begin());
 	    it != postProcessingPipeline_.end(); ++it)
 	{
-		if(it->first == id)
+		if(it->id == id)
 		{
 			postProcessingPipeline_.erase(it);
+			postProcessingGraphDirty = true;
 			break;
 		}
 	}
@@ -254,6 +322,26 @@ void Renderer::toggleCalibrationCompass()
 	}
 }
 
+void Renderer::setGPUProfilerOverlay(bool on)
+{
+	if(on == getGPUProfilerOverlay())
+	{
+		return;
+	}
+	GLProfiler::setEnabled(on);
+	delete gpuProfilerOverlay;
+	gpuProfilerOverlay = nullptr;
+	if(on)
+	{
+		gpuProfilerOverlay = new Text3D(512, 512);
+		gpuProfilerOverlay->setFont(
+		    QFontDatabase::systemFont(QFontDatabase::FixedFont));
+		gpuProfilerOverlay->setColor(QColor(255, 255, 255));
+		gpuProfilerOverlay->setBackgroundColor(QColor(0, 0, 0, 160));
+		gpuProfilerOverlayTimer.restart();
+	}
+}
+
 void Renderer::renderVRControls() const
 {
 	if(vrHandler.isEnabled())
@@ -266,6 +354,7 @@ void Renderer::renderVRControls() const
 void Renderer::vrRenderSinglePath(RenderPath& renderPath, QString const& pathId,
                                   bool debug, bool debugInHeadset)
 {
+	GLProfiler::Scope scope(pathId);
 	GLHandler::glf().glClear(renderPath.clearMask);
 	renderPath.camera->update(angleShiftMat);
 	dbgCamera->update(angleShiftMat);
@@ -287,13 +376,15 @@ void Renderer::vrRenderSinglePath(RenderPath& renderPath, QString const& pathId,
 	{
 		GLHandler::beginWireframe();
 	}
-	window.renderScene(*renderPath.camera, pathId);
+	{
+		CPUProfiler::Zone zone("renderScene");
+		window.renderScene(*renderPath.camera, pathId);
+	}
 	if(pathIdRenderingControllers == pathId && !renderControllersBeforeScene)
 	{
 		renderVRControls();
 	}
-	PythonQtHandler::evalScript(
-	    "if \"renderScene\" in dir():\n\trenderScene()");
+	PythonQtHandler::callHook("renderScene");
 	if(debug && debugInHeadset)
 	{
 		dbgCamera->renderCamera(renderPath.camera);
@@ -311,6 +402,7 @@ void Renderer::vrRenderSinglePath(RenderPath& renderPath, QString const& pathId,
 void Renderer::vrRender(Side side, bool debug, bool debugInHeadset,
                         bool displayOnScreen)
 {
+	GLProfiler::Scope scope(side == Side::LEFT ? "left eye" : "right eye");
 	vrHandler.prepareRendering(side);
 	GLHandler::beginRendering(mainRenderTarget->sceneTarget);
 	vrHandler.renderHiddenAreaMesh(side);
@@ -323,48 +415,37 @@ void Renderer::vrRender(Side side, bool debug, bool debugInHeadset,
 	mainRenderTarget->sceneTarget.blitColorBufferTo(
 	    mainRenderTarget->postProcessingTargets[0]);
 
-	lastFrameAverageLuminance += mainRenderTarget->postProcessingTargets[0]
-	                                 .getColorAttachmentTexture()
-	                                 .getAverageLuminance();
+	LuminanceMeter& luminanceMeter(
+	    *luminanceMeters.at(side == Side::LEFT ? 0 : 1));
+	luminanceMeter.measure(mainRenderTarget->postProcessingTargets[0]
+	                           .getColorAttachmentTexture(),
+	                       deterministic);
+	lastFrameAverageLuminance += luminanceMeter.getAverageLuminance();
+	lastFrameHistogramAverageLuminance
+	    += luminanceMeter.getHistogramAverageLuminance();
 
 	// do all postprocesses including last one
-	int i(0);
-	for(auto it(postProcessingPipeline_.begin());
-	    it != postProcessingPipeline_.end(); ++it, ++i)
-	{
-		window.applyPostProcShaderParams(
-		    it->first, it->second,
-		    mainRenderTarget->postProcessingTargets.at(i % 2));
-		auto texs = window.getPostProcessingUniformTextures(
-		    it->first, it->second,
-		    mainRenderTarget->postProcessingTargets.at(i % 2));
-		GLHandler::postProcess(
-		    it->second, mainRenderTarget->postProcessingTargets.at(i % 2),
-		    mainRenderTarget->postProcessingTargets.at((i + 1) % 2), texs);
-	}
+	postProcess();
 
-	vrHandler.submitRendering(mainRenderTarget->postProcessingTargets.at(
-	    postProcessingPipeline_.size() % 2));
+	vrHandler.submitRendering(
+	    mainRenderTarget->postProcessingTargets.at(postProcessingResult));
 
 	if(displayOnScreen)
 	{
 		// blit result on screen
 		if(vrHandler.forceLeft || vrHandler.forceRight)
 		{
-			mainRenderTarget->postProcessingTargets
-			    .at(postProcessingPipeline_.size() % 2)
+			mainRenderTarget->postProcessingTargets.at(postProcessingResult)
 			    .showOnScreen(0, 0, window.width(), window.height());
 		}
 		else if(side == Side::LEFT)
 		{
-			mainRenderTarget->postProcessingTargets
-			    .at(postProcessingPipeline_.size() % 2)
+			mainRenderTarget->postProcessingTargets.at(postProcessingResult)
 			    .showOnScreen(0, 0, window.width() / 2, window.height());
 		}
 		else
 		{
-			mainRenderTarget->postProcessingTargets
-			    .at(postProcessingPipeline_.size() % 2)
+			mainRenderTarget->postProcessingTargets.at(postProcessingResult)
 			    .showOnScreen(window.width() / 2, 0, window.width(),
 			                  window.height());
 		}
@@ -378,12 +459,20 @@ void Renderer::renderFrame()
 	bool renderingCamIsDebug(debug
 	                         && ((debugInHeadset && vrHandler.isEnabled())
 	                             || !vrHandler.isEnabled()));
-	bool thirdRender(QSettings().value("vr/thirdrender").toBool());
+	static const Setting<bool> thirdRenderSetting("vr/thirdrender");
+	bool thirdRender(thirdRenderSetting.get());
+
+	CPUProfiler::Zone frameZone("renderFrame");
+	dynamicResolution->beginFrame();
+	GLProfiler::beginFrame();
+	// closed by GLProfiler::endFrame
+	GLProfiler::Scope frameScope("frame");
 
 	// main render logic
 	if(vrHandler.isEnabled())
 	{
-		lastFrameAverageLuminance = 0.f;
+		lastFrameAverageLuminance          = 0.f;
+		lastFrameHistogramAverageLuminance = 0.f;
 		if(!vrHandler.forceRight)
 		{
 			vrRender(Side::LEFT, debug, debugInHeadset,
@@ -395,6 +484,7 @@ void Renderer::renderFrame()
 			         !thirdRender && (!debug || debugInHeadset));
 		}
 		lastFrameAverageLuminance *= 0.5f;
+		lastFrameHistogramAverageLuminance *= 0.5f;
 
 		if(debug && !debugInHeadset)
 		{
@@ -404,11 +494,23 @@ void Renderer::renderFrame()
 	// if no VR or debug not in headset, render 2D
 	if((!vrHandler.isEnabled() || thirdRender) || (debug && !debugInHeadset))
 	{
-		auto renderFunc = [=](bool overrideCamera, QMatrix4x4 overrView,
-		                      QMatrix4x4 overrProj) {
+		// paths rendered by renderFunc, see RenderPath::directProjection
+		bool renderDirectPaths(true), renderCubemapPaths(true);
+		// viewport size, see DynamicResolution
+		QSize renderSize(getSize());
+		auto renderFunc = [=, &renderDirectPaths, &renderCubemapPaths,
+		                   &renderSize](bool overrideCamera,
+		                                QMatrix4x4 overrView,
+		                                QMatrix4x4 overrProj) {
 			for(auto pair : sceneRenderPipeline_)
 			{
-				pair.second.camera->setWindowSize(getSize());
+				if(pair.second.directProjection ? !renderDirectPaths
+				                                : !renderCubemapPaths)
+				{
+					continue;
+				}
+				GLProfiler::Scope scope(pair.first);
+				pair.second.camera->setWindowSize(renderSize);
 				GLHandler::glf().glClear(pair.second.clearMask);
 				QMatrix4x4 viewBack(pair.second.camera->getView()),
 				    projBack(pair.second.camera->getProj());
@@ -433,9 +535,11 @@ void Renderer::renderFrame()
 					GLHandler::beginWireframe();
 				}
 
-				window.renderScene(*pair.second.camera, pair.first);
-				PythonQtHandler::evalScript(
-				    "if \"renderScene\" in dir():\n\trenderScene()");
+				{
+					CPUProfiler::Zone zone("renderScene");
+					window.renderScene(*pair.second.camera, pair.first);
+				}
+				PythonQtHandler::callHook("renderScene");
 				if(debug)
 				{
 					dbgCamera->renderCamera(pair.second.camera);
@@ -458,19 +562,85 @@ void Renderer::renderFrame()
 
 		if(projection == MainRenderTarget::Projection::DEFAULT)
 		{
-			GLHandler::beginRendering(mainRenderTarget->sceneTarget);
+			GLFramebufferObject const& sceneTarget(
+			    mainRenderTarget->sceneTarget);
+			GLHandler::beginRendering(sceneTarget);
+			// the target keeps its full size, only the viewport shrinks ;
+			// offline frames must not depend on timings
+			if(!deterministic)
+			{
+				renderSize = dynamicResolution->scaledSize(getSize());
+			}
+			GLHandler::glf().glViewport(0, 0, renderSize.width(),
+			                            renderSize.height());
 			renderFunc(false, QMatrix4x4(), QMatrix4x4());
-			mainRenderTarget->sceneTarget.blitColorBufferTo(
-			    mainRenderTarget->postProcessingTargets[0]);
+			if(renderSize == sceneTarget.getSize())
+			{
+				sceneTarget.blitColorBufferTo(
+				    mainRenderTarget->postProcessingTargets[0]);
+			}
+			else
+			{
+				// multisampled targets can't be resolved and scaled at
+				// once, resolve in the other post-processing target first
+				int w(renderSize.width()), h(renderSize.height());
+				GLFramebufferObject const& resolved(
+				    mainRenderTarget->postProcessingTargets[1]);
+				sceneTarget.blitColorBufferTo(resolved, 0, 0, w, h, 0, 0, w,
+				                              h);
+				resolved.blitColorBufferTo(
+				    mainRenderTarget->postProcessingTargets[0], 0, 0, w, h, 0,
+				    0, sceneTarget.getSize().width(),
+				    sceneTarget.getSize().height());
+			}
 		}
-		else if(projection == MainRenderTarget::Projection::PANORAMA360)
+		else if(projection == MainRenderTarget::Projection::PANORAMA360
+		        || projection == MainRenderTarget::Projection::DOMEMASTER180)
 		{
-			GLHandler::generateEnvironmentMap(mainRenderTarget->sceneTarget,
-			                                  renderFunc);
+			bool dome(projection
+			          == MainRenderTarget::Projection::DOMEMASTER180);
+			GLFramebufferObject const& target(
+			    mainRenderTarget->postProcessingTargets[0]);
+			bool directPaths(false), cubemapPaths(false);
+			for(auto const& pair : sceneRenderPipeline_)
+			{
+				(pair.second.directProjection ? directPaths : cubemapPaths)
+				    = true;
+			}
 
-			GLShaderProgram shader("postprocess", "panorama360");
-			GLHandler::postProcess(shader, mainRenderTarget->sceneTarget,
-			                       mainRenderTarget->postProcessingTargets[0]);
+			if(directPaths)
+			{
+				// points straight into the target, without any cube map
+				GLHandler::setDirectProjection(
+				    static_cast<unsigned int>(projection), target.getSize());
+				GLHandler::beginRendering(target);
+				renderCubemapPaths = false;
+				renderFunc(true, QMatrix4x4(), QMatrix4x4());
+				renderCubemapPaths = true;
+				renderDirectPaths  = false;
+				GLHandler::setDirectProjection(0);
+			}
+			if(cubemapPaths || !directPaths)
+			{
+				// the dome only shows the -Z half of the cube map, see
+				// domemaster180.frag
+				GLHandler::generateEnvironmentMap(
+				    mainRenderTarget->sceneTarget, renderFunc, QVector3D(),
+				    dome ? QVector3D(0.f, 0.f, -1.f) : QVector3D());
+
+				GLShaderProgram const& shader(dome ? *domeMasterShader
+				                                   : *panoramaShader);
+				if(directPaths)
+				{
+					GLHandler::postProcessOver(
+					    shader, mainRenderTarget->sceneTarget, target);
+				}
+				else
+				{
+					GLHandler::postProcess(
+					    shader, mainRenderTarget->sceneTarget, target);
+				}
+			}
 		}
 		else if(projection == MainRenderTarget::Projection::VR360)
 		{
@@ -483,7 +653,7 @@ void Renderer::renderFrame()
 
 			GLHandler::generateEnvironmentMap(mainRenderTarget->sceneTarget,
 			                                  renderFunc, shift);
-			GLShaderProgram shader("postprocess", "panorama360");
+			GLShaderProgram const& shader(*panoramaShader);
 			GLHandler::postProcess(shader, mainRenderTarget->sceneTarget,
 			                       mainRenderTarget->postProcessingTargets[0]);
 			mainRenderTarget->postProcessingTargets[0].blitColorBufferTo(
@@ -500,45 +670,231 @@ void Renderer::renderFrame()
 			mainRenderTarget->postProcessingTargets[1].blitColorBufferTo(
 			    mainRenderTarget->postProcessingTargets[0]);
 		}
-		else if(projection == MainRenderTarget::Projection::DOMEMASTER180)
+
+		else
 		{
-			GLHandler::generateEnvironmentMap(mainRenderTarget->sceneTarget,
-			                                  renderFunc);
+			qDebug() << "Invalid MainRenderTarget::Projection";
+		}
 
-			GLShaderProgram shader("postprocess", "domemaster180");
-			GLHandler::postProcess(shader, mainRenderTarget->sceneTarget,
-			                       mainRenderTarget->postProcessingTargets[0]);
+		// compute average luminance, available a few frames later
+		luminanceMeters[0]->measure(mainRenderTarget->postProcessingTargets[0]
+		                                .getColorAttachmentTexture(),
+		                            deterministic);
+		lastFrameAverageLuminance = luminanceMeters[0]->getAverageLuminance();
+		lastFrameHistogramAverageLuminance
+		    = luminanceMeters[0]->getHistogramAverageLuminance();
+
+		// postprocess
+		postProcess();
+		// blit result on screen
+		mainRenderTarget->postProcessingTargets.at(postProcessingResult)
+		    .showOnScreen(0, 0, window.width(), window.height());
+	}
+
+	if(gpuProfilerOverlay != nullptr)
+	{
+		renderGPUProfilerOverlay();
+	}
+
+	GLProfiler::endFrame();
+	dynamicResolution->endFrame();
+
+	// pending captures, see captureLastFrame
+	frameCapture->update();
+}
+
+void Renderer::renderGPUProfilerOverlay()
+{
+	// repainting the text every frame would be unreadable and costly
+	if(gpuProfilerOverlayTimer.elapsed() > 500)
+	{
+		gpuProfilerOverlay->setText(GLProfiler::toString()
+		                            + PythonQtHandler::hookTimingsToString());
+		gpuProfilerOverlayTimer.restart();
+	}
+
+	// top left corner of the window, one texel per pixel
+	QSize textSize(gpuProfilerOverlay->getImage().size());
+	float width(2.f * textSize.width() / window.width()),
+	    height(2.f * textSize.height() / window.height());
+	QMatrix4x4& model(gpuProfilerOverlay->getModel());
+	model.setToIdentity();
+	model.translate(-1.f + 0.5f * width, 1.f - 0.5f * height);
+	model.scale(width, height);
+
+	GLHandler::glf().glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLHandler::glf().glViewport(0, 0, window.width(), window.height());
+	GLHandler::setEnabled(GL_DEPTH_TEST, false);
+	gpuProfilerOverlay->render(GLHandler::GeometricSpace::CLIP);
+	GLHandler::setEnabled(GL_DEPTH_TEST, true);
+}
+
+Renderer::PostProcessingGroup::PostProcessingGroup(
+    std::vector<PostProcessingPass> passes, GLComputeShader&& shader)
+    : passes(std::move(passes))
+    , shader(std::move(shader))
+    , inPlace(this->passes.front().footprint == PostProcessingFootprint::PIXEL
+              || this->passes.front().footprint
+                     == PostProcessingFootprint::PIXEL_BARRIER)
+{
+}
+
+void Renderer::buildPostProcessingGraph()
+{
+	// PIXEL passes join the previous group unless it is a complete shader
+	std::vector<std::vector<PostProcessingPass>> groups;
+	for(auto const& pass : postProcessingPipeline_)
+	{
+		if(pass.footprint == PostProcessingFootprint::PIXEL && !groups.empty()
+		   && groups.back().front().footprint
+		          != PostProcessingFootprint::SHADER)
+		{
+			groups.back().push_back(pass);
 		}
+		else
+		{
+			groups.push_back({pass});
+		}
+	}
 
+	postProcessingGroups.clear();
+	postProcessingResult = 0;
+	for(auto const& passes : groups)
+	{
+		PostProcessingPass const& first(passes.front());
+		if(first.footprint == PostProcessingFootprint::SHADER)
+		{
+			postProcessingGroups.emplace_back(
+			    passes, GLComputeShader(first.name, first.defines));
+		}
 		else
 		{
-			qDebug() << "Invalid MainRenderTarget::Projection";
+			QMap<QString, QString> defines;
+			for(auto const& pass : passes)
+			{
+				for(auto const& key : pass.defines.keys())
+				{
+					defines.insert(key, pass.defines.value(key));
+				}
+			}
+			postProcessingGroups.emplace_back(
+			    passes, GLComputeShader(generatePostProcessingShader(passes),
+			                            defines));
+		}
+		if(!postProcessingGroups.back().inPlace)
+		{
+			postProcessingResult = 1 - postProcessingResult;
 		}
+	}
+	postProcessingGraphDirty = false;
+}
 
-		// compute average luminance
-		lastFrameAverageLuminance = mainRenderTarget->postProcessingTargets[0]
-		                                .getColorAttachmentTexture()
-		                                .getAverageLuminance();
+QString Renderer::generatePostProcessingShader(
+    std::vector<PostProcessingPass> const& passes)
+{
+	QString source("#version 420 core\n"
+	               "#extension GL_ARB_compute_shader : enable\n\n"
+	               "layout (local_size_x = LOCAL_SIZE_2D_X, "
+	               "local_size_y = LOCAL_SIZE_2D_Y) in;\n\n"
+	               "layout (rgba32f, binding = 0) readonly uniform image2D "
+	               "dataIn;\n"
+	               "layout (rgba32f, binding = 1) writeonly uniform image2D "
+	               "dataOut;\n\n");
+	for(unsigned int i(0); i < passes.size(); ++i)
+	{
+		QString name(passes[i].name);
+		if(!name.endsWith(".glsl"))
+		{
+			name += ".glsl";
+		}
+		source += "#define postprocess postprocess" + QString::number(i)
+		          + "\n#include <" + name + ">\n#undef postprocess\n\n";
+	}
+	source += "void main()\n{\n"
+	          "\tivec2 pixel = ivec2(gl_GlobalInvocationID.xy);\n"
+	          "\tvec4 color  = imageLoad(dataIn, pixel);\n";
+	for(unsigned int i(0); i < passes.size(); ++i)
+	{
+		source += "\tcolor = postprocess" + QString::number(i)
+		          + "(color, pixel);\n";
+	}
+	source += "\timageStore(dataOut, pixel, color);\n}\n";
+
+	// named after its content, so that it is only written once ; written
+	// atomically, so that an interrupted write doesn't stay in the cache
+	QString dir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+	            + "/shaders/generated/");
+	QDir().mkpath(dir);
+	QString path(dir
+	             + QString(QCryptographicHash::hash(source.toUtf8(),
+	                                                QCryptographicHash::Sha1)
+	                           .toHex())
+	             + ".comp");
+	if(!QFile::exists(path))
+	{
+		QSaveFile file(path);
+		QByteArray data(source.toUtf8());
+		if(!file.open(QFile::WriteOnly | QFile::Text)
+		   || file.write(data) != data.size() || !file.commit())
+		{
+			qWarning() << "Cannot write post-processing shader" << path;
+		}
+	}
+	return path;
+}
 
-		// postprocess
-		int i(0);
-		for(auto it(postProcessingPipeline_.begin());
-		    it != postProcessingPipeline_.end(); ++i, ++it)
+void Renderer::postProcess()
+{
+	if(postProcessingGraphDirty)
+	{
+		buildPostProcessingGraph();
+	}
+
+	unsigned int current(0);
+	for(auto const& group : postProcessingGroups)
+	{
+		unsigned int next(group.inPlace ? current : 1 - current);
+		GLFramebufferObject const& from(
+		    mainRenderTarget->postProcessingTargets.at(current));
+		GLFramebufferObject const& to(
+		    mainRenderTarget->postProcessingTargets.at(next));
+
+		QStringList ids;
+		for(auto const& pass : group.passes)
 		{
-			window.applyPostProcShaderParams(
-			    it->first, it->second,
-			    mainRenderTarget->postProcessingTargets.at(i % 2));
-			auto texs = window.getPostProcessingUniformTextures(
-			    it->first, it->second,
-			    mainRenderTarget->postProcessingTargets.at(i % 2));
-			GLHandler::postProcess(
-			    it->second, mainRenderTarget->postProcessingTargets.at(i % 2),
-			    mainRenderTarget->postProcessingTargets.at((i + 1) % 2), texs);
+			ids << pass.id;
 		}
-		// blit result on screen
-		mainRenderTarget->postProcessingTargets
-		    .at(postProcessingPipeline_.size() % 2)
-		    .showOnScreen(0, 0, window.width(), window.height());
+		GLProfiler::Scope scope(ids.join('+'));
+
+		std::vector<
+		    std::pair<GLTexture const*, GLComputeShader::DataAccessMode>>
+		    texs;
+		for(auto const& pass : group.passes)
+		{
+			window.applyPostProcShaderParams(pass.id, group.shader, from);
+			auto passTexs(window.getPostProcessingUniformTextures(
+			    pass.id, group.shader, from));
+			texs.insert(texs.end(), passTexs.begin(), passTexs.end());
+		}
+
+		if(group.passes.front().footprint == PostProcessingFootprint::SHADER)
+		{
+			GLHandler::postProcess(group.shader, from, to, texs);
+		}
+		else
+		{
+			// in place groups read and write the same image, one pixel per
+			// invocation
+			texs.insert(texs.begin(),
+			            {{&from.getColorAttachmentTexture(),
+			              GLComputeShader::DataAccessMode::R},
+			             {&to.getColorAttachmentTexture(),
+			              GLComputeShader::DataAccessMode::W}});
+			group.shader.exec(
+			    texs, {static_cast<unsigned int>(from.getSize().width()),
+			           static_cast<unsigned int>(from.getSize().height()), 1});
+		}
+		current = next;
 	}
 }
 
@@ -551,14 +907,36 @@ void Renderer::clean()
 
 	delete compass;
 
+	// paths can share their camera
+	std::set<BasicCamera*> cameras;
 	for(auto const& pair : sceneRenderPipeline_)
 	{
-		delete pair.second.camera;
+		cameras.insert(pair.second.camera);
+	}
+	for(BasicCamera* camera : cameras)
+	{
+		delete camera;
 	}
 	delete dbgCamera;
 
 	delete mainRenderTarget;
 
+	for(auto& luminanceMeter : luminanceMeters)
+	{
+		delete luminanceMeter;
+		luminanceMeter = nullptr;
+	}
+	delete frameCapture;
+	frameCapture = nullptr;
+	delete dynamicResolution;
+	dynamicResolution = nullptr;
+	delete panoramaShader;
+	panoramaShader = nullptr;
+	delete domeMasterShader;
+	domeMasterShader = nullptr;
+	setGPUProfilerOverlay(false);
+	GLProfiler::clean();
+
 	initialized = false;
 }
 
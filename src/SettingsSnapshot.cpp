@@ -0,0 +1,59 @@
+/*
+    Copyright (C) 2020 Florian Cabot <florian.cabot@hotmail.fr>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "SettingsSnapshot.hpp"
+
+#include "Logger.hpp"
+
+SettingsSnapshot const& SettingsSnapshot::current()
+{
+	if(!instance())
+	{
+		refresh();
+	}
+	return *instance();
+}
+
+void SettingsSnapshot::refresh()
+{
+	instance().reset(new SettingsSnapshot);
+	++generation();
+	// the logger keeps its own copy of the log settings
+	Logger::readSettings();
+}
+
+SettingsSnapshot::SettingsSnapshot()
+{
+	QSettings settings;
+	for(auto const& key : settings.allKeys())
+	{
+		values[key] = settings.value(key);
+	}
+}
+
+std::unique_ptr<SettingsSnapshot const>& SettingsSnapshot::instance()
+{
+	static std::unique_ptr<SettingsSnapshot const> instance;
+	return instance;
+}
+
+unsigned int& SettingsSnapshot::generation()
+{
+	static unsigned int generation(0);
+	return generation;
+}
@@ -38,6 +38,14 @@ SettingsWidget::SettingsWidget(QWidget* parent)
 	    QFileInfo(QSettings().fileName()).absoluteDir().absolutePath()
 	        + "/systems/",
 	    tr("Video Frames Output Directory"));
+	addStringSetting("videoformat", "png",
+	                 tr("Video Frames Format (png, qoi, y4m or raw)"));
+	addStringSetting("videocommand", "ffmpeg -y -i - video.mp4",
+	                 tr("Video Encoder Command (y4m and raw formats)"));
+	addUIntSetting("videofps", 30, tr("Video Frame Rate"), 1, 240);
+	addUIntSetting("videoqueue", 4, tr("Video Frames Queue Size"), 1, 64);
+	addBoolSetting("videodropframes", false,
+	               tr("Drop Video Frames Instead of Waiting"));
 
 	addGroup("graphics", tr("Graphics"));
 	addUIntSetting("antialiasing", 0, tr("Anti-aliasing"), 0, 3);
@@ -45,6 +53,12 @@ SettingsWidget::SettingsWidget(QWidget* parent)
 	addUIntSetting("smoothshadows", 0, tr("Shadow Smoothing Quality"), 0, 5);
 	addBoolSetting("dithering", true, tr("Enable Dithering"));
 	addBoolSetting("bloom", true, tr("Bloom"));
+	addUIntSetting("bloomquality", 2, tr("Bloom Quality"), 1, 3);
+	addBoolSetting("dynamicresolution", false,
+	               tr("Dynamic Resolution (2D only)"));
+	addUIntSetting("framebudget", 16, tr("GPU Frame Budget (ms)"), 1, 1000);
+	addUIntSetting("minrenderscale", 50, tr("Minimum Render Scale (%)"), 10,
+	               100);
 	addDoubleSetting("vfov", 0.0, tr("Vertical field of view (0=auto)"), 0.0,
 	                 360.0);
 	addDoubleSetting("hfov", 0.0, tr("Horizontal field of view (0=auto)"), 0.0,
@@ -100,11 +114,22 @@ SettingsWidget::SettingsWidget(QWidget* parent)
 	    QFileInfo(settings.fileName()).absoluteDir().absolutePath()
 	        + "/scripts",
 	    tr("Scripts Root Directory"));
+	addDoubleSetting("framebudget", 2.0,
+	                 tr("Python time budget per frame (ms, 0 = no warnings)"),
+	                 0.0, 1000.0);
+	addUIntSetting("tickrate", 10, tr("Python tickScene rate (Hz)"), 1, 1000);
 
 	addGroup("debugcamera", tr("Debug Camera"));
 	addBoolSetting("enabled", false, tr("Enable Debug Camera"));
 	addBoolSetting("followhmd", false, tr("Follow HMD Movement"));
 	addBoolSetting("debuginheadset", false, tr("Show Debug In HMD"));
+
+	addGroup("log", tr("Log"));
+	addUIntSetting("level", 0,
+	               tr("Minimum Level (Debug, Info, Warning, Critical)"), 0, 3);
+	addUIntSetting("ratelimit", 20,
+	               tr("Messages Per Second Per Source (0 : no limit)"), 0,
+	               10000);
 }
 
 void SettingsWidget::addGroup(QString const& name, QString const& label)
@@ -164,6 +189,7 @@ void SettingsWidget::addBoolSetting(QString const& name, bool defaultVal,
 	if(!settings.contains(fullName))
 	{
 		settings.setValue(fullName, defaultVal);
+		SettingsSnapshot::refresh();
 	}
 
 	auto checkBox = new QCheckBox(this);
@@ -186,6 +212,7 @@ void SettingsWidget::addUIntSetting(QString const& name,
 	if(!settings.contains(fullName))
 	{
 		settings.setValue(fullName, defaultVal);
+		SettingsSnapshot::refresh();
 	}
 
 	auto sbox = new QSpinBox(this);
@@ -207,6 +234,7 @@ void SettingsWidget::addIntSetting(QString const& name, int defaultVal,
 	if(!settings.contains(fullName))
 	{
 		settings.setValue(fullName, defaultVal);
+		SettingsSnapshot::refresh();
 	}
 
 	auto sbox = new QSpinBox(this);
@@ -228,6 +256,7 @@ void SettingsWidget::addDoubleSetting(QString const& name, double defaultVal,
 	if(!settings.contains(fullName))
 	{
 		settings.setValue(fullName, defaultVal);
+		SettingsSnapshot::refresh();
 	}
 
 	auto sbox = new QDoubleSpinBox(this);
@@ -252,6 +281,7 @@ void SettingsWidget::addStringSetting(QString const& name,
 	if(!settings.contains(fullName))
 	{
 		settings.setValue(fullName, defaultVal);
+		SettingsSnapshot::refresh();
 	}
 
 	auto lineEdit = new QLineEdit(this);
@@ -273,6 +303,7 @@ void SettingsWidget::addFilePathSetting(QString const& name,
 	if(!settings.contains(fullName))
 	{
 		settings.setValue(fullName, defaultVal);
+		SettingsSnapshot::refresh();
 	}
 
 	auto lineEdit = new QLineEdit(this);
@@ -318,6 +349,7 @@ void SettingsWidget::addDirPathSetting(QString const& name,
 	if(!settings.contains(fullName))
 	{
 		settings.setValue(fullName, defaultVal);
+		SettingsSnapshot::refresh();
 	}
 
 	auto lineEdit = new QLineEdit(this);
@@ -365,6 +397,7 @@ void SettingsWidget::addVector3DSetting(QString const& name,
 	if(!settings.contains(fullName))
 	{
 		settings.setValue(fullName, defaultVal);
+		SettingsSnapshot::refresh();
 	}
 
 	QVector3D stored(settings.value(fullName).value<QVector3D>());
@@ -407,6 +440,7 @@ void SettingsWidget::addColorSetting(QString const& name,
 	if(!settings.contains(fullName))
 	{
 		settings.setValue(fullName, defaultVal);
+		SettingsSnapshot::refresh();
 	}
 
 	QColor stored(settings.value(fullName).value<QColor>());
@@ -448,6 +482,7 @@ void SettingsWidget::addDateTimeSetting(QString const& name,
 	if(!settings.contains(fullName))
 	{
 		settings.setValue(fullName, defaultVal);
+		SettingsSnapshot::refresh();
 	}
 
 	QDateTime stored(settings.value(fullName).value<QDateTime>().toTimeSpec(
@@ -483,6 +518,7 @@ void SettingsWidget::addKeySequenceSetting(QString const& name,
 	{
 		settings.setValue(fullName,
 		                  defaultVal.toString(QKeySequence::PortableText));
+		SettingsSnapshot::refresh();
 	}
 
 	auto keyseqEdit
@@ -506,6 +542,7 @@ void SettingsWidget::addLanguageSetting(QString const& name,
 	if(!settings.contains(fullName))
 	{
 		settings.setValue(fullName, defaultVal);
+		SettingsSnapshot::refresh();
 	}
 
 	auto stored = settings.value(fullName).toString();
@@ -552,6 +589,7 @@ void SettingsWidget::addScreenNameSetting(QString const& name,
 	if(!settings.contains(fullName))
 	{
 		settings.setValue(fullName, defaultVal);
+		SettingsSnapshot::refresh();
 	}
 
 	auto stored(settings.value(fullName).toString());
@@ -136,6 +136,16 @@ void ToneMappingModel::autoUpdateExposure(float averageLuminance,
 	}
 }
 
+QVariantList ToneMappingModel::getHistogram() const
+{
+	QVariantList result;
+	for(float bin : histogram)
+	{
+		result.append(bin);
+	}
+	return result;
+}
+
 double ToneMappingModel::coneThreshold(double t)
 {
 	const double a = startLogLuminance;
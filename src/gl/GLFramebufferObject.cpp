@@ -67,8 +67,7 @@ GLFramebufferObject::GLFramebufferObject(
 		                               {nullptr, GL_FLOAT, GL_DEPTH_COMPONENT});
 
 		// add depth specific texture parameters for sampler2DShadow
-		GLHandler::glf().glBindTexture(GL_TEXTURE_2D,
-		                               texColorBuffer->getGLTexture());
+		GLHandler::bindTexture(GL_TEXTURE_2D, texColorBuffer->getGLTexture());
 		GLHandler::glf().glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE,
 		                                 GL_COMPARE_REF_TO_TEXTURE);
 		GLHandler::glf().glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC,
@@ -252,6 +251,21 @@ QImage GLFramebufferObject::copyColorBufferToQImage() const
 	              [](void* data) { delete static_cast<uchar*>(data); }, data);
 }
 
+void GLFramebufferObject::copyColorBufferToBuffer(GLBuffer& buffer) const
+{
+	size_t size(width * height * 4);
+	buffer.bind(GL_PIXEL_PACK_BUFFER);
+	if(buffer.getSize() != size)
+	{
+		buffer.resize(size, GL_STREAM_READ);
+	}
+
+	GLHandler::glf().glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+	GLHandler::glf().glReadPixels(0, 0, width, height, GL_RGBA,
+	                              GL_UNSIGNED_BYTE, nullptr);
+	buffer.unbind();
+}
+
 void GLFramebufferObject::cleanUp()
 {
 	if(!doClean)
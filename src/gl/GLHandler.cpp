@@ -1,5 +1,11 @@
 #include "gl/GLHandler.hpp"
 
+#include <QHash>
+#include <algorithm>
+#include <cmath>
+
+#include "gl/GLProfiler.hpp"
+
 QOpenGLFunctions_4_2_Core& GLHandler::glf()
 {
 	static QOpenGLFunctions_4_2_Core glf;
@@ -12,6 +18,13 @@ QOpenGLExtension_ARB_compute_shader& GLHandler::glf_ARB_compute_shader()
 	return glf_ARB_compute_shader;
 }
 
+QOpenGLExtension_ARB_multi_draw_indirect&
+    GLHandler::glf_ARB_multi_draw_indirect()
+{
+	static QOpenGLExtension_ARB_multi_draw_indirect glf_ARB_multi_draw_indirect;
+	return glf_ARB_multi_draw_indirect;
+}
+
 QMatrix4x4& GLHandler::fullTransform()
 {
 	static QMatrix4x4 fullTransform;
@@ -54,13 +67,76 @@ QMatrix4x4& GLHandler::fullSkyboxSpaceTransform()
 	return fullSkyboxSpaceTransform;
 }
 
+QVector4D& GLHandler::directProjection()
+{
+	static QVector4D directProjection;
+	return directProjection;
+}
+
+GLBuffer*& GLHandler::cameraTransformsBuffer()
+{
+	static GLBuffer* cameraTransformsBuffer = nullptr;
+	return cameraTransformsBuffer;
+}
+
+// never a valid OpenGL enum or name
+static const GLuint unknownState = ~0u;
+
+struct GLHandler::State
+{
+	// capability -> GL_TRUE or GL_FALSE, absent or unknown if not set yet
+	QHash<GLenum, GLuint> enabled;
+	GLuint depthMask = unknownState;
+	GLuint depthFunc = unknownState;
+	// sfactor << 32 | dfactor
+	quint64 blendFunc    = ~0ull;
+	GLuint polygonMode   = unknownState;
+	GLuint cullFace      = unknownState;
+	GLuint frontFace     = unknownState;
+	GLuint program       = unknownState;
+	GLuint vao           = unknownState;
+	GLuint activeTexture = unknownState;
+	// unit << 32 | target -> texture
+	QHash<quint64, GLuint> textures;
+
+	StateCounters current;
+	StateCounters lastFrame;
+};
+
+GLHandler::State& GLHandler::state()
+{
+	static State state;
+	return state;
+}
+
+template <typename T>
+bool GLHandler::changes(T& shadow, T value)
+{
+	if(shadow == value)
+	{
+		++state().current.avoided;
+		return false;
+	}
+	shadow = value;
+	++state().current.issued;
+	return true;
+}
+
 bool GLHandler::init()
 {
 	glf().initializeOpenGLFunctions();
 	glf_ARB_compute_shader().initializeOpenGLFunctions();
+	glf_ARB_multi_draw_indirect().initializeOpenGLFunctions();
+
+	if(cameraTransformsBuffer() == nullptr)
+	{
+		cameraTransformsBuffer() = new GLBuffer(GL_UNIFORM_BUFFER,
+		                                         (7 * 16 + 4) * sizeof(GLfloat),
+		                                         GL_DYNAMIC_DRAW);
+	}
 
 	// enable depth test
-	glf().glEnable(GL_DEPTH_TEST);
+	setEnabled(GL_DEPTH_TEST, true);
 
 	// enable backface culling for optimization
 	setBackfaceCulling(true);
@@ -68,6 +144,12 @@ bool GLHandler::init()
 	return true;
 }
 
+void GLHandler::clean()
+{
+	delete cameraTransformsBuffer();
+	cameraTransformsBuffer() = nullptr;
+}
+
 void GLHandler::setPointSize(unsigned int size)
 {
 	glf().glPointSize(size);
@@ -99,38 +181,35 @@ void GLHandler::beginRendering(GLbitfield clearMask,
 
 void GLHandler::setUpRender(GLShaderProgram const& shader,
                             QMatrix4x4 const& model, GeometricSpace space)
+{
+	shader.setUniform("camera", getCameraMatrix(model, space));
+}
+
+QMatrix4x4 GLHandler::getCameraMatrix(QMatrix4x4 const& model,
+                                      GeometricSpace space)
 {
 	switch(space)
 	{
 		case GeometricSpace::CLIP:
-			shader.setUniform("camera", model);
-			break;
+			return model;
 		case GeometricSpace::WORLD:
-			shader.setUniform("camera", fullTransform() * model);
-			break;
+			return fullTransform() * model;
 		case GeometricSpace::EYE:
-			shader.setUniform("camera", fullEyeSpaceTransform() * model);
-			break;
+			return fullEyeSpaceTransform() * model;
 		case GeometricSpace::CAMERA:
-			shader.setUniform("camera", fullCameraSpaceTransform() * model);
-			break;
+			return fullCameraSpaceTransform() * model;
 		case GeometricSpace::SEATEDTRACKED:
-			shader.setUniform("camera",
-			                  fullSeatedTrackedSpaceTransform() * model);
-			break;
+			return fullSeatedTrackedSpaceTransform() * model;
 		case GeometricSpace::STANDINGTRACKED:
-			shader.setUniform("camera",
-			                  fullStandingTrackedSpaceTransform() * model);
-			break;
+			return fullStandingTrackedSpaceTransform() * model;
 		case GeometricSpace::HMD:
-			shader.setUniform("camera", fullHmdSpaceTransform() * model);
-			break;
+			return fullHmdSpaceTransform() * model;
 		case GeometricSpace::SKYBOX:
-			shader.setUniform("camera", fullSkyboxSpaceTransform() * model);
-			break;
+			return fullSkyboxSpaceTransform() * model;
 		default:
 			break;
 	};
+	return model;
 }
 
 void GLHandler::postProcess(
@@ -138,6 +217,7 @@ void GLHandler::postProcess(
     GLFramebufferObject const& to,
     std::vector<GLTexture const*> const& uniformTextures)
 {
+	GLProfiler::Scope scope("post process");
 	GLMesh quad;
 	quad.setVertexShaderMapping(shader, {{"position", 2}});
 	quad.setVertices({-1.f, -1.f, 1.f, -1.f, -1.f, 1.f, 1.f, 1.f});
@@ -157,12 +237,34 @@ void GLHandler::postProcess(
 	setBackfaceCulling(true);
 }
 
+void GLHandler::postProcessOver(GLShaderProgram const& shader,
+                                GLFramebufferObject const& from,
+                                GLFramebufferObject const& to)
+{
+	GLProfiler::Scope scope("post process");
+	GLMesh quad;
+	quad.setVertexShaderMapping(shader, {{"position", 2}});
+	quad.setVertices({-1.f, -1.f, 1.f, -1.f, -1.f, 1.f, 1.f, 1.f});
+
+	beginRendering(0, to);
+	shader.use();
+	useTextures({&from.getColorAttachmentTexture()});
+	setEnabled(GL_DEPTH_TEST, false);
+	beginTransparent(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	setBackfaceCulling(false);
+	quad.render(PrimitiveType::TRIANGLE_STRIP);
+	setBackfaceCulling(true);
+	endTransparent();
+	setEnabled(GL_DEPTH_TEST, true);
+}
+
 void GLHandler::postProcess(
     GLComputeShader const& shader, GLFramebufferObject const& inplace,
     std::vector<
         std::pair<GLTexture const*, GLComputeShader::DataAccessMode>> const&
         uniformTextures)
 {
+	GLProfiler::Scope scope("post process");
 	std::vector<std::pair<GLTexture const*, GLComputeShader::DataAccessMode>>
 	    texs;
 	texs.emplace_back(&inplace.getColorAttachmentTexture(),
@@ -184,6 +286,7 @@ void GLHandler::postProcess(
         std::pair<GLTexture const*, GLComputeShader::DataAccessMode>> const&
         uniformTextures)
 {
+	GLProfiler::Scope scope("post process");
 	std::vector<std::pair<GLTexture const*, GLComputeShader::DataAccessMode>>
 	    texs;
 	texs.emplace_back(&from.getColorAttachmentTexture(),
@@ -227,74 +330,156 @@ void GLHandler::renderFromScratch(GLShaderProgram const& shader,
 	}
 }
 
+// near plane of the cube map faces frustums
+static const float cubeNear = 0.1f;
+
+// pixels kept around the visible part of a face, for linear filtering
+static const int cubeMargin = 1;
+
+// bounds (left, right, bottom, top) in normalized device coordinates of the
+// part of a cube map face seeing the half space of direction eyeDir (in the
+// face camera space), false if it doesn't see it at all
+static bool visibleFaceBounds(QVector3D const& eyeDir,
+                              std::array<float, 4>& bounds)
+{
+	// the face pixel at (x, y) looks along (x, y, -1)
+	auto visible = [&eyeDir](QVector2D const& p) {
+		return p.x() * eyeDir.x() + p.y() * eyeDir.y() - eyeDir.z();
+	};
+	std::array<QVector2D, 4> const corners
+	    = {QVector2D(-1.f, -1.f), QVector2D(1.f, -1.f), QVector2D(1.f, 1.f),
+	       QVector2D(-1.f, 1.f)};
+
+	// clip the face square against the half space boundary
+	bounds     = {1.f, -1.f, 1.f, -1.f};
+	bool empty = true;
+	for(unsigned int i(0); i < corners.size(); ++i)
+	{
+		QVector2D const& a(corners.at(i));
+		QVector2D const& b(corners.at((i + 1) % corners.size()));
+		float va(visible(a)), vb(visible(b));
+		std::vector<QVector2D> points;
+		if(va >= 0.f)
+		{
+			points.push_back(a);
+		}
+		if((va >= 0.f) != (vb >= 0.f))
+		{
+			points.push_back(a + (b - a) * (va / (va - vb)));
+		}
+		for(QVector2D const& p : points)
+		{
+			bounds[0] = std::min(bounds[0], p.x());
+			bounds[1] = std::max(bounds[1], p.x());
+			bounds[2] = std::min(bounds[2], p.y());
+			bounds[3] = std::max(bounds[3], p.y());
+			empty     = false;
+		}
+	}
+	return !empty && bounds[0] < bounds[1] && bounds[2] < bounds[3];
+}
+
 void GLHandler::generateEnvironmentMap(
     GLFramebufferObject const& renderTarget,
     std::function<void(bool, QMatrix4x4, QMatrix4x4)> const& renderFunction,
-    QVector3D const& shift)
+    QVector3D const& shift, QVector3D const& hemisphere)
 {
-	QMatrix4x4 perspective;
-	perspective.perspective(90.f, 1.f, 0.1f, 10000.f);
+	for(unsigned int i(0); i < 6; ++i)
+	{
+		generateEnvironmentMapFace(renderTarget, renderFunction,
+		                           static_cast<GLTexture::CubemapFace>(i),
+		                           shift, hemisphere);
+	}
+}
 
+void GLHandler::generateEnvironmentMapFace(
+    GLFramebufferObject const& renderTarget,
+    std::function<void(bool, QMatrix4x4, QMatrix4x4)> const& renderFunction,
+    GLTexture::CubemapFace face, QVector3D const& shift,
+    QVector3D const& hemisphere)
+{
+	// look direction and up vector, in CubemapFace order
 	std::vector<QVector3D> vecs = {
 	    QVector3D(1, 0, 0),  QVector3D(0, -1, 0), QVector3D(-1, 0, 0),
 	    QVector3D(0, -1, 0), QVector3D(0, 1, 0),  QVector3D(0, 0, 1),
-	    QVector3D(0, -1, 0), QVector3D(0, 0, -1), QVector3D(0, 0, -1),
-	    QVector3D(0, -1, 0), QVector3D(0, 0, 1),  QVector3D(0, -1, 0),
+	    QVector3D(0, -1, 0), QVector3D(0, 0, -1), QVector3D(0, 0, 1),
+	    QVector3D(0, -1, 0), QVector3D(0, 0, -1), QVector3D(0, -1, 0),
 	};
 
-	std::vector<GLTexture::CubemapFace> faces = {
-	    GLTexture::CubemapFace::FRONT,  GLTexture::CubemapFace::BACK,
-	    GLTexture::CubemapFace::LEFT,   GLTexture::CubemapFace::RIGHT,
-	    GLTexture::CubemapFace::BOTTOM, GLTexture::CubemapFace::TOP,
-	};
+	auto i(static_cast<unsigned int>(face));
+	QMatrix4x4 cubeCamera;
+	cubeCamera.lookAt(QVector3D(0, 0, 0), vecs[2 * i], vecs[(2 * i) + 1]);
 
-	for(unsigned int i(0); i < 6; ++i)
+	// only render the pixels of the face that will be sampled
+	std::array<float, 4> bounds = {-1.f, 1.f, -1.f, 1.f};
+	if(!hemisphere.isNull()
+	   && !visibleFaceBounds(cubeCamera.mapVector(hemisphere), bounds))
+	{
+		return;
+	}
+	int side(renderTarget.getSize().width());
+	auto toPixel = [side](float ndc, bool upper) {
+		float p((ndc + 1.f) * 0.5f * side);
+		int pixel(upper ? static_cast<int>(std::ceil(p)) + cubeMargin
+		                : static_cast<int>(std::floor(p)) - cubeMargin);
+		return std::max(0, std::min(side, pixel));
+	};
+	std::array<int, 4> pixels = {};
+	for(unsigned int j(0); j < 4; ++j)
 	{
-		QMatrix4x4 cubeCamera;
-		cubeCamera.lookAt(QVector3D(0, 0, 0), vecs[2 * i], vecs[(2 * i) + 1]);
-		cubeCamera.translate(-1.f * shift);
-		GLHandler::beginRendering(renderTarget, faces[i]);
-		renderFunction(true, cubeCamera, perspective);
+		pixels.at(j) = toPixel(bounds.at(j), j % 2 == 1);
+		// snap the frustum to the pixels grid
+		bounds.at(j) = (2.f * pixels.at(j) / side) - 1.f;
 	}
+
+	// off-center part of a 90 degrees frustum, so that the scene can cull
+	// what falls outside of the rendered pixels
+	QMatrix4x4 perspective;
+	perspective.frustum(bounds[0] * cubeNear, bounds[1] * cubeNear,
+	                    bounds[2] * cubeNear, bounds[3] * cubeNear, cubeNear,
+	                    10000.f);
+
+	GLProfiler::Scope scope("environment map face");
+	cubeCamera.translate(-1.f * shift);
+	GLHandler::beginRendering(renderTarget, face);
+	glf().glViewport(pixels[0], pixels[2], pixels[1] - pixels[0],
+	                 pixels[3] - pixels[2]);
+	renderFunction(true, cubeCamera, perspective);
 }
 
 void GLHandler::beginWireframe()
 {
-	GLHandler::glf().glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+	setPolygonMode(GL_LINE);
 }
 
 void GLHandler::endWireframe()
 {
-	GLHandler::glf().glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	setPolygonMode(GL_FILL);
 }
 
 void GLHandler::beginTransparent(GLenum blendfuncSfactor,
                                  GLenum blendfuncDfactor)
 {
-	glf().glDepthMask(GL_FALSE);
+	setDepthMask(false);
 	// enable transparency
-	glf().glEnable(GL_BLEND);
-	glf().glBlendFunc(blendfuncSfactor, blendfuncDfactor);
+	setEnabled(GL_BLEND, true);
+	setBlendFunc(blendfuncSfactor, blendfuncDfactor);
 }
 
 void GLHandler::endTransparent()
 {
-	glf().glDepthMask(GL_TRUE);
-	glf().glDisable(GL_BLEND);
+	setDepthMask(true);
+	setEnabled(GL_BLEND, false);
 }
 
 void GLHandler::setBackfaceCulling(bool on, GLenum faceToCull,
                                    GLenum frontFaceWindingOrder)
 {
+	setEnabled(GL_CULL_FACE, on);
 	if(on)
 	{
-		glf().glEnable(GL_CULL_FACE);
-		glf().glCullFace(faceToCull);
-		glf().glFrontFace(frontFaceWindingOrder);
-	}
-	else
-	{
-		glf().glDisable(GL_CULL_FACE);
+		setCullFace(faceToCull);
+		setFrontFace(frontFaceWindingOrder);
 	}
 }
 
@@ -320,6 +505,207 @@ void GLHandler::setUpTransforms(
 	    = fullStandingTrackedSpaceTransform;
 	GLHandler::fullHmdSpaceTransform()    = fullHmdSpaceTransform;
 	GLHandler::fullSkyboxSpaceTransform() = fullSkyboxSpaceTransform;
+
+	if(cameraTransformsBuffer() == nullptr)
+	{
+		return;
+	}
+	// same order as camera.glsl
+	std::array<QMatrix4x4 const*, 7> matrices
+	    = {{&fullTransform, &fullEyeSpaceTransform, &fullCameraSpaceTransform,
+	        &fullSeatedTrackedSpaceTransform,
+	        &fullStandingTrackedSpaceTransform, &fullHmdSpaceTransform,
+	        &fullSkyboxSpaceTransform}};
+	std::array<GLfloat, 7 * 16 + 4> data = {};
+	for(unsigned int i(0); i < matrices.size(); ++i)
+	{
+		std::copy(matrices.at(i)->constData(),
+		          matrices.at(i)->constData() + 16, &data.at(i * 16));
+	}
+	for(int i(0); i < 4; ++i)
+	{
+		data.at(7 * 16 + i) = directProjection()[i];
+	}
+	cameraTransformsBuffer()->setSubData(0, &data[0], data.size());
+	cameraTransformsBuffer()->bindBase(cameraTransformsBinding);
+}
+
+void GLHandler::setDirectProjection(unsigned int projection,
+                                    QSize const& size)
+{
+	directProjection() = QVector4D(projection, size.width(), size.height(), 0);
+}
+
+unsigned int GLHandler::getDirectProjection()
+{
+	return static_cast<unsigned int>(directProjection().x());
+}
+
+QSize GLHandler::getDirectProjectionSize()
+{
+	return {static_cast<int>(directProjection().y()),
+	        static_cast<int>(directProjection().z())};
+}
+
+void GLHandler::beginFrame()
+{
+	State& s(state());
+	s.lastFrame = s.current;
+	s.current   = StateCounters();
+	invalidateState();
+}
+
+void GLHandler::invalidateState()
+{
+	State& s(state());
+	State fresh;
+	fresh.current   = s.current;
+	fresh.lastFrame = s.lastFrame;
+	s               = fresh;
+}
+
+GLHandler::StateCounters GLHandler::getLastFrameStateCounters()
+{
+	return state().lastFrame;
+}
+
+void GLHandler::setEnabled(GLenum capability, bool enabled)
+{
+	QHash<GLenum, GLuint>& shadows(state().enabled);
+	auto it(shadows.find(capability));
+	if(it == shadows.end())
+	{
+		it = shadows.insert(capability, unknownState);
+	}
+	if(!changes(it.value(), static_cast<GLuint>(enabled ? GL_TRUE : GL_FALSE)))
+	{
+		return;
+	}
+	if(enabled)
+	{
+		glf().glEnable(capability);
+	}
+	else
+	{
+		glf().glDisable(capability);
+	}
+}
+
+void GLHandler::setDepthMask(bool enabled)
+{
+	GLboolean flag(enabled ? GL_TRUE : GL_FALSE);
+	if(changes(state().depthMask, static_cast<GLuint>(flag)))
+	{
+		glf().glDepthMask(flag);
+	}
+}
+
+void GLHandler::setDepthFunc(GLenum func)
+{
+	if(changes(state().depthFunc, func))
+	{
+		glf().glDepthFunc(func);
+	}
+}
+
+void GLHandler::setBlendFunc(GLenum sfactor, GLenum dfactor)
+{
+	quint64 func((static_cast<quint64>(sfactor) << 32u) | dfactor);
+	if(changes(state().blendFunc, func))
+	{
+		glf().glBlendFunc(sfactor, dfactor);
+	}
+}
+
+void GLHandler::setPolygonMode(GLenum mode)
+{
+	if(changes(state().polygonMode, mode))
+	{
+		glf().glPolygonMode(GL_FRONT_AND_BACK, mode);
+	}
+}
+
+void GLHandler::setCullFace(GLenum face)
+{
+	if(changes(state().cullFace, face))
+	{
+		glf().glCullFace(face);
+	}
+}
+
+void GLHandler::setFrontFace(GLenum mode)
+{
+	if(changes(state().frontFace, mode))
+	{
+		glf().glFrontFace(mode);
+	}
+}
+
+void GLHandler::useProgram(GLuint program)
+{
+	if(changes(state().program, program))
+	{
+		glf().glUseProgram(program);
+	}
+}
+
+void GLHandler::bindVertexArray(GLuint vao)
+{
+	if(changes(state().vao, vao))
+	{
+		glf().glBindVertexArray(vao);
+	}
+}
+
+void GLHandler::bindTexture(GLenum target, GLuint texture,
+                            GLenum textureUnit)
+{
+	if(changes(state().activeTexture, textureUnit))
+	{
+		glf().glActiveTexture(textureUnit);
+	}
+	bindTexture(target, texture);
+}
+
+void GLHandler::bindTexture(GLenum target, GLuint texture)
+{
+	State& s(state());
+	if(s.activeTexture == unknownState)
+	{
+		// can't know which unit it will be bound to
+		++s.current.issued;
+		glf().glBindTexture(target, texture);
+		return;
+	}
+	quint64 key((static_cast<quint64>(s.activeTexture) << 32u) | target);
+	auto it(s.textures.find(key));
+	if(it == s.textures.end())
+	{
+		it = s.textures.insert(key, unknownState);
+	}
+	if(changes(it.value(), texture))
+	{
+		glf().glBindTexture(target, texture);
+	}
+}
+
+void GLHandler::forgetVertexArray(GLuint vao)
+{
+	if(state().vao == vao)
+	{
+		state().vao = 0;
+	}
+}
+
+void GLHandler::forgetTexture(GLuint texture)
+{
+	for(GLuint& bound : state().textures)
+	{
+		if(bound == texture)
+		{
+			bound = 0;
+		}
+	}
 }
 
 void GLHandler::useTextures(std::vector<GLTexture const*> const& textures)
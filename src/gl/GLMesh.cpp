@@ -43,6 +43,7 @@ void GLMesh::cleanUp()
 	--instancesCount();
 	delete vbo;
 	delete ebo;
+	GLHandler::forgetVertexArray(vao);
 	GLHandler::glf().glDeleteVertexArrays(1, &vao);
 	doClean = false;
 }
@@ -51,7 +52,7 @@ void GLMesh::setVertexShaderMapping(
     GLShaderProgram const& shaderProgram,
     std::vector<QPair<const char*, unsigned int>> const& mapping)
 {
-	GLHandler::glf().glBindVertexArray(vao);
+	GLHandler::bindVertexArray(vao);
 
 	size_t offset = 0, stride = 0;
 	for(auto map : mapping)
@@ -77,7 +78,7 @@ void GLMesh::setVertexShaderMapping(
 	vertexSize = offset * sizeof(float);
 
 	ebo->bind();
-	GLHandler::glf().glBindVertexArray(0);
+	GLHandler::bindVertexArray(0);
 }
 
 void GLMesh::setVertexShaderMapping(
@@ -129,7 +130,7 @@ void GLMesh::render(PrimitiveType primitiveType) const
 		                                      : PrimitiveType::TRIANGLES;
 	}
 
-	GLHandler::glf().glBindVertexArray(vao);
+	GLHandler::bindVertexArray(vao);
 	if(ebo->getSize() == 0)
 	{
 		GLHandler::glf().glDrawArrays(static_cast<GLenum>(primitiveType), 0,
@@ -141,5 +142,5 @@ void GLMesh::render(PrimitiveType primitiveType) const
 		                                ebo->getSize() / sizeof(unsigned int),
 		                                GL_UNSIGNED_INT, nullptr);
 	}
-	GLHandler::glf().glBindVertexArray(0);
+	GLHandler::bindVertexArray(0);
 }
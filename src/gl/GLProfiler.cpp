@@ -0,0 +1,235 @@
+/*
+    Copyright (C) 2020 Florian Cabot <florian.cabot@hotmail.fr>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#include "gl/GLProfiler.hpp"
+
+#include <QFile>
+#include <QTextStream>
+
+#include "gl/GLHandler.hpp"
+
+// weight of the last frame read back in the averages
+static const float smoothing = 0.05f;
+
+void GLProfiler::setEnabled(bool enabled)
+{
+	State& s(state());
+	if(enabled == s.enabled)
+	{
+		return;
+	}
+	s.enabled   = enabled;
+	s.profiling = false;
+	s.stack.clear();
+	s.timings.clear();
+	// results of frames still in flight would be read after a gap
+	for(auto& frame : s.frames)
+	{
+		frame.pending = false;
+	}
+}
+
+void GLProfiler::beginFrame()
+{
+	State& s(state());
+	s.profiling = false;
+	if(!s.enabled)
+	{
+		return;
+	}
+
+	Frame& frame(s.frames.at(s.frame % latency));
+	if(frame.pending)
+	{
+		// timestamps complete in order, the last one is written last
+		GLint available(GL_FALSE);
+		GLHandler::glf().glGetQueryObjectiv(
+		    frame.queries.at(frame.usedQueries - 1), GL_QUERY_RESULT_AVAILABLE,
+		    &available);
+		if(available == GL_FALSE)
+		{
+			// never stall, this frame won't be profiled
+			return;
+		}
+		read(frame);
+	}
+	frame.usedQueries = 0;
+	frame.samples.clear();
+	s.stack.clear();
+	s.profiling = true;
+}
+
+void GLProfiler::endFrame()
+{
+	State& s(state());
+	if(!s.profiling)
+	{
+		return;
+	}
+	// scopes still open end with the frame
+	while(!s.stack.empty())
+	{
+		end();
+	}
+	Frame& frame(s.frames.at(s.frame % latency));
+	frame.pending = frame.usedQueries > 0;
+	++s.frame;
+	s.profiling = false;
+}
+
+QString GLProfiler::toString()
+{
+	QString result;
+	for(auto const& timing : state().timings)
+	{
+		result += QString(2 * timing.depth, ' ')
+		          + timing.name + " : "
+		          + QString::number(timing.average, 'f', 2) + " ms\n";
+	}
+	return result;
+}
+
+bool GLProfiler::exportToFile(QString const& path)
+{
+	QFile file(path);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+	{
+		qWarning() << "Could not write GPU profile to" << path;
+		return false;
+	}
+	QTextStream stream(&file);
+	stream << "scope,depth,average (ms),last (ms)\n";
+	for(auto const& timing : state().timings)
+	{
+		stream << '"' << timing.path << "\"," << timing.depth << ','
+		       << timing.average << ',' << timing.last << '\n';
+	}
+	return true;
+}
+
+void GLProfiler::clean()
+{
+	setEnabled(false);
+	for(auto& frame : state().frames)
+	{
+		if(!frame.queries.empty())
+		{
+			GLHandler::glf().glDeleteQueries(frame.queries.size(),
+			                                 &frame.queries[0]);
+		}
+		frame = Frame();
+	}
+}
+
+GLProfiler::State& GLProfiler::state()
+{
+	static State state;
+	return state;
+}
+
+bool GLProfiler::begin(QString const& name)
+{
+	State& s(state());
+	if(!s.profiling)
+	{
+		return false;
+	}
+
+	Frame& frame(s.frames.at(s.frame % latency));
+	Sample sample;
+	sample.path = s.stack.empty()
+	                  ? name
+	                  : frame.samples.at(s.stack.back()).path + '/' + name;
+	sample.name  = name;
+	sample.depth = s.stack.size();
+	sample.begin = timestamp();
+	sample.end   = sample.begin;
+	s.stack.push_back(frame.samples.size());
+	frame.samples.push_back(sample);
+	return true;
+}
+
+void GLProfiler::end()
+{
+	State& s(state());
+	// the scope's frame already ended
+	if(!s.profiling || s.stack.empty())
+	{
+		return;
+	}
+
+	Frame& frame(s.frames.at(s.frame % latency));
+	frame.samples.at(s.stack.back()).end = timestamp();
+	s.stack.pop_back();
+}
+
+unsigned int GLProfiler::timestamp()
+{
+	Frame& frame(state().frames.at(state().frame % latency));
+	if(frame.usedQueries == frame.queries.size())
+	{
+		frame.queries.push_back(0);
+		GLHandler::glf().glGenQueries(1, &frame.queries.back());
+	}
+	GLHandler::glf().glQueryCounter(frame.queries.at(frame.usedQueries),
+	                                GL_TIMESTAMP);
+	return frame.usedQueries++;
+}
+
+void GLProfiler::read(Frame& frame)
+{
+	State& s(state());
+	std::vector<GLuint64> times(frame.usedQueries);
+	for(unsigned int i(0); i < frame.usedQueries; ++i)
+	{
+		GLHandler::glf().glGetQueryObjectui64v(frame.queries.at(i),
+		                                       GL_QUERY_RESULT, &times.at(i));
+	}
+	frame.pending = false;
+
+	QHash<QString, float> averages;
+	for(auto const& timing : s.timings)
+	{
+		averages[timing.path] = timing.average;
+	}
+
+	// a scope can run several times per frame (cube map faces for example)
+	std::vector<Timing> timings;
+	QHash<QString, unsigned int> indices;
+	for(auto const& sample : frame.samples)
+	{
+		float time((times.at(sample.end) - times.at(sample.begin)) * 1.e-6f);
+		auto it(indices.find(sample.path));
+		if(it != indices.end())
+		{
+			timings.at(*it).last += time;
+			continue;
+		}
+		indices[sample.path] = timings.size();
+		timings.push_back(
+		    {sample.path, sample.name, sample.depth, 0.f, time});
+	}
+	for(auto& timing : timings)
+	{
+		auto it(averages.find(timing.path));
+		timing.average = it == averages.end()
+		                     ? timing.last
+		                     : *it + smoothing * (timing.last - *it);
+	}
+	s.timings = std::move(timings);
+}
@@ -20,6 +20,13 @@
 
 #include "gl/GLShaderProgram.hpp"
 
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
 unsigned int& GLShaderProgram::instancesCount()
 {
 	static unsigned int instancesCount = 0;
@@ -48,6 +55,11 @@ GLShaderProgram::GLShaderProgram(
 {
 	++instancesCount();
 
+	// (path, GLenum stage) and preprocessed sources, which identify the
+	// program in the cache
+	std::vector<std::pair<QString, GLenum>> stages;
+	std::vector<QString> sources;
+	QCryptographicHash hash(QCryptographicHash::Sha1);
 	for(auto const& stage : pipeline)
 	{
 		QString name(stage.first);
@@ -57,17 +69,40 @@ GLShaderProgram::GLShaderProgram(
 		{
 			name = "shaders/" + name + pair.first;
 		}
-		// vertex shader
-		GLuint shader(loadShader(name, pair.second, defines));
-		GLHandler::glf().glAttachShader(glShaderProgram, shader);
-		GLHandler::glf().glDeleteShader(shader);
+		stages.emplace_back(name, pair.second);
+		sources.push_back(getFullPreprocessedSource(name, defines));
+
+		hash.addData(name.toUtf8());
+		hash.addData(QByteArray::number(pair.second));
+		hash.addData(sources.back().toUtf8());
+	}
+	for(auto const& key : defines.keys())
+	{
+		hash.addData(key.toUtf8());
+		hash.addData(defines.value(key).toUtf8());
 	}
+	QByteArray key(hash.result());
 
-	GLHandler::glf().glBindFragDataLocation(
-	    glShaderProgram, 0,
-	    "outColor"); // optional for one buffer
-	GLHandler::glf().glLinkProgram(glShaderProgram);
+	if(!loadFromCache(key))
+	{
+		for(unsigned int i(0); i < stages.size(); ++i)
+		{
+			GLuint shader(
+			    loadShader(stages[i].first, stages[i].second, sources[i]));
+			GLHandler::glf().glAttachShader(glShaderProgram, shader);
+			GLHandler::glf().glDeleteShader(shader);
+		}
+
+		GLHandler::glf().glBindFragDataLocation(
+		    glShaderProgram, 0,
+		    "outColor"); // optional for one buffer
+		GLHandler::glf().glProgramParameteri(
+		    glShaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		GLHandler::glf().glLinkProgram(glShaderProgram);
+		storeInCache(key);
+	}
 	GLHandler::glf().glValidateProgram(glShaderProgram);
+	resolveUniforms();
 }
 
 void GLShaderProgram::cleanUp()
@@ -77,7 +112,7 @@ void GLShaderProgram::cleanUp()
 		return;
 	}
 	--instancesCount();
-	GLHandler::glf().glUseProgram(0);
+	GLHandler::useProgram(0);
 	GLHandler::glf().glDeleteProgram(glShaderProgram);
 	doClean = false;
 }
@@ -137,43 +172,101 @@ void GLShaderProgram::setUnusedAttributesValues(
 
 void GLShaderProgram::setUniform(const char* paramName, int value) const
 {
-	use();
-	GLHandler::glf().glUniform1i(
-	    GLHandler::glf().glGetUniformLocation(glShaderProgram, paramName),
-	    value);
+	setUniform(getUniformLocation(paramName), value);
 }
 
 void GLShaderProgram::setUniform(const char* paramName, float value) const
 {
-	use();
-	GLHandler::glf().glUniform1f(
-	    GLHandler::glf().glGetUniformLocation(glShaderProgram, paramName),
-	    value);
+	setUniform(getUniformLocation(paramName), value);
 }
 
 void GLShaderProgram::setUniform(const char* paramName,
                                  QVector2D const& value) const
 {
-	use();
-	GLHandler::glf().glUniform2f(
-	    GLHandler::glf().glGetUniformLocation(glShaderProgram, paramName),
-	    value.x(), value.y());
+	setUniform(getUniformLocation(paramName), value);
 }
 
 void GLShaderProgram::setUniform(const char* paramName,
                                  QVector3D const& value) const
 {
-	use();
-	GLHandler::glf().glUniform3f(
-	    GLHandler::glf().glGetUniformLocation(glShaderProgram, paramName),
-	    value.x(), value.y(), value.z());
+	setUniform(getUniformLocation(paramName), value);
 }
 
 void GLShaderProgram::setUniform(const char* paramName, unsigned int size,
                                  QVector3D const* values) const
+{
+	setUniform(getUniformLocation(paramName), size, values);
+}
+
+void GLShaderProgram::setUniform(const char* paramName,
+                                 QVector4D const& value) const
+{
+	setUniform(getUniformLocation(paramName), value);
+}
+
+void GLShaderProgram::setUniform(const char* paramName, unsigned int size,
+                                 QVector4D const* values) const
+{
+	setUniform(getUniformLocation(paramName), size, values);
+}
+
+void GLShaderProgram::setUniform(const char* paramName,
+                                 QMatrix4x4 const& value) const
+{
+	setUniform(getUniformLocation(paramName), value);
+}
+
+void GLShaderProgram::setUniform(const char* paramName, QColor const& value,
+                                 bool sRGB) const
+{
+	setUniform(getUniformLocation(paramName), value, sRGB);
+}
+
+GLint GLShaderProgram::getUniformLocation(const char* paramName) const
+{
+	// avoid allocating for the lookup
+	QByteArray name(QByteArray::fromRawData(paramName, qstrlen(paramName)));
+	auto it(uniformLocations.find(name));
+	if(it != uniformLocations.end())
+	{
+		return it.value();
+	}
+	// not active or array element, ask OpenGL once
+	GLint location(
+	    GLHandler::glf().glGetUniformLocation(glShaderProgram, paramName));
+	uniformLocations.insert(QByteArray(paramName), location);
+	return location;
+}
+
+void GLShaderProgram::setUniform(GLint location, int value) const
+{
+	use();
+	GLHandler::glf().glUniform1i(location, value);
+}
+
+void GLShaderProgram::setUniform(GLint location, float value) const
+{
+	use();
+	GLHandler::glf().glUniform1f(location, value);
+}
+
+void GLShaderProgram::setUniform(GLint location, QVector2D const& value) const
+{
+	use();
+	GLHandler::glf().glUniform2f(location, value.x(), value.y());
+}
+
+void GLShaderProgram::setUniform(GLint location, QVector3D const& value) const
+{
+	use();
+	GLHandler::glf().glUniform3f(location, value.x(), value.y(), value.z());
+}
+
+void GLShaderProgram::setUniform(GLint location, unsigned int size,
+                                 QVector3D const* values) const
 {
 	use();
-	auto data = new GLfloat[3 * size];
+	std::vector<GLfloat> data(3 * size);
 	for(unsigned int i(0); i < size; ++i)
 	{
 		for(unsigned int j(0); j < 3; ++j)
@@ -181,26 +274,21 @@ void GLShaderProgram::setUniform(const char* paramName, unsigned int size,
 			data[i * 3 + j] = values[i][j];
 		}
 	}
-	GLHandler::glf().glUniform3fv(
-	    GLHandler::glf().glGetUniformLocation(glShaderProgram, paramName), size,
-	    &(data[0]));
-	delete[] data;
+	GLHandler::glf().glUniform3fv(location, size, data.data());
 }
 
-void GLShaderProgram::setUniform(const char* paramName,
-                                 QVector4D const& value) const
+void GLShaderProgram::setUniform(GLint location, QVector4D const& value) const
 {
 	use();
-	GLHandler::glf().glUniform4f(
-	    GLHandler::glf().glGetUniformLocation(glShaderProgram, paramName),
-	    value.x(), value.y(), value.z(), value.w());
+	GLHandler::glf().glUniform4f(location, value.x(), value.y(), value.z(),
+	                             value.w());
 }
 
-void GLShaderProgram::setUniform(const char* paramName, unsigned int size,
+void GLShaderProgram::setUniform(GLint location, unsigned int size,
                                  QVector4D const* values) const
 {
 	use();
-	auto data = new GLfloat[4 * size];
+	std::vector<GLfloat> data(4 * size);
 	for(unsigned int i(0); i < size; ++i)
 	{
 		for(unsigned int j(0); j < 4; ++j)
@@ -208,31 +296,27 @@ void GLShaderProgram::setUniform(const char* paramName, unsigned int size,
 			data[i * 4 + j] = values[i][j];
 		}
 	}
-	GLHandler::glf().glUniform4fv(
-	    GLHandler::glf().glGetUniformLocation(glShaderProgram, paramName), size,
-	    &(data[0]));
-	delete[] data;
+	GLHandler::glf().glUniform4fv(location, size, data.data());
 }
 
-void GLShaderProgram::setUniform(const char* paramName,
+void GLShaderProgram::setUniform(GLint location,
                                  QMatrix4x4 const& value) const
 {
 	use();
-	GLHandler::glf().glUniformMatrix4fv(
-	    GLHandler::glf().glGetUniformLocation(glShaderProgram, paramName), 1,
-	    GL_FALSE, value.data());
+	GLHandler::glf().glUniformMatrix4fv(location, 1, GL_FALSE, value.data());
 }
 
-void GLShaderProgram::setUniform(const char* paramName, QColor const& value,
+void GLShaderProgram::setUniform(GLint location, QColor const& value,
                                  bool sRGB) const
 {
 	QColor linVal(sRGB ? GLHandler::sRGBToLinear(value) : value);
-	setUniform(paramName,
+	setUniform(location,
 	           QVector3D(linVal.redF(), linVal.greenF(), linVal.blueF()));
 }
+
 void GLShaderProgram::use() const
 {
-	GLHandler::glf().glUseProgram(glShaderProgram);
+	GLHandler::useProgram(glShaderProgram);
 }
 
 void GLShaderProgram::get(GLenum pname, GLint* params) const
@@ -240,6 +324,45 @@ void GLShaderProgram::get(GLenum pname, GLint* params) const
 	GLHandler::glf().glGetProgramiv(glShaderProgram, pname, params);
 }
 
+void GLShaderProgram::resolveUniforms()
+{
+	GLint count(0), maxLength(0);
+	get(GL_ACTIVE_UNIFORMS, &count);
+	get(GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::vector<GLchar> buffer(maxLength + 1);
+	for(GLint i(0); i < count; ++i)
+	{
+		GLsizei length(0);
+		GLint size(0);
+		GLenum type(0);
+		GLHandler::glf().glGetActiveUniform(glShaderProgram, i, buffer.size(),
+		                                    &length, &size, &type,
+		                                    buffer.data());
+		QByteArray name(buffer.data(), length);
+		// uniform block members don't have a location
+		GLint location(GLHandler::glf().glGetUniformLocation(glShaderProgram,
+		                                                     name.constData()));
+		if(location == -1)
+		{
+			continue;
+		}
+		uniformLocations.insert(name, location);
+		// arrays are named "name[0]"
+		if(name.endsWith("[0]"))
+		{
+			uniformLocations.insert(name.left(name.size() - 3), location);
+		}
+	}
+
+	GLuint cameraBlock(GLHandler::glf().glGetUniformBlockIndex(
+	    glShaderProgram, "CameraTransforms"));
+	if(cameraBlock != GL_INVALID_INDEX)
+	{
+		GLHandler::glf().glUniformBlockBinding(
+		    glShaderProgram, cameraBlock, GLHandler::cameraTransformsBinding);
+	}
+}
+
 std::pair<QString, GLenum> GLShaderProgram::decodeStage(Stage s)
 {
 	switch(s)
@@ -264,6 +387,90 @@ std::pair<QString, GLenum> GLShaderProgram::decodeStage(Stage s)
 QString GLShaderProgram::getFullPreprocessedSource(
     QString const& path, QMap<QString, QString> const& defines)
 {
+	QString source(getExpandedSource(path).source);
+
+	// add defines after #version
+	int definesInsertPoint(source.indexOf("#version"));
+	definesInsertPoint = source.indexOf('\n', definesInsertPoint) + 1;
+	for(auto const& key : defines.keys())
+	{
+		source.insert(definesInsertPoint, QString("#define ") + key + " "
+		                                      + defines.value(key) + "\n");
+	}
+
+	return source;
+}
+
+GLShaderProgram::ExpandedSource const&
+    GLShaderProgram::getExpandedSource(QString const& path)
+{
+	// common includes (camera.glsl, ...) are only expanded once, unless one
+	// of the files changed on disk
+	static QHash<QString, ExpandedSource> cache;
+	auto it(cache.find(path));
+	if(it != cache.end())
+	{
+		bool upToDate(true);
+		for(auto const& file : it->files)
+		{
+			upToDate = upToDate
+			           && QFileInfo(file.first).lastModified() == file.second;
+		}
+		if(upToDate)
+		{
+			return *it;
+		}
+	}
+
+	ExpandedSource entry;
+	entry.source = getStrippedSource(path);
+	entry.files.push_back(getStrippedSourceFile(path));
+
+	// include other expanded sources within source
+	int includePos(entry.source.indexOf("#include"));
+	while(includePos != -1)
+	{
+		int beginPath(entry.source.indexOf('<', includePos));
+		int endPath(entry.source.indexOf('>', includePos));
+		int endOfLine(entry.source.indexOf('\n', includePos));
+
+		// copy, inserting in cache can invalidate references
+		ExpandedSource included(getExpandedSource(
+		    entry.source.mid(beginPath + 1, endPath - beginPath - 1)));
+		entry.source.replace(includePos, endOfLine - includePos,
+		                     included.source);
+		entry.files.insert(entry.files.end(), included.files.begin(),
+		                   included.files.end());
+
+		includePos = entry.source.indexOf("#include", includePos);
+	}
+
+	return *cache.insert(path, entry);
+}
+
+std::pair<QString, QDateTime>
+    GLShaderProgram::getStrippedSourceFile(QString const& path)
+{
+	QFileInfo info(getAbsoluteDataPath(path));
+	if(!info.exists())
+	{
+		info.setFile(getAbsoluteDataPath("shaders/" + path));
+	}
+	return {info.absoluteFilePath(), info.lastModified()};
+}
+
+QString GLShaderProgram::getStrippedSource(QString const& path)
+{
+	// files included by several programs are only read once, unless they
+	// changed on disk
+	static QHash<QString, StrippedSource> cache;
+	auto it(cache.find(path));
+	if(it != cache.end()
+	   && QFileInfo(it->absolutePath).lastModified() == it->lastModified)
+	{
+		return it->source;
+	}
+
 	// Read source
 	QFile f(getAbsoluteDataPath(path));
 	if(!f.exists())
@@ -292,37 +499,17 @@ QString GLShaderProgram::getFullPreprocessedSource(
 		commentPos = source.indexOf("/*", commentPos);
 	}
 
-	// include other preprocessed sources within source
-	int includePos(source.indexOf("#include"));
-	while(includePos != -1)
-	{
-		int beginPath(source.indexOf('<', includePos));
-		int endPath(source.indexOf('>', includePos));
-		int endOfLine(source.indexOf('\n', includePos));
-
-		QString includedSrc(getFullPreprocessedSource(
-		    source.mid(beginPath + 1, endPath - beginPath - 1), defines));
-		source.replace(includePos, endOfLine - includePos, includedSrc);
-
-		includePos = source.indexOf("#include", includePos);
-	}
-
-	// add defines after #version
-	int definesInsertPoint(source.indexOf("#version"));
-	definesInsertPoint = source.indexOf('\n', definesInsertPoint) + 1;
-	for(auto const& key : defines.keys())
-	{
-		source.insert(definesInsertPoint, QString("#define ") + key + " "
-		                                      + defines.value(key) + "\n");
-	}
-
+	StrippedSource entry;
+	entry.absolutePath = QFileInfo(f).absoluteFilePath();
+	entry.lastModified = QFileInfo(f).lastModified();
+	entry.source       = source;
+	cache.insert(path, entry);
 	return source;
 }
 
 GLuint GLShaderProgram::loadShader(QString const& path, GLenum shaderType,
-                                   QMap<QString, QString> const& defines)
+                                   QString const& source)
 {
-	QString source(getFullPreprocessedSource(path, defines));
 	QByteArray ba     = source.toLatin1();
 	const char* bytes = ba.data();
 
@@ -342,3 +529,105 @@ GLuint GLShaderProgram::loadShader(QString const& path, GLenum shaderType,
 
 	return shader;
 }
+
+QHash<QByteArray, GLShaderProgram::ProgramBinary>&
+    GLShaderProgram::programCache()
+{
+	static QHash<QByteArray, ProgramBinary> programCache;
+	return programCache;
+}
+
+QString GLShaderProgram::getDiskCachePath(QByteArray const& key)
+{
+	// binaries are only valid for the driver that produced them
+	static QByteArray driver;
+	if(driver.isEmpty())
+	{
+		for(GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+		{
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			driver += reinterpret_cast<const char*>(
+			    GLHandler::glf().glGetString(name));
+			driver += '\n';
+		}
+	}
+
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	hash.addData(driver);
+	hash.addData(key);
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+	       + "/shaders/" + hash.result().toHex() + ".bin";
+}
+
+bool GLShaderProgram::loadFromCache(QByteArray const& key) const
+{
+	auto it(programCache().find(key));
+	if(it == programCache().end())
+	{
+		// previous launches
+		QFile file(getDiskCachePath(key));
+		if(!file.open(QFile::ReadOnly))
+		{
+			return false;
+		}
+		QDataStream in(&file);
+		quint32 version(0), format(0);
+		ProgramBinary binary;
+		in >> version >> format >> binary.data;
+		if(in.status() != QDataStream::Ok || version != diskCacheVersion)
+		{
+			return false;
+		}
+		binary.format = format;
+		it            = programCache().insert(key, binary);
+	}
+	GLHandler::glf().glProgramBinary(glShaderProgram, it->format,
+	                                 it->data.constData(), it->data.size());
+	GLint status(GL_FALSE);
+	get(GL_LINK_STATUS, &status);
+	if(status != GL_TRUE)
+	{
+		// binary rejected by the driver, compile from sources again
+		programCache().remove(key);
+		QFile::remove(getDiskCachePath(key));
+		return false;
+	}
+	return true;
+}
+
+void GLShaderProgram::storeInCache(QByteArray const& key) const
+{
+	GLint status(GL_FALSE), length(0);
+	get(GL_LINK_STATUS, &status);
+	get(GL_PROGRAM_BINARY_LENGTH, &length);
+	// no binary format supported or link errors
+	if(status != GL_TRUE || length <= 0)
+	{
+		return;
+	}
+
+	ProgramBinary binary;
+	binary.data.resize(length);
+	GLHandler::glf().glGetProgramBinary(glShaderProgram, length, nullptr,
+	                                    &binary.format,
+	                                    binary.data.data());
+	programCache().insert(key, binary);
+
+	QString path(getDiskCachePath(key));
+	QDir().mkpath(QFileInfo(path).absolutePath());
+	// written to a temporary file then renamed, a crash can't leave a
+	// truncated binary behind
+	QSaveFile file(path);
+	if(!file.open(QFile::WriteOnly))
+	{
+		qWarning() << "Can't write shader cache file" << path;
+		return;
+	}
+	QDataStream out(&file);
+	out << diskCacheVersion << static_cast<quint32>(binary.format)
+	    << binary.data;
+	if(out.status() != QDataStream::Ok || !file.commit())
+	{
+		qWarning() << "Can't write shader cache file" << path;
+	}
+}
@@ -67,12 +67,12 @@ GLTexture::GLTexture(TexMultisampleProperties const& properties,
 	samples        = properties.samples;
 
 	GLHandler::glf().glGenTextures(1, &glTexture);
-	GLHandler::glf().glBindTexture(glTarget, glTexture);
+	GLHandler::bindTexture(glTarget, glTexture);
 	GLHandler::glf().glTexImage2DMultisample(glTarget, properties.samples,
 	                                         internalFormat, properties.width,
 	                                         properties.height, GL_TRUE);
 	// glGenerateMipmap(target);
-	GLHandler::glf().glBindTexture(glTarget, 0);
+	GLHandler::bindTexture(glTarget, 0);
 	setSampler(sampler);
 }
 
@@ -191,12 +191,12 @@ GLTexture::GLTexture(std::array<const char*, 6> const& texturesPaths, bool sRGB)
 QSize GLTexture::getSize(unsigned int level) const
 {
 	GLint width, height;
-	GLHandler::glf().glBindTexture(glTarget, glTexture);
+	GLHandler::bindTexture(glTarget, glTexture);
 	GLHandler::glf().glGetTexLevelParameteriv(glTarget, level, GL_TEXTURE_WIDTH,
 	                                          &width);
 	GLHandler::glf().glGetTexLevelParameteriv(glTarget, level,
 	                                          GL_TEXTURE_HEIGHT, &height);
-	GLHandler::glf().glBindTexture(glTarget, 0);
+	GLHandler::bindTexture(glTarget, 0);
 
 	return {width, height};
 }
@@ -204,11 +204,11 @@ QSize GLTexture::getSize(unsigned int level) const
 void GLTexture::generateMipmap() const
 {
 	GLHandler::glf().glHint(GL_GENERATE_MIPMAP_HINT, GL_NICEST);
-	GLHandler::glf().glBindTexture(glTarget, glTexture);
+	GLHandler::bindTexture(glTarget, glTexture);
 	GLHandler::glf().glTexParameteri(glTarget, GL_TEXTURE_MIN_FILTER,
 	                                 GL_LINEAR_MIPMAP_LINEAR);
 	GLHandler::glf().glGenerateMipmap(glTarget);
-	GLHandler::glf().glBindTexture(glTarget, 0);
+	GLHandler::bindTexture(glTarget, 0);
 }
 
 unsigned int GLTexture::getHighestMipmapLevel() const
@@ -223,7 +223,7 @@ QImage GLTexture::getContentAsImage(unsigned int level) const
 	QSize size(getSize(level));
 
 	GLint internalFormat;
-	GLHandler::glf().glBindTexture(glTarget, glTexture);
+	GLHandler::bindTexture(glTarget, glTexture);
 	GLHandler::glf().glGetTexLevelParameteriv(
 	    glTarget, level, GL_TEXTURE_INTERNAL_FORMAT,
 	    &internalFormat);  // get internal format type of GL texture
@@ -265,7 +265,7 @@ unsigned int GLTexture::getContentAsData(GLfloat** buff,
 	QSize size(getSize(level));
 
 	GLint internalFormat;
-	GLHandler::glf().glBindTexture(glTarget, glTexture);
+	GLHandler::bindTexture(glTarget, glTexture);
 	GLHandler::glf().glGetTexLevelParameteriv(
 	    glTarget, level, GL_TEXTURE_INTERNAL_FORMAT,
 	    &internalFormat); // get internal format type of GL texture
@@ -315,7 +315,7 @@ float GLTexture::getAverageLuminance() const
 
 void GLTexture::setSampler(Sampler const& sampler) const
 {
-	GLHandler::glf().glBindTexture(glTarget, glTexture);
+	GLHandler::bindTexture(glTarget, glTexture);
 	GLHandler::glf().glTexParameteri(glTarget, GL_TEXTURE_MIN_FILTER,
 	                                 sampler.filter);
 	GLHandler::glf().glTexParameteri(glTarget, GL_TEXTURE_MAG_FILTER,
@@ -329,12 +329,12 @@ void GLTexture::setSampler(Sampler const& sampler) const
 	/*GLfloat fLargest;
 	glGetFloatv( GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &fLargest );
 	glTexParameterf( format, GL_TEXTURE_MAX_ANISOTROPY_EXT, fLargest );*/
-	GLHandler::glf().glBindTexture(glTarget, 0);
+	GLHandler::bindTexture(glTarget, 0);
 }
 
 void GLTexture::setData(Data const& data) const
 {
-	GLHandler::glf().glBindTexture(glTarget, glTexture);
+	GLHandler::bindTexture(glTarget, glTexture);
 	switch(type)
 	{
 		case Type::TEX1D:
@@ -360,7 +360,7 @@ void GLTexture::setData(Data const& data) const
 			break;
 	}
 	// glGenerateMipmap(format);
-	GLHandler::glf().glBindTexture(glTarget, 0);
+	GLHandler::bindTexture(glTarget, 0);
 }
 
 void GLTexture::setData(DataArray<6> const& data) const
@@ -370,7 +370,7 @@ void GLTexture::setData(DataArray<6> const& data) const
 		qWarning() << "Attempt to set cubemap data on another texture type.";
 		return;
 	}
-	GLHandler::glf().glBindTexture(glTarget, glTexture);
+	GLHandler::bindTexture(glTarget, glTexture);
 	for(unsigned int i(0); i < 6; ++i)
 	{
 		GLHandler::glf().glTexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0,
@@ -378,7 +378,7 @@ void GLTexture::setData(DataArray<6> const& data) const
 		                                 data.type, data.ptrs.at(i));
 	}
 	// glGenerateMipmap(format);
-	GLHandler::glf().glBindTexture(glTarget, 0);
+	GLHandler::bindTexture(glTarget, 0);
 }
 
 void GLTexture::setData(const unsigned char* red, const unsigned char* green,
@@ -399,8 +399,7 @@ void GLTexture::setData(const unsigned char* red, const unsigned char* green,
 
 void GLTexture::use(GLenum textureUnit) const
 {
-	GLHandler::glf().glActiveTexture(textureUnit);
-	GLHandler::glf().glBindTexture(glTarget, glTexture);
+	GLHandler::bindTexture(glTarget, glTexture, textureUnit);
 }
 
 void GLTexture::cleanUp()
@@ -410,13 +409,14 @@ void GLTexture::cleanUp()
 		return;
 	}
 	--instancesCount();
+	GLHandler::forgetTexture(glTexture);
 	GLHandler::glf().glDeleteTextures(1, &glTexture);
 	doClean = false;
 }
 
 void GLTexture::initData(Data const& data) const
 {
-	GLHandler::glf().glBindTexture(glTarget, glTexture);
+	GLHandler::bindTexture(glTarget, glTexture);
 	switch(type)
 	{
 		case Type::TEX1D:
@@ -442,7 +442,7 @@ void GLTexture::initData(Data const& data) const
 			break;
 	}
 	// glGenerateMipmap(format);
-	GLHandler::glf().glBindTexture(glTarget, 0);
+	GLHandler::bindTexture(glTarget, 0);
 }
 
 void GLTexture::initData(DataArray<6> const& data) const
@@ -452,7 +452,7 @@ void GLTexture::initData(DataArray<6> const& data) const
 		qWarning() << "Attempt to set cubemap data on another texture type.";
 		return;
 	}
-	GLHandler::glf().glBindTexture(glTarget, glTexture);
+	GLHandler::bindTexture(glTarget, glTexture);
 	for(unsigned int i(0); i < 6; ++i)
 	{
 		GLHandler::glf().glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0,
@@ -460,7 +460,7 @@ void GLTexture::initData(DataArray<6> const& data) const
 		                              data.format, data.type, data.ptrs.at(i));
 	}
 	// glGenerateMipmap(format);
-	GLHandler::glf().glBindTexture(glTarget, 0);
+	GLHandler::bindTexture(glTarget, 0);
 }
 
 QImage GLTexture::getImage(const char* const& path)
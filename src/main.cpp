@@ -109,17 +109,20 @@ int main(int argc, char* argv[])
 		launcher.init();
 		if(launcher.exec() == QDialog::Rejected)
 		{
+			Logger::close();
 			return EXIT_SUCCESS;
 		}
 	}
+	Logger::readSettings();
 
 	MainWin w;
 	w.setTitle(PROJECT_NAME + QString(" - Loading..."));
 	w.setFullscreen(QSettings().value("window/fullscreen").toBool());
 	// start event loop
 	QCoreApplication::postEvent(&w, new QEvent(QEvent::UpdateRequest));
-	return QApplication::exec();
+	int result(QApplication::exec());
 
-	// close log file
+	// write the queued messages and close log file
 	Logger::close();
+	return result;
 }
@@ -19,7 +19,13 @@
 #include "profiling.hpp"
 
 #include <QApplication>
+#include <QDebug>
+#include <QFile>
 #include <QProcess>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <chrono>
 
 void startProfiling()
 {
@@ -38,3 +44,178 @@ void stopProfiling(bool close)
 		QApplication::quit();
 	}
 }
+
+void CPUProfiler::setEnabled(bool enabled)
+{
+	if(enabled && !isEnabled())
+	{
+		QMutexLocker lock(&buffersMutex());
+		for(auto& buffer : buffers())
+		{
+			QMutexLocker bufferLock(&buffer->mutex);
+			buffer->recorded = 0;
+		}
+	}
+	CPUProfiler::enabled().store(enabled, std::memory_order_relaxed);
+}
+
+// as a JSON string literal
+static QString jsonString(QString const& str)
+{
+	QString result("\"");
+	for(QChar c : str)
+	{
+		if(c == '"' || c == '\\')
+		{
+			result += '\\';
+			result += c;
+		}
+		else if(c.unicode() < 0x20)
+		{
+			result += QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0'));
+		}
+		else
+		{
+			result += c;
+		}
+	}
+	return result + '"';
+}
+
+bool CPUProfiler::dumpChromeTrace(QString const& path)
+{
+	QFile file(path);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+	{
+		qWarning() << "Could not write CPU trace to" << path;
+		return false;
+	}
+	QTextStream stream(&file);
+	stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	bool first(true);
+	auto separate = [&first, &stream]() {
+		stream << (first ? "\n" : ",\n");
+		first = false;
+	};
+
+	QMutexLocker lock(&buffersMutex());
+	for(auto& buffer : buffers())
+	{
+		QMutexLocker bufferLock(&buffer->mutex);
+		separate();
+		stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+		       << buffer->id << ",\"args\":{\"name\":"
+		       << jsonString(buffer->name) << "}}";
+
+		// oldest kept event first
+		quint64 count(std::min<quint64>(buffer->recorded, capacity));
+		for(quint64 i(buffer->recorded - count); i < buffer->recorded; ++i)
+		{
+			Event const& event(buffer->events.at(i % capacity));
+			separate();
+			// timestamps in microseconds
+			stream << "{\"name\":" << jsonString(event.name)
+			       << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id
+			       << ",\"ts\":" << QString::number(event.begin * 1.e-3, 'f', 3)
+			       << ",\"dur\":"
+			       << QString::number((event.end - event.begin) * 1.e-3, 'f', 3)
+			       << '}';
+		}
+	}
+	stream << "\n]}\n";
+	return true;
+}
+
+std::atomic<bool>& CPUProfiler::enabled()
+{
+	static std::atomic<bool> enabled(false);
+	return enabled;
+}
+
+qint64 CPUProfiler::now()
+{
+	// relative to the first call, to keep the trace timestamps short
+	static const auto start(std::chrono::steady_clock::now());
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	           std::chrono::steady_clock::now() - start)
+	    .count();
+}
+
+void CPUProfiler::record(char const* name, qint64 begin, qint64 end)
+{
+	ThreadBuffer& buffer(threadBuffer());
+	QMutexLocker lock(&buffer.mutex);
+	buffer.events.at(buffer.recorded % capacity) = {name, begin, end};
+	++buffer.recorded;
+}
+
+CPUProfiler::ThreadBuffer& CPUProfiler::threadBuffer()
+{
+	static thread_local BufferHandle handle;
+	if(handle.buffer != nullptr)
+	{
+		return *handle.buffer;
+	}
+
+	QMutexLocker lock(&buffersMutex());
+	// reuse the buffer of a thread that ended if any
+	ThreadBuffer* buffer(nullptr);
+	for(auto& candidate : buffers())
+	{
+		if(!candidate->owned)
+		{
+			buffer = candidate.get();
+			break;
+		}
+	}
+	if(buffer == nullptr)
+	{
+		buffers().emplace_back(new ThreadBuffer);
+		buffer = buffers().back().get();
+		buffer->events.resize(capacity);
+	}
+	handle.buffer = buffer;
+
+	static unsigned int threadsCount(0);
+	QMutexLocker bufferLock(&buffer->mutex);
+	buffer->owned    = true;
+	buffer->recorded = 0;
+	buffer->id       = ++threadsCount;
+	QThread* thread(QThread::currentThread());
+	if(QCoreApplication::instance() != nullptr
+	   && thread == QCoreApplication::instance()->thread())
+	{
+		buffer->name = "main";
+	}
+	else if(!thread->objectName().isEmpty())
+	{
+		buffer->name = thread->objectName();
+	}
+	else
+	{
+		buffer->name = "thread " + QString::number(buffer->id);
+	}
+	return *buffer;
+}
+
+CPUProfiler::BufferHandle::~BufferHandle()
+{
+	if(buffer != nullptr)
+	{
+		QMutexLocker lock(&buffersMutex());
+		buffer->owned = false;
+	}
+}
+
+std::vector<std::unique_ptr<CPUProfiler::ThreadBuffer>>& CPUProfiler::buffers()
+{
+	static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+	return buffers;
+}
+
+QMutex& CPUProfiler::buffersMutex()
+{
+	static QMutex buffersMutex;
+	return buffersMutex;
+}
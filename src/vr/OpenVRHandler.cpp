@@ -289,7 +289,7 @@ void OpenVRHandler::renderHiddenAreaMesh(Side eye)
 	GLShaderProgram s("hiddenarea");
 
 	GLHandler::glf().glClearStencil(0x0);
-	GLHandler::glf().glEnable(GL_STENCIL_TEST);
+	GLHandler::setEnabled(GL_STENCIL_TEST, true);
 	GLHandler::glf().glStencilMask(0xFF);
 	GLHandler::glf().glStencilFunc(GL_ALWAYS, 1, 0xFF);
 	GLHandler::glf().glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
@@ -345,6 +345,8 @@ void OpenVRHandler::submitRendering(GLFramebufferObject const& fbo)
 	       vr::TextureType_OpenGL, vr::ColorSpace_Gamma};
 	vr::EVRCompositorError error
 	    = vr_compositor->Submit(getEye(currentRenderingEye), &texture);
+	// the compositor may change the OpenGL state
+	GLHandler::invalidateState();
 	if(error != vr::VRCompositorError_None)
 	{
 		qCritical() << QString("ERROR in submit: ") + error;
@@ -415,7 +417,7 @@ void OpenVRHandler::close()
 	{
 		return;
 	}
-	GLHandler::glf().glDisable(GL_STENCIL_TEST);
+	GLHandler::setEnabled(GL_STENCIL_TEST, false);
 	updateController(Side::LEFT, -1);
 	updateController(Side::RIGHT, -1);
 	delete leftHand;
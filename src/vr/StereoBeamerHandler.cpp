@@ -90,9 +90,8 @@ QMatrix4x4 StereoBeamerHandler::getProjectionMatrix(Side /*eye*/,
                                                     float nearPlan,
                                                     float farPlan) const
 {
-	QVector3D deltaRel(QSettings()
-	                       .value("vr/virtualcamshift")
-	                       .value<QVector3D>()); // move cam in height units
+	static const Setting<QVector3D> virtualCamShift("vr/virtualcamshift");
+	QVector3D deltaRel(virtualCamShift.get()); // move cam in height units
 	float vFOV(renderer->getVerticalFOV() * 3.1415 / 180.0),
 	    a(renderer->getAspectRatioFromFOV());
 	float l(-nearPlan * a * tan(vFOV / 2.0)), t(nearPlan * tan(vFOV / 2.0));
@@ -0,0 +1,283 @@
+/*
+    Copyright (C) 2020 Florian Cabot <florian.cabot@hotmail.fr>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef TESTFRAMESINK_H
+#define TESTFRAMESINK_H
+
+#include <QSemaphore>
+#include <QStringList>
+#include <QtTest>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#include "FrameSink.hpp"
+
+class TestFrameSink : public QObject
+{
+	Q_OBJECT
+  private slots:
+	void qoiRoundTrip()
+	{
+		// exercises every QOI operation : long runs, small and large color
+		// differences, repeated colors and alpha changes
+		QImage image(97, 13, QImage::Format_RGBA8888);
+		quint32 random(12345);
+		for(int y(0); y < image.height(); ++y)
+		{
+			uchar* line(image.scanLine(y));
+			for(int x(0); x < image.width(); ++x)
+			{
+				random       = random * 1103515245u + 12345u;
+				uchar* pixel = line + 4 * x;
+				if(y < 2)
+				{
+					std::memset(pixel, 200, 4);
+				}
+				else if(y < 5)
+				{
+					pixel[0] = x;
+					pixel[1] = x + (x % 3);
+					pixel[2] = x * 2;
+					pixel[3] = 255;
+				}
+				else if(y < 8)
+				{
+					uchar const palette[][4] = {{10, 20, 30, 255},
+					                            {250, 0, 120, 255},
+					                            {0, 0, 0, 0}};
+					std::memcpy(pixel, palette[(random >> 16) % 3], 4);
+				}
+				else
+				{
+					for(unsigned int i(0); i < 4; ++i)
+					{
+						pixel[i] = random >> (8 * i);
+					}
+				}
+			}
+		}
+
+		QByteArray encoded(ImageSequenceSink::encodeQOI(image));
+		QImage decoded(decodeQOI(encoded));
+		QCOMPARE(decoded, image);
+
+		// a flat image is mostly runs of 62 pixels
+		QImage flat(64, 64, QImage::Format_RGBA8888);
+		flat.fill(Qt::red);
+		encoded = ImageSequenceSink::encodeQOI(flat);
+		QVERIFY(encoded.size() < 128);
+		QCOMPARE(decodeQOI(encoded), flat);
+	}
+
+	void y4mFrame()
+	{
+		QImage image(3, 2, QImage::Format_RGBA8888);
+		image.setPixelColor(0, 0, Qt::black);
+		image.setPixelColor(1, 0, Qt::white);
+		image.setPixelColor(2, 0, Qt::red);
+		image.setPixelColor(0, 1, Qt::green);
+		image.setPixelColor(1, 1, Qt::blue);
+		image.setPixelColor(2, 1, QColor(128, 128, 128));
+
+		QByteArray frame;
+		PipeSink::encodeY4MFrame(image, frame);
+		QCOMPARE(frame.size(), 6 + 3 * 6);
+		QVERIFY(frame.startsWith("FRAME\n"));
+
+		// BT.709 limited range
+		auto plane = [&frame](unsigned int i) {
+			std::vector<int> result;
+			for(unsigned int j(0); j < 6; ++j)
+			{
+				result.push_back(static_cast<uchar>(frame[6 + 6 * i + j]));
+			}
+			return result;
+		};
+		QCOMPARE(plane(0), std::vector<int>({16, 235, 63, 173, 32, 126}));
+		QCOMPARE(plane(1), std::vector<int>({128, 128, 102, 42, 240, 128}));
+		QCOMPARE(plane(2), std::vector<int>({128, 128, 240, 26, 118, 128}));
+
+		// the buffer is reused as is for same sized frames
+		char const* data(frame.constData());
+		PipeSink::encodeY4MFrame(image, frame);
+		QCOMPARE(frame.constData(), data);
+	}
+
+	void dropWhenFull()
+	{
+		BlockingSink sink(2, true);
+		QVERIFY(sink.push({}, "0"));
+		// the consumer holds frame 0, the queue is empty
+		sink.entered.acquire();
+
+		QVERIFY(sink.push({}, "1"));
+		QVERIFY(sink.push({}, "2"));
+		QVERIFY(!sink.push({}, "3"));
+		QCOMPARE(sink.getStats().dropped, 1u);
+
+		sink.gate.release(3);
+		sink.close();
+		QVERIFY(!sink.push({}, "4"));
+		QCOMPARE(sink.written, QStringList({"0", "1", "2"}));
+		QCOMPARE(sink.getStats().written, 3u);
+		QCOMPARE(sink.getStats().dropped, 2u);
+	}
+
+	void waitWhenFull()
+	{
+		BlockingSink sink(1, false);
+		QVERIFY(sink.push({}, "0"));
+		sink.entered.acquire();
+		QVERIFY(sink.push({}, "1"));
+
+		std::atomic<bool> pushed(false);
+		std::thread producer([&sink, &pushed]() {
+			sink.push({}, "2");
+			pushed = true;
+		});
+		QThread::msleep(50);
+		bool waited(!pushed);
+
+		// frame 0 written, frame 1 dequeued : frame 2 fits
+		sink.gate.release();
+		producer.join();
+		QVERIFY(waited);
+		QVERIFY(pushed);
+
+		sink.gate.release(2);
+		sink.close();
+		QCOMPARE(sink.written, QStringList({"0", "1", "2"}));
+		QCOMPARE(sink.getStats().written, 3u);
+		QCOMPARE(sink.getStats().dropped, 0u);
+	}
+
+  private:
+	// consumer blocks in write() until the test lets it through
+	class BlockingSink : public FrameSink
+	{
+	  public:
+		BlockingSink(unsigned int queueSize, bool dropWhenFull)
+		    : FrameSink(queueSize, dropWhenFull)
+		{
+			start(1);
+		};
+		~BlockingSink()
+		{
+			gate.release(1000);
+			close();
+		};
+
+		QSemaphore entered;
+		QSemaphore gate;
+		QStringList written;
+
+	  protected:
+		qint64 write(QImage const& /*frame*/, QString const& name) override
+		{
+			entered.release();
+			gate.acquire();
+			written << name;
+			return 1;
+		};
+	};
+
+	static QImage decodeQOI(QByteArray const& data)
+	{
+		auto in(reinterpret_cast<uchar const*>(data.constData()));
+		auto get32 = [&in]() {
+			quint32 value(0);
+			for(unsigned int i(0); i < 4; ++i)
+			{
+				value = value << 8 | *in++;
+			}
+			return value;
+		};
+		if(data.size() < 22 || std::memcmp(in, "qoif", 4) != 0)
+		{
+			return {};
+		}
+		in += 4;
+		quint32 width(get32()), height(get32());
+		in += 2; // channels and colorspace
+
+		QImage result(width, height, QImage::Format_RGBA8888);
+		std::array<std::array<uchar, 4>, 64> index = {};
+		std::array<uchar, 4> pixel = {{0, 0, 0, 255}};
+		unsigned int run(0);
+		for(quint32 y(0); y < height; ++y)
+		{
+			uchar* line(result.scanLine(y));
+			for(quint32 x(0); x < width; ++x)
+			{
+				if(run > 0)
+				{
+					--run;
+				}
+				else if(*in == 0xfe || *in == 0xff)
+				{
+					unsigned int channels(*in++ == 0xff ? 4 : 3);
+					std::memcpy(&pixel[0], in, channels);
+					in += channels;
+				}
+				else
+				{
+					uchar op(*in++);
+					switch(op >> 6)
+					{
+						case 0:
+							pixel = index.at(op);
+							break;
+						case 1:
+							pixel[0] += ((op >> 4) & 3) - 2;
+							pixel[1] += ((op >> 2) & 3) - 2;
+							pixel[2] += (op & 3) - 2;
+							break;
+						case 2:
+						{
+							int dg((op & 0x3f) - 32);
+							uchar drgdbg(*in++);
+							pixel[0] += dg + (drgdbg >> 4) - 8;
+							pixel[1] += dg;
+							pixel[2] += dg + (drgdbg & 0xf) - 8;
+							break;
+						}
+						default:
+							run = op & 0x3f;
+							break;
+					}
+				}
+				index.at((pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7
+				          + pixel[3] * 11)
+				         % 64)
+				    = pixel;
+				std::memcpy(line + 4 * x, &pixel[0], 4);
+			}
+		}
+		if(reinterpret_cast<char const*>(in) + 8
+		       != data.constData() + data.size()
+		   || std::memcmp(in, "\0\0\0\0\0\0\0\1", 8) != 0)
+		{
+			return {};
+		}
+		return result;
+	}
+};
+
+#endif // TESTFRAMESINK_H
@@ -1,5 +1,6 @@
 #include <QtTest>
 
+#include "TestFrameSink.hpp"
 #include "test_main.hpp"
 
 int main(int argc, char** argv)
@@ -10,6 +11,7 @@ int main(int argc, char** argv)
         delete obj;
 	};
 
+	ASSERT_TEST(new TestFrameSink());
 	test_main(ASSERT_TEST);
 
 	return status;
@@ -24,6 +24,9 @@ out gl_PerVertex
 
 const float oneOverLog10 = 0.4342944819;
 
+#include <camera.glsl>
+#include <projection.glsl>
+
 float log10(in float x)
 {
 	return log(x) * oneOverLog10;
@@ -35,8 +38,11 @@ float max3(vec3 v)
 
 void main()
 {
-	vec4 pos    = camera * vec4(position, 1.0);
-	gl_Position = pos;
+	vec4 viewpos = camera * vec4(position, 1.0);
+	vec4 pos     = projectDirect(viewpos);
+	gl_Position  = pos;
+	// of the pixel the point is drawn on
+	float solidAngle = projectedPixelSolidAngle(viewpos, pixelSolidAngle);
 	gl_ClipDistance[0]
 	    = (pos.z / pos.w) - 0.1; // clip galaxies too close to face in VR
 	f_dist = length(position);   // dist to earth in unit
@@ -70,18 +76,18 @@ void main()
 	// solve 2.54E-6 = pow(10.0, 0.4*b) => b ~= -14.0
 	float illuminance = pow(10.0, 0.4 * (-apparentmag - 14.0));
 	// lux/sr
-	float luminance = brightnessMultiplier * illuminance / pixelSolidAngle;
+	float luminance = brightnessMultiplier * illuminance / solidAngle;
 
 	vec3 col = color * luminance;
 
 	float m     = apparentSize * apparentSize;
-	f_pointsize = apparentSize * 0.5 / sqrt(pixelSolidAngle);
+	f_pointsize = apparentSize * 0.5 / sqrt(solidAngle);
 	if(f_pointsize > 1.0)
 	{
 		col /= m;
 		gl_PointSize = apparentSize * 5.0
-		               / sqrt(pixelSolidAngle); // 5.0 = empirical and depends
-		                                        // on texture content
+		               / sqrt(solidAngle); // 5.0 = empirical and depends
+		                                   // on texture content
 		f_finalcolor = vec4(col, brightnessMultiplier * illuminance / m);
 
 		int id = gl_VertexID;
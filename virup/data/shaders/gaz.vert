@@ -4,16 +4,34 @@ in vec3 position;
 in float radius;
 in float luminosity;
 
+#ifdef MULTIDRAW
+// per node parameters, see OctreeLODBatch
+in uint nodeid;
+uniform samplerBuffer nodeparams;
+#else
 uniform mat4 camera;
 uniform float alpha;
+#endif
 uniform mat4 view;
 uniform float scale;
 
 out float fragAlpha;
 
+#include <camera.glsl>
+#include <projection.glsl>
+
 void main()
 {
-	gl_Position = camera * vec4(position, 1.0);
+#ifdef MULTIDRAW
+	int texel   = 9 * int(nodeid);
+	mat4 camera = mat4(texelFetch(nodeparams, texel),
+	                   texelFetch(nodeparams, texel + 1),
+	                   texelFetch(nodeparams, texel + 2),
+	                   texelFetch(nodeparams, texel + 3));
+	float alpha = texelFetch(nodeparams, texel + 8).w;
+#endif
+
+	gl_Position = projectDirect(camera * vec4(position, 1.0));
 
 	float camdist = length(vec3(view * vec4(position, 1.0)));
 	fragAlpha     = min(10.0, luminosity * alpha / (radius * radius * camdist * camdist));
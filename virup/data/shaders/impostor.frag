@@ -0,0 +1,12 @@
+#version 150 core
+
+uniform samplerCube tex;
+
+in vec3 f_texcoord;
+
+out vec4 outColor;
+
+void main()
+{
+	outColor = vec4(texture(tex, f_texcoord).rgb, 1.0);
+}
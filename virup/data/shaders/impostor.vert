@@ -0,0 +1,21 @@
+#version 150 core
+
+in vec3 position;
+
+#include <camera.glsl>
+
+out vec3 f_texcoord;
+
+out gl_PerVertex
+{
+	vec4 gl_Position;
+	float gl_ClipDistance[1];
+};
+
+void main()
+{
+	// on the far plane, behind everything else (needs GL_LEQUAL depth test)
+	gl_Position        = (fullSkyboxSpaceTransform * vec4(position, 1.0)).xyww;
+	gl_ClipDistance[0] = 1.0;
+	f_texcoord         = position;
+}
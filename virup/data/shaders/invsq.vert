@@ -3,14 +3,25 @@
 in vec3 position;
 in vec3 color; // in solar luminosity !
 
+#ifdef MULTIDRAW
+// per node parameters, see OctreeLODBatch
+in uint nodeid;
+uniform samplerBuffer nodeparams;
+#else
 uniform mat4 camera;
 uniform float alpha;
 uniform vec3 campos;
+uniform mat4 dusttransform;
+#endif
 uniform float pixelSolidAngle;
 
-uniform mat4 dusttransform;
 uniform float useDust = 0.0;
 
+// see OctreeLOD::Shell, shelloffset is the shell center minus campos
+uniform vec3 shelloffset;
+uniform float shellradius = 0.0;
+uniform float shellside   = 0.0;
+
 uniform sampler3D dusttex;
 
 out vec3 f_color;
@@ -20,7 +31,7 @@ const float oneOverLog10 = 0.4342944819;
 out gl_PerVertex
 {
 	vec4 gl_Position;
-	float gl_ClipDistance[1];
+	float gl_ClipDistance[2];
 };
 
 float log10(in float x)
@@ -33,20 +44,41 @@ vec3 log10_3(in vec3 x)
 	return log(x) * oneOverLog10;
 }
 
+#include <camera.glsl>
+#include <projection.glsl>
 #include <raymarch.glsl>
 
 void main()
 {
-	vec4 pos           = camera * vec4(position, 1.0);
+#ifdef MULTIDRAW
+	int texel          = 9 * int(nodeid);
+	mat4 camera        = mat4(texelFetch(nodeparams, texel),
+	                          texelFetch(nodeparams, texel + 1),
+	                          texelFetch(nodeparams, texel + 2),
+	                          texelFetch(nodeparams, texel + 3));
+	mat4 dusttransform = mat4(texelFetch(nodeparams, texel + 4),
+	                          texelFetch(nodeparams, texel + 5),
+	                          texelFetch(nodeparams, texel + 6),
+	                          texelFetch(nodeparams, texel + 7));
+	vec4 camposalpha   = texelFetch(nodeparams, texel + 8);
+	vec3 campos        = camposalpha.xyz;
+	float alpha        = camposalpha.w;
+#endif
+
+	vec4 viewpos       = camera * vec4(position, 1.0);
+	vec4 pos           = projectDirect(viewpos);
 	gl_Position        = pos;
 	gl_ClipDistance[0] = (pos.z / pos.w) - 0.1;
+	gl_ClipDistance[1]
+	    = shellside * (distance(position, campos + shelloffset) - shellradius);
 
 	float camdist = length(position - campos);
 	vec3 absmag = 4.83 - 2.5 * log10_3(max(vec3(1.0e-30),color) ); // color is in Solar Luminosity ;
 	                                           // sun is 4.83 abs mag
 	vec3 apparentmag = absmag + 5.0 * (log10(camdist) + 2.0);
 	vec3 irradiance  = pow(vec3(10.0), 0.4 * (-apparentmag - 14.0));
-	vec3 luminance   = irradiance / pixelSolidAngle; // lum
+	vec3 luminance   = irradiance
+	                 / projectedPixelSolidAngle(viewpos, pixelSolidAngle);
 
 	vec3 a = vec3(1.0);
 	if(useDust == 1.0)
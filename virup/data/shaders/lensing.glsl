@@ -1,11 +1,5 @@
-#version 420 core
-#extension GL_ARB_compute_shader : enable
-
-layout (local_size_x = LOCAL_SIZE_2D_X, local_size_y = LOCAL_SIZE_2D_Y) in;
-
-// An image to store data into.
-layout (rgba32f, binding = 0) readonly uniform image2D dataIn;
-layout (rgba32f, binding = 1) writeonly uniform image2D dataOut;
+// Renderer post-processing function, see
+// Renderer::PostProcessingFootprint::NEIGHBORHOOD
 
 const float PI = 3.1415926535;
 
@@ -25,9 +19,8 @@ vec2 Distort(vec2 p)
 	return vec2(x, y) * 2.0 - 1.0;
 }
 
-void main()
+vec4 postprocess(vec4 color, ivec2 pixel_coords)
 {
-	ivec2 pixel_coords = ivec2(gl_GlobalInvocationID.xy);
 	vec2 globalSize = vec2(gl_NumWorkGroups.xy * gl_WorkGroupSize.xy);
 	vec2 texCoord = vec2(gl_GlobalInvocationID.xy) / globalSize;
 	vec2 center = lenseScreenCoord.xy * 0.5 + vec2(0.5);
@@ -39,8 +32,7 @@ void main()
 	float d = length(xy);
 	if(d <= 0.025)
 	{
-		imageStore(dataOut, pixel_coords, vec4(vec3(0.0), 1.0));
-		return;
+		return vec4(vec3(0.0), 1.0);
 	}
 	if(xy.x > -1 && xy.x < 1 && xy.y > -1 && xy.y < 1
 	   && lenseScreenCoord.z > -1.0 && lenseScreenCoord.z < 1.0)
@@ -75,5 +67,5 @@ void main()
 	result += res10 * fetch_fract.x * (1.0 - fetch_fract.y);
 	result += res11 * fetch_fract.x * fetch_fract.y;
 
-	imageStore(dataOut, pixel_coords, result);
+	return result;
 }
@@ -23,6 +23,9 @@ out gl_PerVertex
 
 const float oneOverLog10 = 0.4342944819;
 
+#include <camera.glsl>
+#include <projection.glsl>
+
 float log10(in float x)
 {
 	return log(x) * oneOverLog10;
@@ -34,8 +37,11 @@ float max3(vec3 v)
 
 void main()
 {
-	vec4 pos    = camera * vec4(position, 1.0);
-	gl_Position = pos;
+	vec4 viewpos = camera * vec4(position, 1.0);
+	vec4 pos     = projectDirect(viewpos);
+	gl_Position  = pos;
+	// of the pixel the point is drawn on
+	float solidAngle = projectedPixelSolidAngle(viewpos, pixelSolidAngle);
 	gl_ClipDistance[0]
 	    = (pos.z / pos.w) - 0.1; // clip galaxies too close to face in VR
 
@@ -51,7 +57,7 @@ void main()
 	// solve 2.54E-6 = pow(10.0, 0.4*b) => b ~= -14.0
 	float illuminance = pow(10.0, 0.4 * (-apparentmag - 14.0));
 	// lux/sr
-	float luminance = brightnessMultiplier * illuminance / pixelSolidAngle;
+	float luminance = brightnessMultiplier * illuminance / solidAngle;
 
 	vec3 col = color * luminance;
 
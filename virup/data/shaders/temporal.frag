@@ -0,0 +1,17 @@
+#version 150 core
+
+uniform sampler2D tex;
+
+// current clip space to the image's clip space, rotation only
+uniform mat4 reprojection;
+
+out vec4 outColor;
+
+void main()
+{
+	// same reprojection as temporal.comp
+	vec2 ndc  = 2.0 * gl_FragCoord.xy / vec2(textureSize(tex, 0)) - 1.0;
+	vec4 prev = reprojection * vec4(ndc, 1.0, 1.0);
+	vec2 uv   = clamp(0.5 * prev.xy / prev.w + 0.5, 0.0, 1.0);
+	outColor  = vec4(texture(tex, uv).rgb, 1.0);
+}
@@ -0,0 +1,16 @@
+#version 150 core
+
+in vec2 position;
+
+out gl_PerVertex
+{
+	vec4 gl_Position;
+	float gl_ClipDistance[1];
+};
+
+void main()
+{
+	// on the far plane, behind everything else (needs GL_LEQUAL depth test)
+	gl_Position        = vec4(position, 1.0, 1.0);
+	gl_ClipDistance[0] = 1.0;
+}
@@ -63,8 +63,13 @@ class CSVObjects : public UniverseElement
 	CSVObjects(QString const& csvFile, bool galaxies = false);
 	CSVObjects(QString const& csvFile, QString const& constellationsFile);
 	virtual BBox getBoundingBox() const override;
+	// only the points, see renderConstellations()
 	virtual void render(Camera const& camera,
 	                    ToneMappingModel const* tmm) override;
+	// constellations lines and labels if any, which can't be projected
+	// directly (see Renderer::RenderPath::directProjection)
+	void renderConstellations(Camera const& camera,
+	                          ToneMappingModel const* tmm);
 	virtual ~CSVObjects();
 
 	float colormix = 0.0f;
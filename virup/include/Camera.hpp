@@ -87,6 +87,11 @@ class Camera : public BasicCamera
 	void updateTargetFPS();
 	bool shouldBeCulled(BBox const& bbox, QMatrix4x4 const& model,
 	                    bool depthClamp = false) const;
+	// LEFT, RIGHT, BOTTOM, TOP, NEAR, FAR ; normals point inside
+	QVector4D getClippingPlane(unsigned int i) const
+	{
+		return clippingPlanes.at(i);
+	};
 
 	Vector3 position = Vector3(0.0, 0.0, 0.0);
 	double scale     = 1.0;
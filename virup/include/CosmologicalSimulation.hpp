@@ -20,21 +20,32 @@
 #define COSMOLOGICALSIMULATION_HPP
 
 #include "UniverseElement.hpp"
+#include "methods/FarFieldImpostor.hpp"
+#include "methods/TemporalAccumulation.hpp"
+#include "methods/TreeMethodGPU.hpp"
 #include "methods/TreeMethodLOD.hpp"
 
 class CosmologicalSimulation : public UniverseElement
 {
   public:
-	CosmologicalSimulation(std::string const& gazOctreePath,
+	CosmologicalSimulation(VRHandler const& vrHandler,
+	                       std::string const& gazOctreePath,
 	                       std::string const& starsOctreePath,
 	                       std::string const& darkMatterOctreePath);
 	virtual BBox getBoundingBox() const override;
 	virtual void render(Camera const& camera,
 	                    ToneMappingModel const* tmm) override;
-	~CosmologicalSimulation() = default;
+	~CosmologicalSimulation();
 
   public:
-	TreeMethodLOD trees;
+	// TreeMethodGPU if graphics/gpuculling is set
+	TreeMethodLOD* trees;
+
+  private:
+	// only if graphics/impostors is set
+	FarFieldImpostor* impostor = nullptr;
+	// only if graphics/temporalslices is greater than 1
+	TemporalAccumulation* temporal = nullptr;
 };
 
 #endif // COSMOLOGICALSIMULATION_HPP
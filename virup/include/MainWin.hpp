@@ -291,14 +291,14 @@ class MainWin : public AbstractMainWin
 	 */
 	bool darkmatterEnabled() const
 	{
-		return cosmologicalSim->trees.isDarkMatterEnabled();
+		return cosmologicalSim->trees->isDarkMatterEnabled();
 	};
 	/**
 	 * @setter{darkmatterEnabled, darkmatterEnabled}
 	 */
 	void setDarkmatterEnabled(bool enabled)
 	{
-		cosmologicalSim->trees.setDarkMatterEnabled(enabled);
+		cosmologicalSim->trees->setDarkMatterEnabled(enabled);
 	};
 	/**
 	 * @getter{gridEnabled}
@@ -382,6 +382,9 @@ class MainWin : public AbstractMainWin
 	virtual void updateScene(BasicCamera& camera,
 	                         QString const& pathId) override;
 
+	// no octree node the trees asked for is still loading
+	virtual bool isSceneSettled() override;
+
 	// render user scene on camera
 	// (no controllers or hands)
 	virtual void renderScene(BasicCamera const& camera,
@@ -0,0 +1,81 @@
+#ifndef FARFIELDIMPOSTOR_H
+#define FARFIELDIMPOSTOR_H
+
+#include <memory>
+
+#include "Primitives.hpp"
+#include "gl/GLHandler.hpp"
+
+#include "TreeMethodLOD.hpp"
+
+/**
+ * @brief Caches the distant content of a TreeMethodLOD in a cubemap.
+ *
+ * Points farther than a shell radius from a capture position are rendered
+ * into an HDR cubemap (see GLHandler::generateEnvironmentMapFace), which is
+ * drawn behind everything else; only the points within the shell are drawn
+ * every frame.
+ *
+ * Seen from a camera at distance d from the capture position, the content
+ * beyond radius R moves by at most d / R radians. When this exceeds half of
+ * the allowed parallax error (graphics/impostorparallax, in pixels), a new
+ * cubemap is captured around the current camera position, one face per
+ * frame, while the previous one is still displayed. Both are swapped once all
+ * faces are rendered.
+ */
+class FarFieldImpostor
+{
+  public:
+	explicit FarFieldImpostor(VRHandler const& vrHandler);
+	FarFieldImpostor(FarFieldImpostor const& other) = delete;
+	FarFieldImpostor& operator=(FarFieldImpostor const& other) = delete;
+	/**
+	 * @brief Renders the next cubemap face if needed and draws the current
+	 * cubemap.
+	 *
+	 * Sets @p trees shell so that its next renderings only draw the near
+	 * field (or everything if no cubemap is ready yet).
+	 *
+	 * @attention Must be called within the cosmological rendering state
+	 * (GL_LEQUAL depth test, depth clamp and GL_CLIP_DISTANCE0 enabled).
+	 */
+	void render(Camera const& camera, QMatrix4x4 const& relToAbsTransform,
+	            TreeMethodLOD& trees);
+
+  private:
+	struct Capture
+	{
+		std::unique_ptr<GLFramebufferObject> target;
+		// camera true position
+		Vector3 position;
+		// in trees data space
+		OctreeLOD::Shell shell;
+		float alpha     = 0.f;
+		bool darkMatter = false;
+		// rendered faces count
+		unsigned int faces = 0;
+
+		bool complete() const { return faces == 6; };
+	};
+
+	Capture front;
+	Capture back;
+	bool capturing = false;
+
+	Camera captureCamera;
+	GLShaderProgram shader;
+	GLMesh cube;
+
+	// in meters
+	float shellRadius;
+	// in pixels
+	float maxParallax;
+
+	static bool matches(Capture const& capture, TreeMethodLOD const& trees);
+	void startCapture(Camera const& camera, QMatrix4x4 const& model,
+	                  QVector3D const& campos, TreeMethodLOD const& trees);
+	void renderFace(Camera const& camera, QMatrix4x4 const& relToAbsTransform,
+	                TreeMethodLOD& trees);
+};
+
+#endif // FARFIELDIMPOSTOR_H
@@ -15,7 +15,8 @@ class Method : public QObject
   public:
 	Method(std::string const& shadersCommonName);
 	Method(std::string const& vertexShaderPath,
-	       std::string const& fragmentShaderPath);
+	       std::string const& fragmentShaderPath,
+	       QMap<QString, QString> const& defines = {});
 	virtual BBox getDataBoundingBox() const   = 0;
 	virtual void render(Camera const& camera) = 0;
 	virtual ~Method()                         = default;
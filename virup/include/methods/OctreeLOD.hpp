@@ -3,6 +3,7 @@
 
 #include <QElapsedTimer>
 #include <liboctree/Octree.hpp>
+#include <memory>
 #include <random>
 
 #include "graphics/renderers/OrbitalSystemRenderer.hpp"
@@ -14,11 +15,34 @@
 #include "physics/blackbody.hpp"
 #include "utils.hpp"
 
+#include "OctreeLODBatch.hpp"
+
 #define MAX_LEAVES_PER_NODE 16000
 
 class OctreeLOD : public Octree
 {
   public:
+	/**
+	 * @brief Restricts rendering to the inside (side < 0) or the outside (side
+	 * > 0) of a sphere in data space, see FarFieldImpostor.
+	 *
+	 * Traversals skip the nodes entirely on the other side; points are then
+	 * clipped individually by invsq.vert.
+	 */
+	struct Shell
+	{
+		QVector3D center;
+		float radius = 0.f;
+		int side     = 0;
+
+		bool excludes(BBox const& bbox) const
+		{
+			float dist(center.distanceToPoint(bbox.mid));
+			return (side > 0 && dist + bbox.diameter / 2.f < radius)
+			       || (side < 0 && dist - bbox.diameter / 2.f > radius);
+		};
+	};
+
 	OctreeLOD(GLShaderProgram const& shaderProgram);
 	virtual void init(std::vector<float>& data) override;
 	virtual void init(std::istream& in) override;
@@ -31,12 +55,36 @@ class OctreeLOD : public Octree
 	void setFile(std::istream* file);
 	std::istream* getFile() { return file; };
 	bool preloadLevel(unsigned int lvlToLoad);
+	// renders the whole selected nodes list in one draw call
 	unsigned int renderAboveTanAngle(float tanAngle, Camera const& camera,
 	                                 QMatrix4x4 const& globalModel,
 	                                 QVector3D const& globalCampos,
 	                                 unsigned int maxPoints, bool isStarField,
 	                                 float alpha,
-	                                 QMatrix4x4 const& globalDustModel);
+	                                 QMatrix4x4 const& globalDustModel,
+	                                 Shell const& shell = Shell());
+	/**
+	 * @brief Updates the precision enhancement of the leaf containing
+	 * @p globalCampos (if any) and returns it.
+	 *
+	 * Used by traversals that don't visit leaves on CPU side (see
+	 * TreeMethodGPU).
+	 */
+	OctreeLOD* updateCameraLeaf(Camera const& camera,
+	                            QVector3D const& globalCampos,
+	                            bool isStarField);
+	// centers a leaf's vertices on the point closest to the camera if the
+	// camera is within the leaf, resets it otherwise
+	void updatePrecision(Camera const& camera, QVector3D const& globalCampos,
+	                     bool isStarField);
+	// loads own data in video memory if not already loaded
+	void load();
+	bool isResident() const { return isLoaded; };
+	unsigned int getDataSize() const { return dataSize; };
+	OctreeLODBatch& getBatch() { return *batch; };
+	OctreeLODBatch::Block getBlock() const { return block; };
+	Vector3 getLocalTranslation() const { return localTranslation; };
+	std::vector<OctreeLOD*> getChildrenNodes() const;
 	~OctreeLOD();
 
 	static int64_t getUsedMem() { return usedMem(); };
@@ -48,6 +96,7 @@ class OctreeLOD : public Octree
 
   protected:
 	OctreeLOD(GLShaderProgram const& shaderProgram,
+	          std::shared_ptr<OctreeLODBatch> const& batch,
 	          Octree::CommonData& commonData, unsigned int lvl = 0);
 	virtual Octree* newChild() const override;
 
@@ -62,9 +111,18 @@ class OctreeLOD : public Octree
 	static int64_t& usedMem();
 	static const int64_t& memLimit();
 
-	GLMesh* mesh = nullptr;
+	// shared by all the nodes of the tree
+	std::shared_ptr<OctreeLODBatch> batch;
+	OctreeLODBatch::Block block;
 	GLShaderProgram const* shaderProgram;
 
+	unsigned int collectAboveTanAngle(float tanAngle, Camera const& camera,
+	                                  QMatrix4x4 const& globalModel,
+	                                  QVector3D const& globalCampos,
+	                                  unsigned int maxPoints, bool isStarField,
+	                                  float alpha,
+	                                  QMatrix4x4 const& globalDustModel,
+	                                  Shell const& shell);
 	void computeBBox();
 	float currentTanAngle(QVector3D const& campos) const;
 	void ramToVideo();
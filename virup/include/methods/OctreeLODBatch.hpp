@@ -0,0 +1,131 @@
+#ifndef OCTREELODBATCH_H
+#define OCTREELODBATCH_H
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <vector>
+
+#include "gl/GLHandler.hpp"
+
+/**
+ * @brief Shared vertex storage and draw list of all the nodes of an octree.
+ *
+ * Every node's vertices are stored in the same vertex buffer, so that all the
+ * nodes selected by a traversal can be rendered by one
+ * glMultiDrawArraysIndirect call.
+ *
+ * Per-node parameters (camera matrix, dust transform, camera position and
+ * alpha) are stored in a buffer texture. Each draw command has one instance
+ * whose base instance is the node index within the draw list; a per-instance
+ * attribute named "nodeid" then gives this index to the vertex shader, which
+ * fetches its parameters from the "nodeparams" samplerBuffer (see invsq.vert
+ * with MULTIDRAW defined).
+ */
+class OctreeLODBatch
+{
+  public:
+	// number of RGBA32F texels of one node's parameters
+	static const unsigned int paramsTexelsPerNode = 9;
+
+	/**
+	 * @brief A range of vertices within the shared vertex buffer.
+	 */
+	struct Block
+	{
+		size_t first = 0;
+		size_t count = 0;
+	};
+
+	OctreeLODBatch(GLShaderProgram const& shaderProgram);
+	OctreeLODBatch(OctreeLODBatch const& other) = delete;
+	OctreeLODBatch& operator=(OctreeLODBatch const& other) = delete;
+	/**
+	 * @brief Sets the vertex attributes layout, as for
+	 * GLMesh::setVertexShaderMapping.
+	 *
+	 * Does nothing if the mapping is the same as the current one.
+	 */
+	void setVertexShaderMapping(
+	    std::vector<QPair<const char*, unsigned int>> const& mapping);
+	// trailing floats that don't make a whole vertex are ignored
+	Block allocate(std::vector<float> const& vertices);
+	// vertices must contain block.count vertices
+	void setVertices(Block const& block, std::vector<float> const& vertices);
+	void free(Block const& block);
+
+	// clears the draw list
+	void clear();
+	/**
+	 * @brief Makes the next addDraw() calls only draw the @p index th of @p
+	 * count contiguous slices of each block, with alpha multiplied by @p
+	 * count (see TemporalAccumulation).
+	 *
+	 * Over @p count frames, every slice is drawn once and the accumulated
+	 * luminance is the same as drawing whole blocks.
+	 */
+	void setSlice(unsigned int index, unsigned int count);
+	void addDraw(Block const& block, QMatrix4x4 const& camera,
+	             QMatrix4x4 const& dustTransform, QVector3D const& campos,
+	             float alpha);
+	/**
+	 * @brief Renders the draw list with one glMultiDrawArraysIndirect call.
+	 *
+	 * @attention Make sure the shader program is used and its other uniforms
+	 * are set before calling this method.
+	 */
+	void render();
+	/**
+	 * @brief Makes sure the commands and parameters buffers can hold @p
+	 * drawCount draws, so that they can be written by a compute shader (see
+	 * TreeMethodGPU).
+	 */
+	void reserveIndirect(unsigned int drawCount);
+	GLBuffer const& getCommandsBuffer() const { return commands; };
+	GLBuffer const& getParamsBuffer() const { return params; };
+	/**
+	 * @brief Renders the @p drawCount first draws currently stored in the
+	 * commands and parameters buffers, without uploading the draw list.
+	 */
+	void renderIndirect(unsigned int drawCount);
+	~OctreeLODBatch();
+
+  private:
+	// same layout as OpenGL's DrawArraysIndirectCommand
+	struct DrawCommand
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint first;
+		GLuint baseInstance;
+	};
+
+	GLShaderProgram const& shaderProgram;
+
+	GLuint vao = 0;
+	GLBuffer vbo;
+	GLBuffer nodeIds;
+	GLBuffer commands;
+	GLBuffer params;
+	GLuint paramsTex = 0;
+
+	std::vector<QPair<const char*, unsigned int>> mapping;
+	unsigned int stride = 0; // in floats
+
+	size_t capacity = 0; // in vertices
+	// first vertex -> vertices count
+	std::map<size_t, size_t> freeBlocks;
+
+	unsigned int sliceIndex = 0;
+	unsigned int sliceCount = 1;
+
+	std::vector<DrawCommand> drawCommands;
+	std::vector<float> drawParams;
+	size_t nodeIdsCount = 0;
+
+	void reserveNodeIds(size_t count);
+	void grow(size_t minCapacity);
+	void updateVertexArray();
+};
+
+#endif // OCTREELODBATCH_H
@@ -0,0 +1,124 @@
+#ifndef TEMPORALACCUMULATION_H
+#define TEMPORALACCUMULATION_H
+
+#include <array>
+#include <memory>
+
+#include "gl/GLComputeShader.hpp"
+#include "gl/GLHandler.hpp"
+
+#include "TreeMethodLOD.hpp"
+
+/**
+ * @brief Renders a TreeMethodLOD over several frames when the camera is
+ * still.
+ *
+ * As points are blended additively, drawing a different 1/N slice of each
+ * node's points every frame with N times their luminance and averaging N
+ * consecutive frames gives the same image as drawing all the points (see
+ * OctreeLODBatch::setSlice). The trees are rendered into an offscreen HDR
+ * target, then averaged with the previous slices by temporal.comp, which
+ * reprojects them for the camera rotation since the previous slice. Once all
+ * N slices are averaged, the accumulation becomes the image added to the
+ * current target (reprojected by temporal.frag) and the next one starts.
+ *
+ * If the camera moved (or rotated fast, or brightness changed), the frame is
+ * fully drawn and becomes the image right away.
+ *
+ * One accumulation is kept per VR eye.
+ */
+class TemporalAccumulation
+{
+  public:
+	/**
+	 * @brief Constructs an accumulation of @p sliceCount frames (1 disables
+	 * slicing).
+	 */
+	TemporalAccumulation(VRHandler const& vrHandler, unsigned int sliceCount);
+	TemporalAccumulation(TemporalAccumulation const& other) = delete;
+	TemporalAccumulation& operator=(TemporalAccumulation const& other)
+	    = delete;
+	unsigned int getSliceCount() const { return sliceCount; };
+	/**
+	 * @brief Same as @p trees.render(camera, model, campos), drawing only a
+	 * slice of the points when the camera is still.
+	 *
+	 * @attention Must be called within the cosmological rendering state
+	 * (GL_LEQUAL depth test, depth clamp and GL_CLIP_DISTANCE0 enabled).
+	 */
+	void render(Camera const& camera, QMatrix4x4 const& model,
+	            QVector3D const& campos, TreeMethodLOD& trees);
+
+	/**
+	 * @brief Tracks the slices of an accumulation and the views they were
+	 * drawn from, without any OpenGL resource.
+	 */
+	struct Slicing
+	{
+		// skybox space to clip space of the image and of the last slice
+		// averaged in the accumulation
+		QMatrix4x4 imageSkybox;
+		QMatrix4x4 accumulationSkybox;
+		// slices in the accumulation, up to sliceCount
+		unsigned int frames = 0;
+
+		/**
+		 * @brief Drops the accumulation, the image is a full frame drawn
+		 * with @p skybox.
+		 */
+		void reset(QMatrix4x4 const& skybox);
+		/**
+		 * @brief Adds a slice drawn with @p skybox, returns the reprojection
+		 * from its clip space to the accumulation's.
+		 *
+		 * Once @p sliceCount slices are in, the accumulation becomes the
+		 * image and @p complete is set.
+		 */
+		QMatrix4x4 addSlice(QMatrix4x4 const& skybox, unsigned int sliceCount,
+		                    bool& complete);
+	};
+
+  private:
+	struct History
+	{
+		std::unique_ptr<GLFramebufferObject> target;
+		// last complete image, shown until the next one is complete
+		std::unique_ptr<GLTexture> image;
+		// average of the slices drawn since, ping-ponged
+		std::array<std::unique_ptr<GLTexture>, 2> accumulations;
+		Slicing slicing;
+		QVector3D campos;
+		float modelScale = 0.f;
+		float alpha      = 0.f;
+		bool darkMatter  = false;
+		// false until a first image is drawn
+		bool valid = false;
+	};
+
+	VRHandler const& vrHandler;
+	unsigned int sliceCount;
+	// one per eye
+	std::array<History, 2> histories;
+
+	GLComputeShader resolveShader;
+	GLShaderProgram shader;
+	GLMesh quad;
+
+	// camera rotation per frame above which the frame is fully drawn
+	static constexpr float maxRotation = 8.f; // in pixels
+
+	void resize(History& history, QSize const& size);
+	void drawSlice(Camera const& camera, QMatrix4x4 const& model,
+	               QVector3D const& campos, TreeMethodLOD& trees,
+	               History const& history, unsigned int slice,
+	               unsigned int slices);
+	// averages the target with history at weight blend into accumulation
+	void resolve(History const& history, GLTexture const& accumulation,
+	             GLTexture const& previous, QMatrix4x4 const& reprojection,
+	             float blend);
+	bool isStill(History const& history, QMatrix4x4 const& reprojection,
+	             QSize const& size, float modelScale, QVector3D const& campos,
+	             float pixelSolidAngle, TreeMethodLOD const& trees) const;
+};
+
+#endif // TEMPORALACCUMULATION_H
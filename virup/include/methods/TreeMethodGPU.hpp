@@ -0,0 +1,135 @@
+#ifndef TREEMETHODGPU_H
+#define TREEMETHODGPU_H
+
+#include <array>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+#include "TreeMethodLOD.hpp"
+
+/**
+ * @brief Same as TreeMethodLOD, but frustum culling and LOD selection run on
+ * the GPU.
+ *
+ * All the nodes of a tree are described in a shader storage buffer. Each
+ * frame, a compute shader (octreecull.comp) selects the nodes to render and
+ * directly writes the indirect draw commands and per-node parameters of the
+ * tree's OctreeLODBatch, which is then drawn without any CPU traversal.
+ *
+ * Residency is still decided on CPU : the compute shader also fills a
+ * feedback buffer flagging used nodes and nodes that should be refined but
+ * whose children aren't loaded. It is read back asynchronously a few frames
+ * later to load missing nodes and to unload unused ones when video memory is
+ * short.
+ */
+class TreeMethodGPU : public TreeMethodLOD
+{
+	Q_OBJECT
+  public:
+	TreeMethodGPU();
+	virtual std::string getName() const override { return "Tree GPU LOD"; };
+	/**
+	 * @brief In offline mode, the feedback of each rendering is waited for
+	 * and processed right away.
+	 */
+	virtual bool isStreaming() const override;
+	virtual void cleanUp() override;
+	virtual ~TreeMethodGPU();
+
+  protected:
+	virtual unsigned int renderTree(OctreeLOD& tree, Camera const& camera,
+	                                QMatrix4x4 const& model,
+	                                QVector3D const& campos, bool isStarField,
+	                                QMatrix4x4 const& dustTransform) override;
+
+  private:
+	// std430 layout of octreecull.comp's Node
+	struct GPUNode
+	{
+		std::array<float, 4> mid;
+		std::array<float, 4> translation;
+		GLuint first;
+		GLuint count;
+		GLint parent;
+		GLuint flags;
+	};
+
+	// frames between feedback write and read
+	static const unsigned int feedbackLatency = 3;
+	// unused feedback reads before a node can be unloaded
+	static const unsigned int unloadDelay = 60;
+	// limits stalls when many nodes are missing
+	static const unsigned int maxLoadsPerFrame = 32;
+
+	struct CulledTree
+	{
+		explicit CulledTree(OctreeLOD& root);
+		~CulledTree();
+
+		// breadth first, root first
+		std::vector<OctreeLOD*> nodes;
+		std::vector<int> parents;
+		std::vector<std::vector<unsigned int>> children;
+		std::unordered_map<OctreeLOD const*, unsigned int> indices;
+		// mirrors nodesBuffer content
+		std::vector<GPUNode> gpuNodes;
+		// nodes whose description may have changed since the last upload
+		std::vector<unsigned int> dirty;
+		std::vector<bool> isDirty;
+		// value of feedbackReads when each node was last used
+		std::vector<unsigned int> lastUsed;
+
+		GLBuffer nodesBuffer;
+		GLBuffer feedbackBuffer;
+		std::vector<GLBuffer> readbackBuffers;
+		std::array<GLsync, feedbackLatency> fences = {};
+
+		unsigned int frame         = 0;
+		unsigned int feedbackReads = 0;
+		OctreeLOD* cameraLeaf      = nullptr;
+		// last processed feedback loaded nodes or had to defer some
+		bool streaming = false;
+	};
+
+	// cullShader uniforms, set for each tree every frame
+	struct CullUniforms
+	{
+		explicit CullUniforms(GLShaderProgram const& shader);
+
+		GLShaderProgram::Uniform<int> nodesCount;
+		GLShaderProgram::Uniform<float> tanAngle;
+		GLShaderProgram::Uniform<float> alpha;
+		GLShaderProgram::Uniform<QVector3D> campos;
+		GLShaderProgram::Uniform<QMatrix4x4> model;
+		GLShaderProgram::Uniform<QMatrix4x4> camera;
+		GLShaderProgram::Uniform<QMatrix4x4> dustTransform;
+		GLint clippingPlanes;
+		GLShaderProgram::Uniform<QVector3D> shellCenter;
+		GLShaderProgram::Uniform<float> shellRadius;
+		GLShaderProgram::Uniform<int> shellSide;
+		GLShaderProgram::Uniform<int> sliceIndex;
+		GLShaderProgram::Uniform<int> sliceCount;
+	};
+
+	GLComputeShader cullShader;
+	CullUniforms cullUniforms;
+	std::map<OctreeLOD const*, std::unique_ptr<CulledTree>> culledTrees;
+
+	CulledTree& getCulledTree(OctreeLOD& tree);
+	static GPUNode describeNode(CulledTree const& t, unsigned int i);
+	// a node's description depends on its own and its children's residency
+	static void markDirty(CulledTree& t, unsigned int i);
+	// unloading a node unloads its descendants
+	static void markSubtreeDirty(CulledTree& t, unsigned int i);
+	// loading the camera leaf loads its ancestors
+	static void markPathDirty(CulledTree& t, OctreeLOD const* leaf);
+	// uploads the dirty nodes' descriptions
+	static void updateNodes(CulledTree& t);
+	// reads the feedback of the current slot ; if wait is false, only if
+	// it is ready
+	static void readFeedback(CulledTree& t, bool wait);
+	static void processFeedback(CulledTree& t, GLuint const* feedback);
+};
+
+#endif // TREEMETHODGPU_H
@@ -30,6 +30,34 @@ class TreeMethodLOD : public Method
 	virtual void render(Camera const& camera) override;
 	void render(Camera const& camera, QMatrix4x4 const& model,
 	            QVector3D const& campos);
+	/**
+	 * @brief Renders the trees only, without updating the level of detail
+	 * from frame timing.
+	 *
+	 * Used to render into other targets than the screen (see
+	 * FarFieldImpostor).
+	 */
+	void renderPoints(Camera const& camera, QMatrix4x4 const& model,
+	                  QVector3D const& campos, float pixelSolidAngle);
+	// restricts rendering to one side of a sphere, see OctreeLOD::Shell
+	void setShell(OctreeLOD::Shell const& shell) { this->shell = shell; };
+	OctreeLOD::Shell getShell() const { return shell; };
+	/**
+	 * @brief Only draws the @p index th of @p count slices of each node, see
+	 * OctreeLODBatch::setSlice.
+	 */
+	void setSlice(unsigned int index, unsigned int count);
+	/**
+	 * @brief In offline mode, the level of detail is the finest one instead
+	 * of adapting to frame timing, so that renderings don't depend on how
+	 * fast they are.
+	 */
+	void setOffline(bool offline) { this->offline = offline; };
+	/**
+	 * @brief Returns true if the last rendering lacked nodes that got loaded
+	 * since, so that rendering again gives a more complete frame.
+	 */
+	virtual bool isStreaming() const { return false; };
 	virtual void cleanUp() override;
 	virtual ~TreeMethodLOD();
 
@@ -47,11 +75,21 @@ class TreeMethodLOD : public Method
 	// ugly fix for pointSize problems
 	bool setPointSize = true;
 
+	OctreeLOD::Shell shell;
+	unsigned int sliceIndex = 0;
+	unsigned int sliceCount = 1;
+	bool offline            = false;
+
 	static void loadOctreeFromFile(std::string const& path, OctreeLOD** octree,
 	                               std::string const& name,
 	                               GLShaderProgram const& shaderProgram);
 	static void initOctree(OctreeLOD* octree, std::istream* in);
 	void setShaderColor(QColor const& color);
+	// renders one tree's nodes selected for the current tan angle
+	virtual unsigned int renderTree(OctreeLOD& tree, Camera const& camera,
+	                                QMatrix4x4 const& model,
+	                                QVector3D const& campos, bool isStarField,
+	                                QMatrix4x4 const& dustTransform);
 
 	// used to detect too long frames
 	QElapsedTimer timer;
@@ -192,9 +192,9 @@ void CSVObjects::render(Camera const& camera, ToneMappingModel const* tmm)
 	QVector3D campos;
 	getModelAndCampos(camera, model, campos);
 
-	GLHandler::glf().glEnable(GL_CLIP_DISTANCE0);
-	GLHandler::glf().glEnable(GL_POINT_SPRITE);
-	GLHandler::glf().glEnable(GL_PROGRAM_POINT_SIZE);
+	GLHandler::setEnabled(GL_CLIP_DISTANCE0, true);
+	GLHandler::setEnabled(GL_POINT_SPRITE, true);
+	GLHandler::setEnabled(GL_PROGRAM_POINT_SIZE, true);
 	GLHandler::beginTransparent(GL_ONE, GL_ONE);
 	shader.setUniform("pixelSolidAngle", camera.pixelSolidAngle());
 	shader.setUniform("brightnessMultiplier", brightnessMultiplier);
@@ -213,17 +213,25 @@ void CSVObjects::render(Camera const& camera, ToneMappingModel const* tmm)
 	GLHandler::setUpRender(shader, model);
 	mesh.render();
 	GLHandler::endTransparent();
-	GLHandler::glf().glDisable(GL_PROGRAM_POINT_SIZE);
-	GLHandler::glf().glDisable(GL_POINT_SPRITE);
-	GLHandler::glf().glDisable(GL_CLIP_DISTANCE0);
+	GLHandler::setEnabled(GL_PROGRAM_POINT_SIZE, false);
+	GLHandler::setEnabled(GL_POINT_SPRITE, false);
+	GLHandler::setEnabled(GL_CLIP_DISTANCE0, false);
+}
 
+void CSVObjects::renderConstellations(Camera const& camera,
+                                      ToneMappingModel const* tmm)
+{
 	if(containsConstellations)
 	{
-		GLHandler::glf().glEnable(GL_MULTISAMPLE);
+		QMatrix4x4 model;
+		QVector3D campos;
+		getModelAndCampos(camera, model, campos);
+
+		GLHandler::setEnabled(GL_MULTISAMPLE, true);
 		GLHandler::beginTransparent(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-		GLHandler::glf().glEnable(GL_LINE_SMOOTH);
+		GLHandler::setEnabled(GL_LINE_SMOOTH, true);
 		GLHandler::glf().glLineWidth(2.f);
-		GLHandler::glf().glEnable(GL_PRIMITIVE_RESTART);
+		GLHandler::setEnabled(GL_PRIMITIVE_RESTART, true);
 		GLHandler::glf().glPrimitiveRestartIndex(0xFFFF);
 
 		conShader.setUniform("alpha", constellationsAlpha);
@@ -233,9 +241,9 @@ void CSVObjects::render(Camera const& camera, ToneMappingModel const* tmm)
 		GLHandler::setUpRender(conShader, model);
 		conMesh.render(PrimitiveType::LINE_STRIP);
 
-		GLHandler::glf().glDisable(GL_PRIMITIVE_RESTART);
+		GLHandler::setEnabled(GL_PRIMITIVE_RESTART, false);
 		GLHandler::glf().glLineWidth(1.f);
-		GLHandler::glf().glDisable(GL_LINE_SMOOTH);
+		GLHandler::setEnabled(GL_LINE_SMOOTH, false);
 		GLHandler::endTransparent();
 
 		if(constellationsLabels > 0.f)
@@ -264,7 +272,7 @@ void CSVObjects::render(Camera const& camera, ToneMappingModel const* tmm)
 				conLabel.second->render(tmm->exposure, tmm->dynamicrange);
 			}
 		}
-		GLHandler::glf().glDisable(GL_MULTISAMPLE);
+		GLHandler::setEnabled(GL_MULTISAMPLE, false);
 	}
 }
 
@@ -18,16 +18,31 @@
 
 #include "CosmologicalSimulation.hpp"
 
+#include "gl/GLProfiler.hpp"
+
 CosmologicalSimulation::CosmologicalSimulation(
-    std::string const& gazOctreePath, std::string const& starsOctreePath,
+    VRHandler const& vrHandler, std::string const& gazOctreePath,
+    std::string const& starsOctreePath,
     std::string const& darkMatterOctreePath)
+    : trees(QSettings().value("graphics/gpuculling").toBool()
+                ? new TreeMethodGPU
+                : new TreeMethodLOD)
 {
-	trees.init(gazOctreePath, starsOctreePath, darkMatterOctreePath);
+	trees->init(gazOctreePath, starsOctreePath, darkMatterOctreePath);
+	if(QSettings().value("graphics/impostors").toBool())
+	{
+		impostor = new FarFieldImpostor(vrHandler);
+	}
+	unsigned int slices(QSettings().value("graphics/temporalslices").toUInt());
+	if(slices > 1)
+	{
+		temporal = new TemporalAccumulation(vrHandler, slices);
+	}
 }
 
 BBox CosmologicalSimulation::getBoundingBox() const
 {
-	return trees.getDataBoundingBox();
+	return trees->getDataBoundingBox();
 }
 
 void CosmologicalSimulation::render(Camera const& camera,
@@ -37,8 +52,35 @@ void CosmologicalSimulation::render(Camera const& camera,
 	QVector3D campos;
 	getModelAndCampos(camera, model, campos);
 
-	trees.setAlpha(brightnessMultiplier);
-	GLHandler::glf().glEnable(GL_CLIP_DISTANCE0);
-	trees.render(camera, model, campos);
-	GLHandler::glf().glDisable(GL_CLIP_DISTANCE0);
+	trees->setAlpha(brightnessMultiplier);
+	GLHandler::setEnabled(GL_CLIP_DISTANCE0, true);
+	// both draw screen space quads, which can't be projected directly
+	bool direct(GLHandler::getDirectProjection() != 0);
+	if(impostor != nullptr && !direct)
+	{
+		// far field, trees then only render the near field
+		GLProfiler::Scope scope("impostor");
+		impostor->render(camera, getRelToAbsTransform(), *trees);
+	}
+	else if(impostor != nullptr)
+	{
+		trees->setShell(OctreeLOD::Shell());
+	}
+	GLProfiler::Scope scope("trees");
+	if(temporal != nullptr && !direct)
+	{
+		temporal->render(camera, model, campos, *trees);
+	}
+	else
+	{
+		trees->render(camera, model, campos);
+	}
+	GLHandler::setEnabled(GL_CLIP_DISTANCE0, false);
+}
+
+CosmologicalSimulation::~CosmologicalSimulation()
+{
+	delete temporal;
+	delete impostor;
+	delete trees;
 }
@@ -18,6 +18,8 @@
 
 #include "Grid.hpp"
 
+#include "SettingsSnapshot.hpp"
+
 Grid::Grid()
     : shader("default")
     , scaleText3D(1024, 256)
@@ -40,6 +42,7 @@ Grid::Grid()
 void Grid::setColor(QColor const& color)
 {
 	QSettings().setValue("misc/gridcolor", color);
+	SettingsSnapshot::refresh();
 	shader.setUniform("color", color);
 }
 
@@ -470,7 +470,7 @@ void MainWin::actionEvent(BaseInputManager::Action a, bool pressed)
 			}
 			else if(a.id == "toggledm")
 			{
-				cosmologicalSim->trees.toggleDarkMatter();
+				cosmologicalSim->trees->toggleDarkMatter();
 			}
 			else if(a.id == "togglegrid")
 			{
@@ -693,7 +693,7 @@ void MainWin::initScene()
 
 	// COSMO LOADING
 	cosmologicalSim = new CosmologicalSimulation(
-	    QSettings().value("data/gazfile").toString().toStdString(),
+	    *vrHandler, QSettings().value("data/gazfile").toString().toStdString(),
 	    QSettings().value("data/starsfile").toString().toStdString(),
 	    QSettings().value("data/loaddarkmatter").toBool()
 	        ? QSettings().value("data/darkmatterfile").toString().toStdString()
@@ -727,7 +727,11 @@ void MainWin::initScene()
 
 	renderer.removeSceneRenderPath("default");
 
-	renderer.appendSceneRenderPath("cosmo", Renderer::RenderPath(cam));
+	// points only, then what needs a regular projection with the same camera
+	Renderer::RenderPath cosmoPath(cam);
+	cosmoPath.directProjection = true;
+	renderer.appendSceneRenderPath("cosmo", cosmoPath);
+	renderer.appendSceneRenderPath("cosmooverlay", Renderer::RenderPath(cam));
 	renderer.appendSceneRenderPath("planet", Renderer::RenderPath(camPlanet));
 
 	// we will draw them ourselves
@@ -769,7 +773,9 @@ void MainWin::initScene()
 	lenseDistortionMap
 	    = new GLTexture("data/virup/images/pointmass-distortion.png", false);
 
-	renderer.appendPostProcessingShader("lensing", "lensing");
+	renderer.appendPostProcessingShader(
+	    "lensing", "lensing", {},
+	    Renderer::PostProcessingFootprint::NEIGHBORHOOD);
 
 	// TRANSITIONS
 	if(networkManager->isServer())
@@ -797,8 +803,7 @@ void MainWin::initScene()
 		{
 			auto button = new QPushButton(scenes[i]);
 			connect(button, &QPushButton::clicked, this, [i]() {
-				PythonQtHandler::evalScript("setSceneId(" + QString::number(i)
-				                            + ")");
+				PythonQtHandler::callHook("setSceneId", {i});
 			});
 			button->setFocusPolicy(Qt::NoFocus);
 			layout->addWidget(button);
@@ -809,12 +814,17 @@ void MainWin::initScene()
 		    = new QPushButton("Toggle transitions (only if user is sick, can "
 		                      "introduce problems !)");
 		connect(transitionsButton, &QPushButton::clicked, this,
-		        []() { PythonQtHandler::evalScript("toggleAnimations()"); });
+		        []() { PythonQtHandler::callHook("toggleAnimations"); });
 		transitionsButton->setFocusPolicy(Qt::NoFocus);
 		layout->addWidget(transitionsButton);
 	}
 }
 
+bool MainWin::isSceneSettled()
+{
+	return !loaded || !cosmologicalSim->trees->isStreaming();
+}
+
 void MainWin::updateScene(BasicCamera& camera, QString const& pathId)
 {
 	if(!loaded)
@@ -827,6 +837,7 @@ void MainWin::updateScene(BasicCamera& camera, QString const& pathId)
 		auto& cam(dynamic_cast<Camera&>(camera));
 		cam.currentFrameTiming = frameTiming;
 		cam.updateTargetFPS();
+		cosmologicalSim->trees->setOffline(offlinemode);
 
 		/*float distPeriod = 60.f, anglePeriod = 10.f;
 		integralDt += dt;
@@ -961,7 +972,16 @@ void MainWin::updateScene(BasicCamera& camera, QString const& pathId)
 
 		sysInWorld = cosmoCam.dataToWorldPosition(lastData);
 
-		clock.update();
+		if(offlinemode)
+		{
+			// virtual time, independent from the real one
+			clock.setCurrentUt(clock.getCurrentUt()
+			                   + clock.getTimeCoeff() * frameTiming);
+		}
+		else
+		{
+			clock.update();
+		}
 		cam.updateUT(clock.getCurrentUt());
 
 		systemRenderer->updateMesh(clock.getCurrentUt(), cam);
@@ -995,6 +1015,7 @@ void MainWin::renderScene(BasicCamera const& camera, QString const& pathId)
 		}
 		else
 		{
+			GLProfiler::Scope scope("planetary system");
 			systemRenderer->render(camera);
 			renderer.renderVRControls();
 			systemRenderer->renderTransparent(camera);
@@ -1005,6 +1026,7 @@ void MainWin::renderScene(BasicCamera const& camera, QString const& pathId)
 		}
 		if(showGrid)
 		{
+			GLProfiler::Scope scope("grid");
 			grid->render(getScale(), 1.125);
 		}
 		movementControls->renderGuides();
@@ -1026,24 +1048,45 @@ void MainWin::renderScene(BasicCamera const& camera, QString const& pathId)
 		return;
 	}
 
+	auto& cam(dynamic_cast<Camera const&>(camera));
+
+	GLHandler::setDepthFunc(GL_LEQUAL);
+	GLHandler::setEnabled(GL_DEPTH_CLAMP, true);
+	GLHandler::setEnabled(GL_CLIP_DISTANCE0, true);
+	if(pathId == "cosmo")
+	{
+		{
+			GLProfiler::Scope scope("hyg");
+			hyg->render(cam, toneMappingModel);
+		}
+		{
+			GLProfiler::Scope scope("sdss");
+			sdss->render(cam, toneMappingModel);
+		}
+		{
+			GLProfiler::Scope scope("simulation");
+			cosmologicalSim->render(cam, toneMappingModel);
+		}
+		GLHandler::setEnabled(GL_CLIP_DISTANCE0, false);
+		GLHandler::setEnabled(GL_DEPTH_CLAMP, false);
+		return;
+	}
+
 	if(!OctreeLOD::renderPlanetarySystem)
 	{
 		renderer.renderVRControls();
 	}
-	auto& cam(dynamic_cast<Camera const&>(camera));
-
-	GLHandler::glf().glDepthFunc(GL_LEQUAL);
-	GLHandler::glf().glEnable(GL_DEPTH_CLAMP);
-	GLHandler::glf().glEnable(GL_CLIP_DISTANCE0);
 	hyg->constellationsLabels = CelestialBodyRenderer::renderLabels;
 	hyg->constellationsAlpha  = CelestialBodyRenderer::renderLabels;
-	hyg->render(cam, toneMappingModel);
-	sdss->render(cam, toneMappingModel);
-	cosmologicalSim->render(cam, toneMappingModel);
+	{
+		GLProfiler::Scope scope("constellations");
+		hyg->renderConstellations(cam, toneMappingModel);
+	}
 
 	// TODO(florian) better than this
 	if(CelestialBodyRenderer::renderLabels > 0.f)
 	{
+		GLProfiler::Scope scope("labels");
 		for(auto cosmoLabel : cosmoLabels)
 		{
 			if(cosmoLabel.first == solarSystemDataPos
@@ -1056,8 +1099,8 @@ void MainWin::renderScene(BasicCamera const& camera, QString const& pathId)
 			                          toneMappingModel->dynamicrange);
 		}
 	}
-	GLHandler::glf().glDisable(GL_CLIP_DISTANCE0);
-	GLHandler::glf().glDisable(GL_DEPTH_CLAMP);
+	GLHandler::setEnabled(GL_CLIP_DISTANCE0, false);
+	GLHandler::setEnabled(GL_DEPTH_CLAMP, false);
 
 	// update here because depends on eye
 	QVector3D pos(
@@ -1090,7 +1133,8 @@ void MainWin::applyPostProcShaderParams(
 		shader.setUniform("lenseDist", lenseDist);
 		shader.setUniform("radiusLimit", 0.2f);
 
-		shader.setUniform("distortionMap", 1);
+		// units 0 and 1 are the input and output images
+		shader.setUniform("distortionMap", 2);
 	}
 }
 
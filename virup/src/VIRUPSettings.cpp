@@ -72,6 +72,17 @@ VIRUPSettings::VIRUPSettings(QWidget* parent)
 	addUIntSetting("atmoquality", 6, tr("Atmosphere rendering quality"), 1, 5);
 	addUIntSetting("maxlightcasters", 2,
 	               tr("Maximum number of light casters per object"), 1, 2);
+	addBoolSetting("gpuculling", false,
+	               tr("GPU octree culling and LOD selection"));
+	addBoolSetting("impostors", false,
+	               tr("Cache distant cosmological data in a cubemap"));
+	addUIntSetting("impostorshell", 1000,
+	               tr("Cached data minimum distance (in m)"), 1, 1000000);
+	addUIntSetting("impostorparallax", 2,
+	               tr("Cached data maximum parallax error (in pixels)"), 1,
+	               100);
+	addUIntSetting("temporalslices", 1,
+	               tr("Frames to accumulate points over when still"), 1, 16);
 
 	setCurrentIndex(0);
 }
@@ -18,6 +18,9 @@
 
 #include "VolumetricModel.hpp"
 
+#include "SettingsSnapshot.hpp"
+#include "gl/GLProfiler.hpp"
+
 VolumetricModel::VolumetricModel(QString const& datFile)
     : shader("volume")
 {
@@ -90,10 +93,11 @@ void VolumetricModel::render(Camera const& /*camera*/, QMatrix4x4 const& model,
                              QVector3D const& campos,
                              VolumetricModel const* occlusionModel)
 {
+	GLProfiler::Scope scope("volume");
 	GLHandler::beginTransparent(GL_ONE, GL_ONE);
 	GLHandler::setBackfaceCulling(true, GL_FRONT);
-	shader.setUniform(
-	    "color", QSettings().value("data/darkmattercolor").value<QColor>());
+	static const Setting<QColor> darkMatterColor("data/darkmattercolor");
+	shader.setUniform("color", darkMatterColor.get());
 	shader.setUniform("campos", dataModel.inverted() * campos);
 
 	std::vector<GLTexture const*> texs({tex});
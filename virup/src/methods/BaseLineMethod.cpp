@@ -1,4 +1,6 @@
 #include "methods/BaseLineMethod.hpp"
+
+#include "SettingsSnapshot.hpp"
 BaseLineMethod::BaseLineMethod()
     : BaseLineMethod("invsq")
 {
@@ -106,19 +108,19 @@ void BaseLineMethod::render(Camera const& camera)
 	    "alpha", static_cast<float>(camera.scale * camera.scale * getAlpha()));
 	shaderProgram.setUniform(
 	    "view", camera.hmdScaledSpaceToWorldTransform().inverted() * model);
+	static const Setting<QColor> gazColor("data/gazcolor");
+	static const Setting<QColor> starsColor("data/starscolor");
+	static const Setting<QColor> darkMatterColor("data/darkmattercolor");
 	GLHandler::beginTransparent(GL_SRC_ALPHA, GL_ONE);
 	GLHandler::setUpRender(shaderProgram, model);
-	shaderProgram.setUniform(
-	    "color", QSettings().value("data/gazcolor").value<QColor>());
+	shaderProgram.setUniform("color", gazColor.get());
 	shaderProgram.setUnusedAttributesValues({{"luminosity", {1.f}}});
 	gazMesh.render();
-	shaderProgram.setUniform(
-	    "color", QSettings().value("data/starscolor").value<QColor>());
+	shaderProgram.setUniform("color", starsColor.get());
 	shaderProgram.setUnusedAttributesValues(
 	    {{"radius", {1.f}}, {"luminosity", {1.f}}});
 	starsMesh.render();
-	shaderProgram.setUniform(
-	    "color", QSettings().value("data/darkmattercolor").value<QColor>());
+	shaderProgram.setUniform("color", darkMatterColor.get());
 	shaderProgram.setUnusedAttributesValues(
 	    {{"radius", {1.f}}, {"luminosity", {1.f}}});
 	darkMatterMesh.render();
@@ -4,8 +4,8 @@ BaseLineMethodTex::BaseLineMethodTex()
     : BaseLineMethod("gaz")
     , tex("data/virup/images/particle.png")
 {
-	GLHandler::glf().glEnable(GL_POINT_SPRITE);
-	GLHandler::glf().glEnable(GL_PROGRAM_POINT_SIZE);
+	GLHandler::setEnabled(GL_POINT_SPRITE, true);
+	GLHandler::setEnabled(GL_PROGRAM_POINT_SIZE, true);
 }
 
 void BaseLineMethodTex::render(Camera const& camera)
@@ -0,0 +1,152 @@
+#include "methods/FarFieldImpostor.hpp"
+
+#include <array>
+#include <cmath>
+
+// solid angle of a cubemap texel at the center of a face
+static float texelSolidAngle(unsigned int side)
+{
+	double radPerPix(M_PI_2 / side);
+	return 4.0 * asin(sin(radPerPix / 2.0) * sin(radPerPix / 2.0));
+}
+
+FarFieldImpostor::FarFieldImpostor(VRHandler const& vrHandler)
+    : captureCamera(vrHandler)
+    , shader("impostor")
+    , shellRadius(QSettings().value("graphics/impostorshell").toUInt())
+    , maxParallax(QSettings().value("graphics/impostorparallax").toUInt())
+{
+	Primitives::setAsUnitCube(cube, shader);
+}
+
+void FarFieldImpostor::render(Camera const& camera,
+                              QMatrix4x4 const& relToAbsTransform,
+                              TreeMethodLOD& trees)
+{
+	QMatrix4x4 model(camera.dataToWorldTransform() * relToAbsTransform);
+	QVector3D campos(relToAbsTransform.inverted()
+	                 * Utils::toQt(camera.getTruePosition()));
+
+	// brightness or content changed, cached faces are invalid
+	if(!matches(front, trees))
+	{
+		front.faces = 0;
+	}
+	if(capturing && !matches(back, trees))
+	{
+		capturing = false;
+	}
+
+	float maxAngle(maxParallax * sqrt(camera.pixelSolidAngle()));
+	if(!capturing
+	   && (!front.complete()
+	       || campos.distanceToPoint(front.shell.center)
+	              > 0.5f * maxAngle * front.shell.radius))
+	{
+		startCapture(camera, model, campos, trees);
+	}
+	if(capturing)
+	{
+		renderFace(camera, relToAbsTransform, trees);
+		if(back.complete())
+		{
+			std::swap(front, back);
+			back.faces = 0;
+			capturing  = false;
+		}
+	}
+
+	if(!front.complete())
+	{
+		trees.setShell(OctreeLOD::Shell());
+		return;
+	}
+
+	GLHandler::beginTransparent(GL_ONE, GL_ONE);
+	// impostor.vert reads the skybox transform from camera.glsl
+	shader.use();
+	GLHandler::useTextures({&front.target->getColorAttachmentTexture()});
+	GLHandler::setBackfaceCulling(false);
+	cube.render();
+	GLHandler::setBackfaceCulling(true);
+	GLHandler::endTransparent();
+
+	OctreeLOD::Shell nearField(front.shell);
+	nearField.side = -1;
+	trees.setShell(nearField);
+}
+
+bool FarFieldImpostor::matches(Capture const& capture,
+                               TreeMethodLOD const& trees)
+{
+	return capture.alpha == trees.getAlpha()
+	       && capture.darkMatter == trees.isDarkMatterEnabled();
+}
+
+void FarFieldImpostor::startCapture(Camera const& camera,
+                                    QMatrix4x4 const& model,
+                                    QVector3D const& campos,
+                                    TreeMethodLOD const& trees)
+{
+	// about one texel per pixel
+	auto side(static_cast<unsigned int>(
+	    ceil(M_PI_2 / sqrt(camera.pixelSolidAngle()))));
+	side = std::max(64u, std::min(4096u, side));
+	if(!back.target
+	   || back.target->getSize().width() != static_cast<int>(side))
+	{
+		back.target.reset(new GLFramebufferObject(
+		    GLTexture::TexCubemapProperties(side, GL_RGBA32F),
+		    {GL_LINEAR, GL_CLAMP_TO_EDGE}));
+	}
+
+	// data space radius of the world space shell
+	float modelScale(QVector3D(model * QVector4D(1.f, 0.f, 0.f, 0.f)).length());
+
+	back.position     = camera.getTruePosition();
+	back.shell.center = campos;
+	back.shell.radius = shellRadius / modelScale;
+	back.shell.side   = 1;
+	back.alpha        = trees.getAlpha();
+	back.darkMatter   = trees.isDarkMatterEnabled();
+	back.faces        = 0;
+	capturing         = true;
+
+	captureCamera.scale = camera.scale;
+}
+
+void FarFieldImpostor::renderFace(Camera const& camera,
+                                  QMatrix4x4 const& relToAbsTransform,
+                                  TreeMethodLOD& trees)
+{
+	// generateEnvironmentMapFace binds the cubemap, restore the current target
+	GLint previousTarget(0);
+	std::array<GLint, 4> viewport = {};
+	GLHandler::glf().glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING,
+	                               &previousTarget);
+	GLHandler::glf().glGetIntegerv(GL_VIEWPORT, &viewport[0]);
+
+	unsigned int side(back.target->getSize().width());
+	captureCamera.position = back.position;
+	captureCamera.setWindowSize(back.target->getSize());
+	QMatrix4x4 model(captureCamera.dataToWorldTransform() * relToAbsTransform);
+
+	trees.setShell(back.shell);
+	GLHandler::generateEnvironmentMapFace(
+	    *back.target,
+	    [&](bool, QMatrix4x4 view, QMatrix4x4 proj) {
+		    captureCamera.setView(view);
+		    captureCamera.setProj(proj);
+		    captureCamera.update2D(QMatrix4x4());
+		    captureCamera.uploadMatrices();
+		    trees.renderPoints(captureCamera, model, back.shell.center,
+		                       texelSolidAngle(side));
+	    },
+	    static_cast<GLTexture::CubemapFace>(back.faces));
+	++back.faces;
+
+	GLHandler::glf().glBindFramebuffer(GL_FRAMEBUFFER, previousTarget);
+	GLHandler::glf().glViewport(viewport[0], viewport[1], viewport[2],
+	                            viewport[3]);
+	camera.uploadMatrices();
+}
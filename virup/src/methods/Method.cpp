@@ -6,8 +6,10 @@ Method::Method(std::string const& shadersCommonName)
 }
 
 Method::Method(std::string const& vertexShaderPath,
-               std::string const& fragmentShaderPath)
-    : shaderProgram(vertexShaderPath.c_str(), fragmentShaderPath.c_str())
+               std::string const& fragmentShaderPath,
+               QMap<QString, QString> const& defines)
+    : shaderProgram(vertexShaderPath.c_str(), fragmentShaderPath.c_str(),
+                    defines)
 {
 	resetAlpha();
 }
@@ -1,5 +1,7 @@
 #include "methods/OctreeLOD.hpp"
 
+#include "profiling.hpp"
+
 int64_t& OctreeLOD::usedMem()
 {
 	static int64_t usedMem(0);
@@ -31,14 +33,17 @@ Vector3& OctreeLOD::solarSystemDataPos()
 // drawing)
 
 OctreeLOD::OctreeLOD(GLShaderProgram const& shaderProgram)
-    : shaderProgram(&shaderProgram)
+    : batch(std::make_shared<OctreeLODBatch>(shaderProgram))
+    , shaderProgram(&shaderProgram)
 {
 }
 
 OctreeLOD::OctreeLOD(GLShaderProgram const& shaderProgram,
+                     std::shared_ptr<OctreeLODBatch> const& batch,
                      Octree::CommonData& commonData, unsigned int lvl)
     : Octree(commonData)
     , lvl(lvl)
+    , batch(batch)
     , shaderProgram(&shaderProgram)
 {
 }
@@ -62,6 +67,7 @@ void OctreeLOD::init(int64_t file_addr, std::istream& in)
 
 void OctreeLOD::readOwnData(std::istream& in)
 {
+	CPUProfiler::Zone zone("octree node read");
 	Octree::readOwnData(in);
 
 	if((getFlags() & Flags::NORMALIZED_NODES) == Flags::NONE)
@@ -145,7 +151,8 @@ void OctreeLOD::unload()
 	{
 		usedMem() -= dataSize * sizeof(float);
 		dataSize = 0;
-		delete mesh;
+		batch->free(block);
+		block = OctreeLODBatch::Block();
 		for(Octree* oct : children)
 		{
 			if(oct != nullptr)
@@ -199,7 +206,21 @@ bool OctreeLOD::preloadLevel(unsigned int lvlToLoad)
 unsigned int OctreeLOD::renderAboveTanAngle(
     float tanAngle, Camera const& camera, QMatrix4x4 const& globalModel,
     QVector3D const& globalCampos, unsigned int maxPoints, bool isStarField,
-    float alpha, QMatrix4x4 const& globalDustModel)
+    float alpha, QMatrix4x4 const& globalDustModel, Shell const& shell)
+{
+	batch->clear();
+	unsigned int result(collectAboveTanAngle(tanAngle, camera, globalModel,
+	                                         globalCampos, maxPoints,
+	                                         isStarField, alpha,
+	                                         globalDustModel, shell));
+	batch->render();
+	return result;
+}
+
+unsigned int OctreeLOD::collectAboveTanAngle(
+    float tanAngle, Camera const& camera, QMatrix4x4 const& globalModel,
+    QVector3D const& globalCampos, unsigned int maxPoints, bool isStarField,
+    float alpha, QMatrix4x4 const& globalDustModel, Shell const& shell)
 {
 	if(camera.shouldBeCulled(bbox, globalModel, true) && lvl > 0)
 	{
@@ -209,6 +230,11 @@ unsigned int OctreeLOD::renderAboveTanAngle(
 		}
 		return 0;
 	}
+	// rendered by the other side's pass, don't unload
+	if(shell.excludes(bbox))
+	{
+		return 0;
+	}
 
 	if(!isLoaded)
 	{
@@ -231,9 +257,9 @@ unsigned int OctreeLOD::renderAboveTanAngle(
 		{
 			if(oct != nullptr)
 			{
-				remaining -= dynamic_cast<OctreeLOD*>(oct)->renderAboveTanAngle(
+				remaining -= dynamic_cast<OctreeLOD*>(oct)->collectAboveTanAngle(
 				    tanAngle, camera, globalModel, globalCampos, remaining,
-				    isStarField, alpha, globalDustModel);
+				    isStarField, alpha, globalDustModel, shell);
 			}
 		}
 		return maxPoints - remaining;
@@ -253,118 +279,178 @@ unsigned int OctreeLOD::renderAboveTanAngle(
 
 	if(isLeaf())
 	{
-		Vector3 campos(Utils::fromQt(globalCampos));
-
-		// see if useful for optimization or not... 100 is too much for Eagle
-		// data (won't trigger until precision problems already appear)
-		if(/*camera.scale > 100 &&*/ campos[0] > bbox.minx
-		   && campos[0] < bbox.maxx && campos[1] > bbox.miny
-		   && campos[1] < bbox.maxy && campos[2] > bbox.minz
-		   && campos[2] < bbox.maxz)
+		updatePrecision(camera, globalCampos, isStarField);
+	}
+
+	if(dataSize / commonData.dimPerVertex <= maxPoints)
+	{
+		QMatrix4x4 model;
+		model.translate(Utils::toQt(localTranslation));
+
+		batch->addDraw(block, GLHandler::getCameraMatrix(globalModel * model),
+		               globalDustModel * model, model.inverted() * globalCampos,
+		               alpha * totalDataSize / dataSize);
+		return dataSize / commonData.dimPerVertex;
+	}
+	return 0;
+}
+
+void OctreeLOD::updatePrecision(Camera const& camera,
+                                QVector3D const& globalCampos,
+                                bool isStarField)
+{
+	Vector3 campos(Utils::fromQt(globalCampos));
+
+	// see if useful for optimization or not... 100 is too much for Eagle
+	// data (won't trigger until precision problems already appear)
+	if(/*camera.scale > 100 &&*/ campos[0] > bbox.minx
+	   && campos[0] < bbox.maxx && campos[1] > bbox.miny
+	   && campos[1] < bbox.maxy && campos[2] > bbox.minz
+	   && campos[2] < bbox.maxz)
+	{
+		Vector3 closest(DBL_MAX, DBL_MAX, DBL_MAX);
+		if((campos - closestBackup).length() > neighborDist / 2.0)
 		{
-			Vector3 closest(DBL_MAX, DBL_MAX, DBL_MAX);
-			if((campos - closestBackup).length() > neighborDist / 2.0)
+			if(absoluteData.empty())
 			{
-				if(absoluteData.empty())
-				{
-					readOwnData(*file);
-					absoluteData = getOwnData();
-					data.resize(0);
-					data.shrink_to_fit();
-				}
+				readOwnData(*file);
+				absoluteData = getOwnData();
+				data.resize(0);
+				data.shrink_to_fit();
+			}
 
-				double dist(FLT_MAX);
-				for(unsigned int i(0); i < absoluteData.size();
-				    i += commonData.dimPerVertex)
+			double dist(FLT_MAX);
+			for(unsigned int i(0); i < absoluteData.size();
+			    i += commonData.dimPerVertex)
+			{
+				Vector3 x(absoluteData[i], absoluteData[i + 1],
+				          absoluteData[i + 2]);
+				double distx((campos - x).length());
+				if(distx < dist)
 				{
-					Vector3 x(absoluteData[i], absoluteData[i + 1],
-					          absoluteData[i + 2]);
-					double distx((campos - x).length());
-					if(distx < dist)
-					{
-						closest = x;
-						dist    = distx;
-					}
+					closest = x;
+					dist    = distx;
 				}
 			}
-			else
+		}
+		else
+		{
+			closest = closestBackup;
+		}
+		localTranslation = closest;
+		bool switchedPoint(false);
+		if(closest != closestBackup)
+		{
+			switchedPoint = true;
+			closestBackup = closest;
+
+			std::vector<float> vertexData(absoluteData);
+			for(unsigned int i(0); i < vertexData.size();
+			    i += commonData.dimPerVertex)
 			{
-				closest = closestBackup;
+				vertexData[i] -= closest[0];
+				vertexData[i + 1] -= closest[1];
+				vertexData[i + 2] -= closest[2];
 			}
-			localTranslation = closest;
-			bool switchedPoint(false);
-			if(closest != closestBackup)
-			{
-				switchedPoint = true;
-				closestBackup = closest;
+			batch->setVertices(block, vertexData);
 
-				std::vector<float> vertexData(absoluteData);
-				for(unsigned int i(0); i < vertexData.size();
-				    i += commonData.dimPerVertex)
+			Vector3 closestNeighbor(DBL_MAX, DBL_MAX, DBL_MAX);
+			neighborDist = DBL_MAX;
+			for(unsigned int i(0); i < vertexData.size();
+			    i += commonData.dimPerVertex)
+			{
+				Vector3 x(vertexData[i], vertexData[i + 1],
+				          vertexData[i + 2]);
+				// it's closest itself !
+				if(x.length() == 0.0)
 				{
-					vertexData[i] -= closest[0];
-					vertexData[i + 1] -= closest[1];
-					vertexData[i + 2] -= closest[2];
+					continue;
 				}
-				mesh->setVertices(vertexData);
 
-				Vector3 closestNeighbor(DBL_MAX, DBL_MAX, DBL_MAX);
-				neighborDist = DBL_MAX;
-				for(unsigned int i(0); i < vertexData.size();
-				    i += commonData.dimPerVertex)
+				if(x.length() < neighborDist)
 				{
-					Vector3 x(vertexData[i], vertexData[i + 1],
-					          vertexData[i + 2]);
-					// it's closest itself !
-					if(x.length() == 0.0)
-					{
-						continue;
-					}
-
-					if(x.length() < neighborDist)
-					{
-						closestNeighbor = x;
-						neighborDist    = x.length();
-					}
+					closestNeighbor = x;
+					neighborDist    = x.length();
 				}
 			}
+		}
 
-			if(isStarField)
+		if(isStarField)
+		{
+			if(camera.scale * neighborDist > 2
+			   && (!renderPlanetarySystem || switchedPoint))
 			{
-				if(camera.scale * neighborDist > 2
-				   && (!renderPlanetarySystem || switchedPoint))
-				{
-					planetarySysInitData() = closest;
-					renderPlanetarySystem  = true;
-				}
-				else if(camera.scale * neighborDist <= 2)
-				{
-					renderPlanetarySystem = false;
-				}
+				planetarySysInitData() = closest;
+				renderPlanetarySystem  = true;
+			}
+			else if(camera.scale * neighborDist <= 2)
+			{
+				renderPlanetarySystem = false;
 			}
 		}
-		else
+	}
+	else
+	{
+		absoluteData.resize(0);
+		absoluteData.shrink_to_fit();
+		closestBackup = Vector3(DBL_MAX, DBL_MAX, DBL_MAX);
+		neighborDist  = 0.0;
+	}
+}
+
+OctreeLOD* OctreeLOD::updateCameraLeaf(Camera const& camera,
+                                      QVector3D const& globalCampos,
+                                      bool isStarField)
+{
+	Vector3 campos(Utils::fromQt(globalCampos));
+	if(campos[0] <= bbox.minx || campos[0] >= bbox.maxx
+	   || campos[1] <= bbox.miny || campos[1] >= bbox.maxy
+	   || campos[2] <= bbox.minz || campos[2] >= bbox.maxz)
+	{
+		return nullptr;
+	}
+
+	load();
+	if(isLeaf())
+	{
+		updatePrecision(camera, globalCampos, isStarField);
+		return this;
+	}
+	for(Octree* oct : children)
+	{
+		if(oct != nullptr)
 		{
-			absoluteData.resize(0);
-			absoluteData.shrink_to_fit();
-			closestBackup = Vector3(DBL_MAX, DBL_MAX, DBL_MAX);
-			neighborDist  = 0.0;
+			OctreeLOD* leaf(dynamic_cast<OctreeLOD*>(oct)->updateCameraLeaf(
+			    camera, globalCampos, isStarField));
+			if(leaf != nullptr)
+			{
+				return leaf;
+			}
 		}
 	}
+	return nullptr;
+}
 
-	if(dataSize / commonData.dimPerVertex <= maxPoints)
+void OctreeLOD::load()
+{
+	if(!isLoaded)
 	{
-		QMatrix4x4 model;
-		model.translate(Utils::toQt(localTranslation));
+		readOwnData(*file);
+		ramToVideo();
+	}
+}
 
-		shaderProgram->setUniform("alpha", alpha * totalDataSize / dataSize);
-		shaderProgram->setUniform("campos", model.inverted() * globalCampos);
-		shaderProgram->setUniform("dusttransform", globalDustModel * model);
-		GLHandler::setUpRender(*shaderProgram, globalModel * model);
-		mesh->render();
-		return dataSize / commonData.dimPerVertex;
+std::vector<OctreeLOD*> OctreeLOD::getChildrenNodes() const
+{
+	std::vector<OctreeLOD*> result;
+	for(Octree* oct : children)
+	{
+		if(oct != nullptr)
+		{
+			result.push_back(dynamic_cast<OctreeLOD*>(oct));
+		}
 	}
-	return 0;
+	return result;
 }
 
 void OctreeLOD::computeBBox()
@@ -393,7 +479,6 @@ float OctreeLOD::currentTanAngle(QVector3D const& campos) const
 
 void OctreeLOD::ramToVideo()
 {
-	mesh                                                  = new GLMesh;
 	std::vector<QPair<const char*, unsigned int>> mapping = {{"position", 3}};
 	std::vector<QPair<const char*, std::vector<float>>> unused;
 	if((getFlags() & Flags::STORE_RADIUS) != Flags::NONE)
@@ -417,8 +502,14 @@ void OctreeLOD::ramToVideo()
 		mapping.emplace_back("color", 3);
 	}
 	shaderProgram->setUnusedAttributesValues(unused);
-	mesh->setVertexShaderMapping(*shaderProgram, mapping);
-	mesh->setVertices(data);
+	if(isLoaded)
+	{
+		// don't leak the previous vertices in the shared buffer
+		usedMem() -= dataSize * sizeof(float);
+		batch->free(block);
+	}
+	batch->setVertexShaderMapping(mapping);
+	block    = batch->allocate(data);
 	dataSize = data.size();
 	usedMem() += dataSize * sizeof(float);
 	data.resize(0);
@@ -428,7 +519,7 @@ void OctreeLOD::ramToVideo()
 
 Octree* OctreeLOD::newChild() const
 {
-	return new OctreeLOD(*shaderProgram, commonData, lvl + 1);
+	return new OctreeLOD(*shaderProgram, batch, commonData, lvl + 1);
 }
 
 OctreeLOD::~OctreeLOD()
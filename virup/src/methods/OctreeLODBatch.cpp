@@ -0,0 +1,310 @@
+#include "methods/OctreeLODBatch.hpp"
+
+OctreeLODBatch::OctreeLODBatch(GLShaderProgram const& shaderProgram)
+    : shaderProgram(shaderProgram)
+    , vbo(GL_ARRAY_BUFFER)
+    , nodeIds(GL_ARRAY_BUFFER)
+    , commands(GL_DRAW_INDIRECT_BUFFER)
+    , params(GL_TEXTURE_BUFFER)
+{
+	GLHandler::glf().glGenVertexArrays(1, &vao);
+	GLHandler::glf().glGenTextures(1, &paramsTex);
+}
+
+void OctreeLODBatch::setVertexShaderMapping(
+    std::vector<QPair<const char*, unsigned int>> const& mapping)
+{
+	if(mapping.size() == this->mapping.size())
+	{
+		bool same(true);
+		for(unsigned int i(0); i < mapping.size(); ++i)
+		{
+			if(qstrcmp(mapping[i].first, this->mapping[i].first) != 0
+			   || mapping[i].second != this->mapping[i].second)
+			{
+				same = false;
+				break;
+			}
+		}
+		if(same)
+		{
+			return;
+		}
+	}
+	if(capacity != 0)
+	{
+		qWarning() << "OctreeLODBatch : vertex layout changed while vertices "
+		              "are stored, previous vertices are now invalid.";
+	}
+	this->mapping = mapping;
+	stride        = 0;
+	for(auto map : mapping)
+	{
+		stride += map.second;
+	}
+	updateVertexArray();
+}
+
+OctreeLODBatch::Block
+    OctreeLODBatch::allocate(std::vector<float> const& vertices)
+{
+	Block block;
+	if(stride == 0)
+	{
+		return block;
+	}
+	block.count = vertices.size() / stride;
+	if(block.count == 0)
+	{
+		return block;
+	}
+
+	// first fit
+	auto it(freeBlocks.begin());
+	while(it != freeBlocks.end() && it->second < block.count)
+	{
+		++it;
+	}
+	if(it == freeBlocks.end())
+	{
+		grow(capacity + block.count);
+		// the last free block is now big enough
+		it = std::prev(freeBlocks.end());
+	}
+
+	block.first = it->first;
+	size_t remaining(it->second - block.count);
+	freeBlocks.erase(it);
+	if(remaining > 0)
+	{
+		freeBlocks[block.first + block.count] = remaining;
+	}
+
+	setVertices(block, vertices);
+	return block;
+}
+
+void OctreeLODBatch::setVertices(Block const& block,
+                                 std::vector<float> const& vertices)
+{
+	if(block.count == 0)
+	{
+		return;
+	}
+	vbo.setSubData(block.first * stride, &vertices[0], block.count * stride);
+}
+
+void OctreeLODBatch::free(Block const& block)
+{
+	if(block.count == 0)
+	{
+		return;
+	}
+
+	size_t first(block.first), count(block.count);
+
+	// merge with next free block
+	auto next(freeBlocks.find(first + count));
+	if(next != freeBlocks.end())
+	{
+		count += next->second;
+		freeBlocks.erase(next);
+	}
+	// merge with previous free block
+	auto prev(freeBlocks.lower_bound(first));
+	if(prev != freeBlocks.begin())
+	{
+		--prev;
+		if(prev->first + prev->second == first)
+		{
+			prev->second += count;
+			return;
+		}
+	}
+	freeBlocks[first] = count;
+}
+
+void OctreeLODBatch::clear()
+{
+	drawCommands.resize(0);
+	drawParams.resize(0);
+}
+
+void OctreeLODBatch::setSlice(unsigned int index, unsigned int count)
+{
+	sliceCount = count == 0 ? 1 : count;
+	sliceIndex = index % sliceCount;
+}
+
+void OctreeLODBatch::addDraw(Block const& block, QMatrix4x4 const& camera,
+                             QMatrix4x4 const& dustTransform,
+                             QVector3D const& campos, float alpha)
+{
+	size_t first(block.first + (block.count * sliceIndex) / sliceCount);
+	size_t end(block.first + (block.count * (sliceIndex + 1)) / sliceCount);
+	if(end <= first)
+	{
+		return;
+	}
+
+	DrawCommand command = {static_cast<GLuint>(end - first), 1,
+	                       static_cast<GLuint>(first),
+	                       static_cast<GLuint>(drawCommands.size())};
+	drawCommands.push_back(command);
+
+	// matrices are column-major on both sides
+	drawParams.insert(drawParams.end(), camera.constData(),
+	                  camera.constData() + 16);
+	drawParams.insert(drawParams.end(), dustTransform.constData(),
+	                  dustTransform.constData() + 16);
+	drawParams.push_back(campos.x());
+	drawParams.push_back(campos.y());
+	drawParams.push_back(campos.z());
+	drawParams.push_back(alpha * sliceCount);
+}
+
+void OctreeLODBatch::render()
+{
+	if(drawCommands.empty())
+	{
+		return;
+	}
+
+	commands.setData(drawCommands, GL_STREAM_DRAW);
+	params.setData(drawParams, GL_STREAM_DRAW);
+	renderIndirect(drawCommands.size());
+}
+
+void OctreeLODBatch::reserveIndirect(unsigned int drawCount)
+{
+	if(commands.getSize() < drawCount * sizeof(DrawCommand))
+	{
+		commands.resize(drawCount * sizeof(DrawCommand), GL_DYNAMIC_COPY);
+	}
+	size_t paramsSize(drawCount * paramsTexelsPerNode * 4 * sizeof(float));
+	if(params.getSize() < paramsSize)
+	{
+		params.resize(paramsSize, GL_DYNAMIC_COPY);
+	}
+}
+
+void OctreeLODBatch::renderIndirect(unsigned int drawCount)
+{
+	if(drawCount == 0)
+	{
+		return;
+	}
+
+	reserveNodeIds(drawCount);
+
+	GLHandler::bindTexture(GL_TEXTURE_BUFFER, paramsTex, GL_TEXTURE1);
+	GLHandler::glf().glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F,
+	                             params.getGLBuffer());
+	shaderProgram.setUniform("nodeparams", 1);
+
+	GLHandler::bindVertexArray(vao);
+	commands.bind();
+	GLHandler::glf_ARB_multi_draw_indirect().glMultiDrawArraysIndirect(
+	    GL_POINTS, nullptr, drawCount, 0);
+	commands.unbind();
+	GLHandler::bindVertexArray(0);
+}
+
+void OctreeLODBatch::reserveNodeIds(size_t count)
+{
+	if(nodeIdsCount >= count)
+	{
+		return;
+	}
+	nodeIdsCount = std::max(2 * nodeIdsCount, count);
+	std::vector<GLuint> ids(nodeIdsCount);
+	for(size_t i(0); i < nodeIdsCount; ++i)
+	{
+		ids[i] = i;
+	}
+	nodeIds.setData(ids);
+}
+
+void OctreeLODBatch::grow(size_t minCapacity)
+{
+	size_t newCapacity(capacity == 0 ? minCapacity : 2 * capacity);
+	while(newCapacity < minCapacity)
+	{
+		newCapacity *= 2;
+	}
+
+	size_t oldSize(capacity * stride * sizeof(float));
+	size_t newSize(newCapacity * stride * sizeof(float));
+
+	// glBufferData discards the content, keep a copy of it
+	if(oldSize != 0)
+	{
+		GLBuffer backup(GL_COPY_WRITE_BUFFER, oldSize, GL_STATIC_COPY);
+		vbo.bind(GL_COPY_READ_BUFFER);
+		backup.bind();
+		GLHandler::glf().glCopyBufferSubData(
+		    GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+
+		vbo.bind(GL_ARRAY_BUFFER);
+		vbo.resize(newSize);
+
+		backup.bind(GL_COPY_READ_BUFFER);
+		vbo.bind(GL_COPY_WRITE_BUFFER);
+		GLHandler::glf().glCopyBufferSubData(
+		    GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+		vbo.bind(GL_ARRAY_BUFFER);
+	}
+	else
+	{
+		vbo.resize(newSize);
+	}
+
+	// the buffer object stays the same, so the vertex array is still valid
+	Block added;
+	added.first = capacity;
+	added.count = newCapacity - capacity;
+	capacity    = newCapacity;
+	free(added);
+}
+
+void OctreeLODBatch::updateVertexArray()
+{
+	GLHandler::bindVertexArray(vao);
+
+	vbo.bind();
+	size_t offset = 0;
+	for(auto map : mapping)
+	{
+		GLint attrib = shaderProgram.getAttribLocationFromName(map.first);
+		if(attrib != -1)
+		{
+			GLHandler::glf().glEnableVertexAttribArray(attrib);
+			GLHandler::glf().glVertexAttribPointer(
+			    attrib, map.second, GL_FLOAT, GL_FALSE, stride * sizeof(float),
+			    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			    reinterpret_cast<void*>(offset * sizeof(float)));
+		}
+		offset += map.second;
+	}
+
+	// one instance per draw command, its base instance being the node index
+	GLint attrib = shaderProgram.getAttribLocationFromName("nodeid");
+	if(attrib != -1)
+	{
+		nodeIds.bind();
+		GLHandler::glf().glEnableVertexAttribArray(attrib);
+		GLHandler::glf().glVertexAttribIPointer(attrib, 1, GL_UNSIGNED_INT, 0,
+		                                        nullptr);
+		GLHandler::glf().glVertexAttribDivisor(attrib, 1);
+	}
+
+	GLHandler::bindVertexArray(0);
+}
+
+OctreeLODBatch::~OctreeLODBatch()
+{
+	GLHandler::forgetTexture(paramsTex);
+	GLHandler::glf().glDeleteTextures(1, &paramsTex);
+	GLHandler::forgetVertexArray(vao);
+	GLHandler::glf().glDeleteVertexArrays(1, &vao);
+}
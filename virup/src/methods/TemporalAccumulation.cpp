@@ -0,0 +1,194 @@
+#include "methods/TemporalAccumulation.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+TemporalAccumulation::TemporalAccumulation(VRHandler const& vrHandler,
+                                           unsigned int sliceCount)
+    : vrHandler(vrHandler)
+    , sliceCount(sliceCount == 0 ? 1 : sliceCount)
+    , resolveShader("temporal")
+    , shader("temporal")
+{
+	quad.setVertexShaderMapping(shader, {{"position", 2}});
+	quad.setVertices({-1.f, -1.f, 1.f, -1.f, -1.f, 1.f, 1.f, 1.f});
+}
+
+void TemporalAccumulation::render(Camera const& camera,
+                                  QMatrix4x4 const& model,
+                                  QVector3D const& campos,
+                                  TreeMethodLOD& trees)
+{
+	bool rightEye(vrHandler.isEnabled()
+	              && vrHandler.getCurrentRenderingEye() == Side::RIGHT);
+	History& history(histories.at(rightEye ? 1 : 0));
+
+	std::array<GLint, 4> viewport = {};
+	GLHandler::glf().glGetIntegerv(GL_VIEWPORT, &viewport[0]);
+	QSize size(viewport[2], viewport[3]);
+	if(!history.target || history.target->getSize() != size)
+	{
+		resize(history, size);
+	}
+
+	QMatrix4x4 skybox(GLHandler::fullSkyboxSpaceTransform());
+	float modelScale(QVector3D(model * QVector4D(1.f, 0.f, 0.f, 0.f)).length());
+
+	if(!isStill(history, history.slicing.imageSkybox * skybox.inverted(), size,
+	            modelScale, campos, camera.pixelSolidAngle(), trees))
+	{
+		drawSlice(camera, model, campos, trees, history, 0, 1);
+		resolve(history, *history.image, *history.accumulations[1],
+		        QMatrix4x4(), 1.f);
+		// drop the slices averaged for the previous image
+		history.slicing.reset(skybox);
+		history.campos     = campos;
+		history.modelScale = modelScale;
+		history.alpha      = trees.getAlpha();
+		history.darkMatter = trees.isDarkMatterEnabled();
+		history.valid      = true;
+	}
+	else
+	{
+		// running average, exact once all the slices are in
+		unsigned int slice(history.slicing.frames);
+		drawSlice(camera, model, campos, trees, history, slice, sliceCount);
+		bool complete(false);
+		QMatrix4x4 reprojection(
+		    history.slicing.addSlice(skybox, sliceCount, complete));
+		resolve(history, *history.accumulations[0],
+		        *history.accumulations[1], reprojection, 1.f / (slice + 1));
+		std::swap(history.accumulations[0], history.accumulations[1]);
+		if(complete)
+		{
+			std::swap(history.image, history.accumulations[1]);
+		}
+	}
+
+	GLHandler::beginTransparent(GL_ONE, GL_ONE);
+	shader.setUniform("reprojection",
+	                  history.slicing.imageSkybox * skybox.inverted());
+	shader.use();
+	GLHandler::useTextures({history.image.get()});
+	GLHandler::setBackfaceCulling(false);
+	quad.render(PrimitiveType::TRIANGLE_STRIP);
+	GLHandler::setBackfaceCulling(true);
+	GLHandler::endTransparent();
+}
+
+void TemporalAccumulation::resize(History& history, QSize const& size)
+{
+	GLTexture::Tex2DProperties properties(size.width(), size.height(),
+	                                      GL_RGBA32F);
+	history.target.reset(new GLFramebufferObject(properties));
+	history.image.reset(
+	    new GLTexture(properties, {GL_LINEAR, GL_CLAMP_TO_EDGE}));
+	for(auto& accumulation : history.accumulations)
+	{
+		accumulation.reset(
+		    new GLTexture(properties, {GL_LINEAR, GL_CLAMP_TO_EDGE}));
+	}
+	// nothing drawn yet
+	history.valid          = false;
+	history.slicing.frames = 0;
+}
+
+void TemporalAccumulation::Slicing::reset(QMatrix4x4 const& skybox)
+{
+	imageSkybox = skybox;
+	frames      = 0;
+}
+
+QMatrix4x4 TemporalAccumulation::Slicing::addSlice(QMatrix4x4 const& skybox,
+                                                   unsigned int sliceCount,
+                                                   bool& complete)
+{
+	// the accumulation is stored in the previous slice's view, which is
+	// irrelevant for the first slice (blended at weight 1)
+	QMatrix4x4 reprojection(accumulationSkybox * skybox.inverted());
+	accumulationSkybox = skybox;
+	++frames;
+	complete = frames >= sliceCount;
+	if(complete)
+	{
+		imageSkybox = skybox;
+		frames      = 0;
+	}
+	return reprojection;
+}
+
+void TemporalAccumulation::drawSlice(Camera const& camera,
+                                     QMatrix4x4 const& model,
+                                     QVector3D const& campos,
+                                     TreeMethodLOD& trees,
+                                     History const& history,
+                                     unsigned int slice, unsigned int slices)
+{
+	// render into our target, restore the current one afterwards
+	GLint previousTarget(0);
+	std::array<GLint, 4> viewport = {};
+	GLHandler::glf().glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING,
+	                               &previousTarget);
+	GLHandler::glf().glGetIntegerv(GL_VIEWPORT, &viewport[0]);
+
+	GLHandler::beginRendering(*history.target);
+	trees.setSlice(slice, slices);
+	trees.render(camera, model, campos);
+	trees.setSlice(0, 1);
+
+	GLHandler::glf().glBindFramebuffer(GL_FRAMEBUFFER, previousTarget);
+	GLHandler::glf().glViewport(viewport[0], viewport[1], viewport[2],
+	                            viewport[3]);
+}
+
+void TemporalAccumulation::resolve(History const& history,
+                                   GLTexture const& accumulation,
+                                   GLTexture const& previous,
+                                   QMatrix4x4 const& reprojection, float blend)
+{
+	QSize size(history.target->getSize());
+	resolveShader.setUniform("reprojection", reprojection);
+	resolveShader.setUniform("blend", blend);
+	resolveShader.setUniform("history", 2);
+	resolveShader.exec(
+	    {{&history.target->getColorAttachmentTexture(),
+	      GLComputeShader::DataAccessMode::R},
+	     {&accumulation, GLComputeShader::DataAccessMode::W},
+	     {&previous, GLComputeShader::DataAccessMode::SAMPLER}},
+	    {static_cast<unsigned int>(size.width()),
+	     static_cast<unsigned int>(size.height()), 1});
+	GLHandler::glf().glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+bool TemporalAccumulation::isStill(History const& history,
+                                   QMatrix4x4 const& reprojection,
+                                   QSize const& size, float modelScale,
+                                   QVector3D const& campos,
+                                   float pixelSolidAngle,
+                                   TreeMethodLOD const& trees) const
+{
+	if(!history.valid || history.alpha != trees.getAlpha()
+	   || history.darkMatter != trees.isDarkMatterEnabled()
+	   || history.modelScale != modelScale)
+	{
+		return false;
+	}
+
+	// reprojection only accounts for rotation ; content one meter away
+	// shouldn't move by more than a pixel
+	float pixelAngle(sqrt(pixelSolidAngle));
+	if(modelScale * campos.distanceToPoint(history.campos) > pixelAngle)
+	{
+		return false;
+	}
+
+	// screen center displacement
+	QVector4D center(reprojection * QVector4D(0.f, 0.f, 1.f, 1.f));
+	if(center.w() <= 0.f)
+	{
+		return false;
+	}
+	float shift(0.5f * QVector2D(center.x(), center.y()).length() / center.w()
+	            * size.height());
+	return shift <= maxRotation;
+}
@@ -0,0 +1,402 @@
+#include "methods/TreeMethodGPU.hpp"
+
+#include <cstring>
+
+// node flags, see octreecull.comp
+#define NODE_LEAF 1u
+#define NODE_CHILDREN_RESIDENT 2u
+
+// feedback flags, see octreecull.comp
+#define FEEDBACK_USED 1u
+#define FEEDBACK_WANTS_CHILDREN 2u
+#define FEEDBACK_MISSING 4u
+
+TreeMethodGPU::CulledTree::CulledTree(OctreeLOD& root)
+    : nodesBuffer(GL_SHADER_STORAGE_BUFFER)
+    , feedbackBuffer(GL_SHADER_STORAGE_BUFFER)
+{
+	nodes.push_back(&root);
+	parents.push_back(-1);
+	for(unsigned int i(0); i < nodes.size(); ++i)
+	{
+		children.emplace_back();
+		for(OctreeLOD* child : nodes[i]->getChildrenNodes())
+		{
+			children[i].push_back(nodes.size());
+			nodes.push_back(child);
+			parents.push_back(i);
+		}
+	}
+
+	lastUsed.resize(nodes.size(), 0);
+	isDirty.resize(nodes.size(), false);
+	for(unsigned int i(0); i < nodes.size(); ++i)
+	{
+		indices[nodes[i]] = i;
+		gpuNodes.push_back(describeNode(*this, i));
+	}
+	nodesBuffer.setData(gpuNodes, GL_DYNAMIC_DRAW);
+	feedbackBuffer.resize(nodes.size() * sizeof(GLuint), GL_DYNAMIC_COPY);
+	for(unsigned int i(0); i < feedbackLatency; ++i)
+	{
+		readbackBuffers.emplace_back(GL_COPY_WRITE_BUFFER,
+		                             nodes.size() * sizeof(GLuint),
+		                             GL_STREAM_READ);
+	}
+	root.getBatch().reserveIndirect(nodes.size());
+}
+
+TreeMethodGPU::CulledTree::~CulledTree()
+{
+	for(GLsync fence : fences)
+	{
+		if(fence != nullptr)
+		{
+			GLHandler::glf().glDeleteSync(fence);
+		}
+	}
+}
+
+TreeMethodGPU::CullUniforms::CullUniforms(GLShaderProgram const& shader)
+    : nodesCount(shader, "nodesCount")
+    , tanAngle(shader, "tanAngle")
+    , alpha(shader, "alpha")
+    , campos(shader, "campos")
+    , model(shader, "model")
+    , camera(shader, "camera")
+    , dustTransform(shader, "dusttransform")
+    , clippingPlanes(shader.getUniformLocation("clippingPlanes"))
+    , shellCenter(shader, "shellCenter")
+    , shellRadius(shader, "shellRadius")
+    , shellSide(shader, "shellSide")
+    , sliceIndex(shader, "sliceIndex")
+    , sliceCount(shader, "sliceCount")
+{
+}
+
+TreeMethodGPU::TreeMethodGPU()
+    : cullShader("octreecull")
+    , cullUniforms(cullShader)
+{
+}
+
+unsigned int TreeMethodGPU::renderTree(OctreeLOD& tree, Camera const& camera,
+                                       QMatrix4x4 const& model,
+                                       QVector3D const& campos,
+                                       bool isStarField,
+                                       QMatrix4x4 const& dustTransform)
+{
+	CulledTree& t(getCulledTree(tree));
+
+	// CPU side residency and precision enhancement
+	readFeedback(t, false);
+	// the camera leaf is never outside of the shell
+	if(shell.side <= 0)
+	{
+		OctreeLOD* cameraLeaf(
+		    tree.updateCameraLeaf(camera, campos, isStarField));
+		if(t.cameraLeaf != nullptr && t.cameraLeaf != cameraLeaf)
+		{
+			// camera isn't in this leaf anymore, reset it
+			t.cameraLeaf->updatePrecision(camera, campos, isStarField);
+			markDirty(t, t.indices.at(t.cameraLeaf));
+		}
+		markPathDirty(t, cameraLeaf);
+		t.cameraLeaf = cameraLeaf;
+	}
+	updateNodes(t);
+
+	// GPU culling and LOD selection
+	std::array<QVector4D, 4> clippingPlanes = {};
+	for(unsigned int i(0); i < clippingPlanes.size(); ++i)
+	{
+		clippingPlanes.at(i) = camera.getClippingPlane(i);
+	}
+	CullUniforms const& u(cullUniforms);
+	u.nodesCount.set(static_cast<int>(t.nodes.size()));
+	u.tanAngle.set(currentTanAngle);
+	u.alpha.set(getAlpha() * sliceCount);
+	u.campos.set(campos);
+	u.model.set(model);
+	u.camera.set(GLHandler::getCameraMatrix(model));
+	u.dustTransform.set(dustTransform);
+	cullShader.setUniform(u.clippingPlanes, clippingPlanes.size(),
+	                      &clippingPlanes[0]);
+	u.shellCenter.set(shell.center);
+	u.shellRadius.set(shell.radius);
+	u.shellSide.set(shell.side);
+	u.sliceIndex.set(static_cast<int>(sliceIndex));
+	u.sliceCount.set(static_cast<int>(sliceCount));
+
+	OctreeLODBatch& batch(tree.getBatch());
+	GLHandler::glf().glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0,
+	                                  t.nodesBuffer.getGLBuffer());
+	GLHandler::glf().glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1,
+	                                  batch.getCommandsBuffer().getGLBuffer());
+	GLHandler::glf().glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2,
+	                                  batch.getParamsBuffer().getGLBuffer());
+	GLHandler::glf().glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3,
+	                                  t.feedbackBuffer.getGLBuffer());
+	cullShader.exec({}, {static_cast<unsigned int>(t.nodes.size()), 1, 1},
+	                false);
+	GLHandler::glf().glMemoryBarrier(GL_COMMAND_BARRIER_BIT
+	                                 | GL_TEXTURE_FETCH_BARRIER_BIT
+	                                 | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	// asynchronous feedback read, see readFeedback
+	unsigned int slot(t.frame % feedbackLatency);
+	if(t.fences.at(slot) == nullptr)
+	{
+		GLHandler::glf().glBindBuffer(GL_COPY_READ_BUFFER,
+		                              t.feedbackBuffer.getGLBuffer());
+		GLHandler::glf().glBindBuffer(
+		    GL_COPY_WRITE_BUFFER, t.readbackBuffers.at(slot).getGLBuffer());
+		GLHandler::glf().glCopyBufferSubData(
+		    GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+		    t.nodes.size() * sizeof(GLuint));
+		t.fences.at(slot)
+		    = GLHandler::glf().glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	batch.renderIndirect(t.nodes.size());
+
+	if(offline)
+	{
+		// stalls, but tells right away if this rendering lacked nodes
+		readFeedback(t, true);
+	}
+	++t.frame;
+
+	// rendered points count is unknown on CPU side
+	return 0;
+}
+
+bool TreeMethodGPU::isStreaming() const
+{
+	for(auto const& pair : culledTrees)
+	{
+		if(pair.second->streaming)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void TreeMethodGPU::cleanUp()
+{
+	culledTrees.clear();
+	TreeMethodLOD::cleanUp();
+}
+
+TreeMethodGPU::CulledTree& TreeMethodGPU::getCulledTree(OctreeLOD& tree)
+{
+	auto it(culledTrees.find(&tree));
+	if(it == culledTrees.end())
+	{
+		it = culledTrees
+		         .insert(std::make_pair(
+		             &tree, std::unique_ptr<CulledTree>(new CulledTree(tree))))
+		         .first;
+	}
+	return *it->second;
+}
+
+TreeMethodGPU::GPUNode TreeMethodGPU::describeNode(CulledTree const& t,
+                                                   unsigned int i)
+{
+	OctreeLOD& node(*t.nodes[i]);
+	BBox bbox(node.getBoundingBox());
+	Vector3 translation(node.getLocalTranslation());
+	OctreeLODBatch::Block block(node.getBlock());
+
+	// same as OctreeLOD's alpha * totalDataSize / dataSize
+	float alphaFactor(node.getDataSize() == 0
+	                      ? 0.f
+	                      : static_cast<float>(node.getTotalDataSize())
+	                            / node.getDataSize());
+
+	GPUNode result = {};
+	result.mid
+	    = {{bbox.mid.x(), bbox.mid.y(), bbox.mid.z(), bbox.diameter}};
+	result.translation = {{static_cast<float>(translation[0]),
+	                       static_cast<float>(translation[1]),
+	                       static_cast<float>(translation[2]), alphaFactor}};
+	result.first  = block.first;
+	result.count  = node.isResident() ? block.count : 0;
+	result.parent = t.parents[i];
+
+	if(t.children[i].empty())
+	{
+		result.flags |= NODE_LEAF;
+	}
+	else
+	{
+		bool childrenResident(true);
+		for(unsigned int child : t.children[i])
+		{
+			childrenResident = childrenResident && t.nodes[child]->isResident();
+		}
+		if(childrenResident)
+		{
+			result.flags |= NODE_CHILDREN_RESIDENT;
+		}
+	}
+	return result;
+}
+
+void TreeMethodGPU::markDirty(CulledTree& t, unsigned int i)
+{
+	if(!t.isDirty[i])
+	{
+		t.isDirty[i] = true;
+		t.dirty.push_back(i);
+	}
+	if(t.parents[i] >= 0 && !t.isDirty[t.parents[i]])
+	{
+		t.isDirty[t.parents[i]] = true;
+		t.dirty.push_back(t.parents[i]);
+	}
+}
+
+void TreeMethodGPU::markSubtreeDirty(CulledTree& t, unsigned int i)
+{
+	markDirty(t, i);
+	for(unsigned int child : t.children[i])
+	{
+		markSubtreeDirty(t, child);
+	}
+}
+
+void TreeMethodGPU::markPathDirty(CulledTree& t, OctreeLOD const* leaf)
+{
+	if(leaf == nullptr)
+	{
+		return;
+	}
+	for(int i(t.indices.at(leaf)); i >= 0; i = t.parents[i])
+	{
+		markDirty(t, i);
+	}
+}
+
+void TreeMethodGPU::updateNodes(CulledTree& t)
+{
+	// only upload the range of nodes that changed
+	size_t firstDirty(t.nodes.size()), lastDirty(0);
+	for(unsigned int i : t.dirty)
+	{
+		t.isDirty[i] = false;
+		GPUNode node(describeNode(t, i));
+		if(memcmp(&node, &t.gpuNodes[i], sizeof(GPUNode)) != 0)
+		{
+			t.gpuNodes[i] = node;
+			firstDirty    = std::min(firstDirty, static_cast<size_t>(i));
+			lastDirty     = std::max(lastDirty, static_cast<size_t>(i));
+		}
+	}
+	t.dirty.clear();
+	if(firstDirty <= lastDirty)
+	{
+		t.nodesBuffer.setSubData(firstDirty, &t.gpuNodes[firstDirty],
+		                         lastDirty - firstDirty + 1);
+	}
+}
+
+void TreeMethodGPU::readFeedback(CulledTree& t, bool wait)
+{
+	// the slot written feedbackLatency frames ago, if the GPU is done with it
+	unsigned int slot(t.frame % feedbackLatency);
+	GLsync fence(t.fences.at(slot));
+	if(fence == nullptr)
+	{
+		return;
+	}
+	GLenum status(GL_TIMEOUT_EXPIRED);
+	do
+	{
+		status = GLHandler::glf().glClientWaitSync(
+		    fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+		    wait ? 1000000000 : 0);
+	} while(wait && status == GL_TIMEOUT_EXPIRED);
+	if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+	{
+		// never stall, try again next time
+		return;
+	}
+	GLHandler::glf().glDeleteSync(fence);
+	t.fences.at(slot) = nullptr;
+
+	GLBuffer const& readback(t.readbackBuffers.at(slot));
+	auto feedback(static_cast<GLuint const*>(readback.map(GL_READ_ONLY)));
+	if(feedback != nullptr)
+	{
+		processFeedback(t, feedback);
+	}
+	readback.unmap();
+}
+
+void TreeMethodGPU::processFeedback(CulledTree& t, GLuint const* feedback)
+{
+	++t.feedbackReads;
+
+	std::vector<unsigned int> toLoad;
+	for(unsigned int i(0); i < t.nodes.size(); ++i)
+	{
+		if((feedback[i] & FEEDBACK_USED) != 0)
+		{
+			t.lastUsed[i] = t.feedbackReads;
+		}
+		if((feedback[i] & FEEDBACK_MISSING) != 0)
+		{
+			toLoad.push_back(i);
+		}
+		if((feedback[i] & FEEDBACK_WANTS_CHILDREN) != 0)
+		{
+			toLoad.insert(toLoad.end(), t.children[i].begin(),
+			              t.children[i].end());
+		}
+	}
+
+	// unload deepest unused nodes first, never the root
+	for(unsigned int i(t.nodes.size() - 1);
+	    i > 0 && OctreeLOD::getUsedMem() > (OctreeLOD::getMemLimit() * 80) / 100;
+	    --i)
+	{
+		if(t.nodes[i]->isResident()
+		   && t.feedbackReads - t.lastUsed[i] > unloadDelay)
+		{
+			t.nodes[i]->unload();
+			markSubtreeDirty(t, i);
+		}
+	}
+
+	// nodes that can't fit in memory don't count as streaming
+	unsigned int loads(0);
+	t.streaming = false;
+	for(unsigned int i : toLoad)
+	{
+		if(OctreeLOD::getUsedMem() >= OctreeLOD::getMemLimit())
+		{
+			break;
+		}
+		if(!t.nodes[i]->isResident())
+		{
+			t.streaming = true;
+			if(loads >= maxLoadsPerFrame)
+			{
+				break;
+			}
+			t.nodes[i]->load();
+			++loads;
+		}
+		// loaded by something else (the camera leaf ancestors for example)
+		// since the last upload
+		markDirty(t, i);
+	}
+}
+
+TreeMethodGPU::~TreeMethodGPU()
+{
+	culledTrees.clear();
+}
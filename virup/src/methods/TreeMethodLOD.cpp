@@ -1,5 +1,8 @@
 #include "methods/TreeMethodLOD.hpp"
 
+#include "SettingsSnapshot.hpp"
+#include "profiling.hpp"
+
 TreeMethodLOD::TreeMethodLOD()
     : TreeMethodLOD("invsq")
 {
@@ -12,7 +15,7 @@ TreeMethodLOD::TreeMethodLOD(std::string const& shadersCommonName)
 
 TreeMethodLOD::TreeMethodLOD(std::string const& vertexShaderPath,
                              std::string const& fragmentShaderPath)
-    : Method(vertexShaderPath, fragmentShaderPath)
+    : Method(vertexShaderPath, fragmentShaderPath, {{"MULTIDRAW", ""}})
     , currentTanAngle(1.0f)
 {
 	timer.start();
@@ -225,6 +228,24 @@ void TreeMethodLOD::render(Camera const& camera, QMatrix4x4 const& model,
 		currentTanAngle = 1.2f;
 	}
 
+	if(offline)
+	{
+		currentTanAngle = 0.05f;
+	}
+
+	renderPoints(camera, model, campos, camera.pixelSolidAngle());
+
+	// volume.vert doesn't project directly, its cube would be drawn as is
+	if(hiiModel != nullptr && GLHandler::getDirectProjection() == 0)
+	{
+		hiiModel->render(camera, model, campos, dustModel);
+	}
+}
+
+void TreeMethodLOD::renderPoints(Camera const& camera, QMatrix4x4 const& model,
+                                 QVector3D const& campos,
+                                 float pixelSolidAngle)
+{
 	GLHandler::beginTransparent(GL_ONE, GL_ONE);
 	shaderProgram.setUnusedAttributesValues(
 	    {{"color", std::vector<float>{1.0f, 1.0f, 1.0f}}});
@@ -233,56 +254,58 @@ void TreeMethodLOD::render(Camera const& camera, QMatrix4x4 const& model,
 	{
 		GLHandler::useTextures({&dustModel->getTexture()});
 	}
-	GLHandler::setUpRender(shaderProgram, model);
-	shaderProgram.setUniform("pixelSolidAngle", camera.pixelSolidAngle());
+	// camera matrices are set per node by the trees
+	shaderProgram.setUniform("pixelSolidAngle", pixelSolidAngle);
 	shaderProgram.setUniform("useDust", 1.f);
+	shaderProgram.setUniform("shelloffset", shell.center - campos);
+	shaderProgram.setUniform("shellradius", shell.radius);
+	shaderProgram.setUniform("shellside", static_cast<float>(shell.side));
+	if(shell.side != 0)
+	{
+		GLHandler::setEnabled(GL_CLIP_DISTANCE1, true);
+	}
 	QMatrix4x4 dustTransform;
 	if(dustModel != nullptr)
 	{
 		dustTransform = dustModel->getPosToTexCoord();
 	}
 
+	static const Setting<QColor> gazColor("data/gazcolor");
+	static const Setting<QColor> starsColor("data/starscolor");
+	static const Setting<QColor> darkMatterColor("data/darkmattercolor");
 	unsigned int rendered = 0;
 	if(gasTree != nullptr)
 	{
 		if((gasTree->getFlags() & Octree::Flags::STORE_COLOR)
 		   == Octree::Flags::NONE)
 		{
-			setShaderColor(QSettings().value("data/gazcolor").value<QColor>());
+			setShaderColor(gazColor.get());
 		}
-		rendered += gasTree->renderAboveTanAngle(currentTanAngle, camera, model,
-		                                         campos, 100000000, false,
-		                                         getAlpha(), dustTransform);
+		rendered += renderTree(*gasTree, camera, model, campos, false,
+		                       dustTransform);
 	}
 	if(starsTree != nullptr)
 	{
 		if((starsTree->getFlags() & Octree::Flags::STORE_COLOR)
 		   == Octree::Flags::NONE)
 		{
-			setShaderColor(
-			    QSettings().value("data/starscolor").value<QColor>());
+			setShaderColor(starsColor.get());
 		}
-		rendered += starsTree->renderAboveTanAngle(
-		    currentTanAngle, camera, model, campos, 100000000, true, getAlpha(),
-		    dustTransform);
+		rendered += renderTree(*starsTree, camera, model, campos, true,
+		                       dustTransform);
 	}
 	if(darkMatterTree != nullptr && showdm)
 	{
 		if((darkMatterTree->getFlags() & Octree::Flags::STORE_COLOR)
 		   == Octree::Flags::NONE)
 		{
-			setShaderColor(
-			    QSettings().value("data/darkmattercolor").value<QColor>());
+			setShaderColor(darkMatterColor.get());
 		}
-		rendered += darkMatterTree->renderAboveTanAngle(
-		    currentTanAngle, camera, model, campos, 100000000, false,
-		    getAlpha(), dustTransform);
+		rendered += renderTree(*darkMatterTree, camera, model, campos, false,
+		                       dustTransform);
 	}
+	GLHandler::setEnabled(GL_CLIP_DISTANCE1, false);
 	GLHandler::endTransparent();
-	if(hiiModel != nullptr)
-	{
-		hiiModel->render(camera, model, campos, dustModel);
-	}
 
 	(void) rendered;
 
@@ -293,6 +316,25 @@ void TreeMethodLOD::render(Camera const& camera, QMatrix4x4 const& model,
 	          << "\r" << std::fflush(stdout);*/
 }
 
+void TreeMethodLOD::setSlice(unsigned int index, unsigned int count)
+{
+	sliceCount = count == 0 ? 1 : count;
+	sliceIndex = index % sliceCount;
+}
+
+unsigned int TreeMethodLOD::renderTree(OctreeLOD& tree, Camera const& camera,
+                                       QMatrix4x4 const& model,
+                                       QVector3D const& campos,
+                                       bool isStarField,
+                                       QMatrix4x4 const& dustTransform)
+{
+	CPUProfiler::Zone zone("octree traversal");
+	tree.getBatch().setSlice(sliceIndex, sliceCount);
+	return tree.renderAboveTanAngle(currentTanAngle, camera, model, campos,
+	                                100000000, isStarField, getAlpha(),
+	                                dustTransform, shell);
+}
+
 void TreeMethodLOD::cleanUp()
 {
 	if(gasTree != nullptr)
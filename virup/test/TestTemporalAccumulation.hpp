@@ -0,0 +1,78 @@
+/*
+    Copyright (C) 2020 Florian Cabot <florian.cabot@hotmail.fr>
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+
+#ifndef TESTTEMPORALACCUMULATION_H
+#define TESTTEMPORALACCUMULATION_H
+
+#include <QtTest>
+
+#include "methods/TemporalAccumulation.hpp"
+
+class TestTemporalAccumulation : public QObject
+{
+	Q_OBJECT
+  private slots:
+	void rotatingCamera()
+	{
+		QMatrix4x4 proj;
+		proj.perspective(90.f, 1.f, 0.1f, 10.f);
+		// half a degree per frame
+		auto skybox = [&proj](unsigned int frame) {
+			QMatrix4x4 result(proj);
+			result.rotate(0.5f * frame, 0.f, 1.f, 0.f);
+			return result;
+		};
+		auto ndc = [](QVector4D const& clip) {
+			return clip.toVector3DAffine();
+		};
+		QVector4D star(0.3f, 0.1f, -1.f, 1.f);
+
+		unsigned int const sliceCount(4);
+		TemporalAccumulation::Slicing slicing;
+		slicing.reset(skybox(0));
+		// where the accumulation holds the star
+		QVector3D stored;
+		for(unsigned int frame(1); frame <= 3 * sliceCount; ++frame)
+		{
+			unsigned int slice(slicing.frames);
+			QVector4D current(skybox(frame) * star);
+			bool complete(false);
+			QMatrix4x4 reprojection(
+			    slicing.addSlice(skybox(frame), sliceCount, complete));
+			if(slice != 0)
+			{
+				// the slice's star is blended with the accumulated one
+				QVERIFY((ndc(reprojection * current) - stored).length()
+				        < 1e-4f);
+			}
+			stored = ndc(current);
+
+			QCOMPARE(complete, slice == sliceCount - 1);
+			if(complete)
+			{
+				// the image is shown reprojected to the next frame's view
+				QMatrix4x4 next(skybox(frame + 1));
+				QVector4D shown(slicing.imageSkybox * next.inverted()
+				                * (next * star));
+				QVERIFY((ndc(shown) - stored).length() < 1e-4f);
+			}
+		}
+	}
+};
+
+#endif // TESTTEMPORALACCUMULATION_H
@@ -20,11 +20,13 @@
 #define TEST_MAIN_H
 
 #include "TestExample.hpp"
+#include "TestTemporalAccumulation.hpp"
 
 template <typename Functor>
 void test_main(Functor assert)
 {
 	assert(new TestExample());
+	assert(new TestTemporalAccumulation());
 }
 
 #endif // TEST_MAIN_H